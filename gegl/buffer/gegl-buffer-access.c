@@ -1282,14 +1282,24 @@ gegl_buffer_copy (GeglBuffer          *src,
 
                 dst_tile = gegl_tile_dup (src_tile);
                 dst_tile->tile_storage = (void*)storage;
-
-                /* XXX: this call should only be neccesary as long as GIMP
-                 *      is dropping tile caches behind our back
+                dst_tile->x = dtx;
+                dst_tile->y = dty;
+                dst_tile->z = 0;
+
+                /* the shared data only gets written to the backend of dst
+                 * when the cache evicts the tile, until then a copied tile
+                 * costs nothing but the GeglTile itself. Either side
+                 * unshares the data when locking its tile for writing.
                  */
-                if(gegl_tile_source_set_tile ((GeglTileSource*)dst, dtx, dty, 0, 
-                                           dst_tile));
+                dst_tile->rev++;
                 gegl_tile_handler_cache_insert (cache, dst_tile, dtx, dty, 0);
 
+                /* other processes only see what is in the backend */
+                if (gegl_buffer_is_shared (dst))
+                  gegl_tile_store (dst_tile);
+
+                gegl_tile_void_pyramid (dst_tile);
+
                 gegl_tile_unref (src_tile);
                 gegl_tile_unref (dst_tile);
 #else
@@ -1369,21 +1379,19 @@ gegl_buffer_copy (GeglBuffer          *src,
     }
 }
 
+/* fills dst_rect with pixel, or with zeros when pixel is NULL, one pixel at
+ * a time
+ */
 static void
-gegl_buffer_clear2 (GeglBuffer          *dst,
-                    const GeglRectangle *dst_rect)
+gegl_buffer_fill2 (GeglBuffer          *dst,
+                   const GeglRectangle *dst_rect,
+                   const guchar        *pixel)
 {
   GeglBufferIterator *i;
   gint                pxsize;
 
-  g_return_if_fail (GEGL_IS_BUFFER (dst));
-
-  if (!dst_rect)
-    {
-      dst_rect = gegl_buffer_get_extent (dst);
-    }
-  if (dst_rect->width == 0 ||
-      dst_rect->height == 0)
+  if (dst_rect->width <= 0 ||
+      dst_rect->height <= 0)
     return;
 
   pxsize = babl_format_get_bytes_per_pixel (dst->soft_format);
@@ -1391,119 +1399,181 @@ gegl_buffer_clear2 (GeglBuffer          *dst,
   if (gegl_cl_is_accelerated ())
     gegl_buffer_cl_cache_invalidate (dst, dst_rect);
 
-  /* FIXME: this can be even further optimized by special casing it so
-   * that fully voided tiles are dropped.
-   */
   i = gegl_buffer_iterator_new (dst, dst_rect, 0, dst->soft_format,
-                                GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
+                                GEGL_BUFFER_WRITE | GEGL_BUFFER_STRIDED,
+                                GEGL_ABYSS_NONE);
   while (gegl_buffer_iterator_next (i))
     {
-      memset (((guchar*)(i->data[0])), 0, i->length * pxsize);
+      gint row;
+
+      for (row = 0; row < i->roi[0].height; row++)
+        {
+          guchar *data = (guchar*)(i->data[0]) + row * i->rowstride[0];
+
+          if (pixel)
+            {
+              gint j;
+              for (j = 0; j < i->roi[0].width; j++)
+                memcpy (data + pxsize * j, pixel, pxsize);
+            }
+          else
+            {
+              memset (data, 0, i->roi[0].width * pxsize);
+            }
+        }
     }
 }
 
-void
-gegl_buffer_clear (GeglBuffer          *dst,
-                   const GeglRectangle *dst_rect)
+/* fills dst_rect with pixel (zeros when NULL). All the tiles fully covered
+ * by dst_rect share the data of a single uniform tile, which only gets
+ * copied when one of them is locked for writing, the partially covered
+ * tiles around them are filled by gegl_buffer_fill2 ().
+ */
+static void
+gegl_buffer_fill (GeglBuffer          *dst,
+                  const GeglRectangle *dst_rect,
+                  const guchar        *pixel)
 {
-  g_return_if_fail (GEGL_IS_BUFFER (dst));
+  GeglRectangle cow_rect;
+  GeglRectangle top, bottom, left, right;
+  gint          tile_width  = dst->tile_width;
+  gint          tile_height = dst->tile_height;
 
-  if (!dst_rect)
-    {
-      dst_rect = gegl_buffer_get_extent (dst);
-    }
+  if (dst_rect->width <= 0 ||
+      dst_rect->height <= 0)
+    return;
 
-  goto nocow; // cow for clearing is currently broken, go to nocow case
-  if (!g_object_get_data (G_OBJECT (dst), "is-linear"))
+  if (g_object_get_data (G_OBJECT (dst), "is-linear"))
     {
-      gint tile_width = dst->tile_width;
-      gint tile_height = dst->tile_height;
+      gegl_buffer_fill2 (dst, dst_rect, pixel);
+      return;
+    }
 
-      {
-        GeglRectangle cow_rect = *dst_rect;
+  /* only whole tiles within the abyss can be replaced, they might be
+   * shared with the buffer this one is a sub-buffer of
+   */
+  gegl_rectangle_intersect (&cow_rect, dst_rect, &dst->abyss);
 
-        /* adjust origin until we match the start of tile alignment */
-        while ( (cow_rect.x + dst->shift_x) % tile_width)
-          {
-            cow_rect.x ++;
-            cow_rect.width --;
-          }
-        while ( (cow_rect.y + dst->shift_y) % tile_height)
-          {
-            cow_rect.y ++;
-            cow_rect.height --;
-          }
-        /* adjust size of rect to match multiple of tiles */
+  /* adjust origin until we match the start of tile alignment */
+  while ( (cow_rect.x + dst->shift_x) % tile_width && cow_rect.width > 0)
+    {
+      cow_rect.x ++;
+      cow_rect.width --;
+    }
+  while ( (cow_rect.y + dst->shift_y) % tile_height && cow_rect.height > 0)
+    {
+      cow_rect.y ++;
+      cow_rect.height --;
+    }
+  /* adjust size of rect to match multiple of tiles */
+  cow_rect.width  = cow_rect.width  - (cow_rect.width  % tile_width);
+  cow_rect.height = cow_rect.height - (cow_rect.height % tile_height);
 
-        cow_rect.width  = cow_rect.width  - (cow_rect.width  % tile_width);
-        cow_rect.height = cow_rect.height - (cow_rect.height % tile_height);
+  if (cow_rect.width == 0 || cow_rect.height == 0)
+    {
+      gegl_buffer_fill2 (dst, dst_rect, pixel);
+      return;
+    }
 
+  {
+    GeglTileHandlerChain *storage;
+    GeglTileHandlerCache *cache;
+    GeglTile             *uniform_tile;
+    gint                  pxsize;
+    gint                  dst_x, dst_y;
 
-        g_assert (cow_rect.width >= 0);
-        g_assert (cow_rect.height >= 0);
+    storage = GEGL_TILE_HANDLER_CHAIN (dst->tile_storage);
+    cache = GEGL_TILE_HANDLER_CACHE (gegl_tile_handler_chain_get_first (storage, GEGL_TYPE_TILE_HANDLER_CACHE));
+    pxsize = babl_format_get_bytes_per_pixel (dst->soft_format);
 
-        {
-          GeglRectangle top, bottom, left, right;
-          
-          /* iterate over rectangle that can be cow copied, duplicating
-           * one and one tile
-           */
-          {
-            /* first we do a dumb copy,. but with fetched tiles */
+    if (gegl_cl_is_accelerated ())
+      gegl_buffer_cl_cache_invalidate (dst, &cow_rect);
 
-            gint dst_x, dst_y;
+    /* the hot tile might be one of the tiles being replaced */
+    _gegl_buffer_drop_hot_tile (dst);
 
-            for (dst_y = cow_rect.y + dst->shift_y; dst_y < cow_rect.y + dst->shift_y + cow_rect.height; dst_y += tile_height)
-            for (dst_x = cow_rect.x + dst->shift_x; dst_x < cow_rect.x + dst->shift_x + cow_rect.width; dst_x += tile_width)
-              {
-                gint dtx, dty;
+    uniform_tile = gegl_tile_new (dst->tile_storage->tile_size);
+    if (pixel)
+      {
+        gint j;
+        for (j = 0; j < tile_width * tile_height; j++)
+          memcpy (uniform_tile->data + pxsize * j, pixel, pxsize);
+      }
+    else
+      {
+        memset (uniform_tile->data, 0, uniform_tile->size);
+      }
+    uniform_tile->is_uniform = TRUE;
 
-                dtx = gegl_tile_indice (dst_x, tile_width);
-                dty = gegl_tile_indice (dst_y, tile_height);
+    for (dst_y = cow_rect.y + dst->shift_y; dst_y < cow_rect.y + dst->shift_y + cow_rect.height; dst_y += tile_height)
+    for (dst_x = cow_rect.x + dst->shift_x; dst_x < cow_rect.x + dst->shift_x + cow_rect.width; dst_x += tile_width)
+      {
+        GeglTile *dst_tile;
+        gint      dtx, dty;
 
-                if(gegl_tile_source_void ((GeglTileSource*)dst, dtx, dty, 0));
-              }
-          }
+        dtx = gegl_tile_indice (dst_x, tile_width);
+        dty = gegl_tile_indice (dst_y, tile_height);
 
-          top = *dst_rect;
-          top.height = (cow_rect.y - dst_rect->y);
+        dst_tile = gegl_tile_dup (uniform_tile);
+        dst_tile->tile_storage = (void*)storage;
+        dst_tile->x = dtx;
+        dst_tile->y = dty;
+        dst_tile->z = 0;
 
+        /* like the tiles shared by gegl_buffer_copy (), the tile only
+         * reaches the backend when evicted from the cache
+         */
+        dst_tile->rev++;
+        gegl_tile_handler_cache_insert (cache, dst_tile, dtx, dty, 0);
 
-          left = *dst_rect;
-          left.y = cow_rect.y;
-          left.height = cow_rect.height;
-          left.width = (cow_rect.x - dst_rect->x);
+        if (gegl_buffer_is_shared (dst))
+          gegl_tile_store (dst_tile);
 
-          bottom = *dst_rect;
-          bottom.y = (cow_rect.y + cow_rect.height);
-          bottom.height = (dst_rect->y + dst_rect->height) -
-                          (cow_rect.y  + cow_rect.height);
+        gegl_tile_void_pyramid (dst_tile);
+        gegl_tile_unref (dst_tile);
+      }
 
-          if (bottom.height < 0)
-            bottom.height = 0;
+    gegl_tile_unref (uniform_tile);
+  }
 
-          right  =  *dst_rect;
-          right.x = (cow_rect.x + cow_rect.width);
-          right.width = (dst_rect->x + dst_rect->width) -
-                          (cow_rect.x  + cow_rect.width);
-          right.y = cow_rect.y;
-          right.height = cow_rect.height;
+  top = *dst_rect;
+  top.height = (cow_rect.y - dst_rect->y);
+
+  left = *dst_rect;
+  left.y = cow_rect.y;
+  left.height = cow_rect.height;
+  left.width = (cow_rect.x - dst_rect->x);
+
+  bottom = *dst_rect;
+  bottom.y = (cow_rect.y + cow_rect.height);
+  bottom.height = (dst_rect->y + dst_rect->height) -
+                  (cow_rect.y  + cow_rect.height);
+
+  right  =  *dst_rect;
+  right.x = (cow_rect.x + cow_rect.width);
+  right.width = (dst_rect->x + dst_rect->width) -
+                (cow_rect.x  + cow_rect.width);
+  right.y = cow_rect.y;
+  right.height = cow_rect.height;
+
+  gegl_buffer_fill2 (dst, &top, pixel);
+  gegl_buffer_fill2 (dst, &bottom, pixel);
+  gegl_buffer_fill2 (dst, &left, pixel);
+  gegl_buffer_fill2 (dst, &right, pixel);
+}
 
-          if (right.width < 0)
-            right.width = 0;
+void
+gegl_buffer_clear (GeglBuffer          *dst,
+                   const GeglRectangle *dst_rect)
+{
+  g_return_if_fail (GEGL_IS_BUFFER (dst));
 
-          if (top.height)     gegl_buffer_clear2 (dst, &top);
-          if (bottom.height)  gegl_buffer_clear2 (dst, &bottom);
-          if (left.width)     gegl_buffer_clear2 (dst, &left);
-          if (right.width)    gegl_buffer_clear2 (dst, &right);
-        }
-      }
-    }
-  else
+  if (!dst_rect)
     {
-nocow:
-      gegl_buffer_clear2 (dst, dst_rect);
+      dst_rect = gegl_buffer_get_extent (dst);
     }
+
+  gegl_buffer_fill (dst, dst_rect, NULL);
 }
 
 void
@@ -1550,9 +1620,7 @@ gegl_buffer_set_color (GeglBuffer          *dst,
                        const GeglRectangle *dst_rect,
                        GeglColor           *color)
 {
-  GeglBufferIterator *i;
-  gchar               buf[128];
-  gint                pxsize;
+  guchar buf[128];
 
   g_return_if_fail (GEGL_IS_BUFFER (dst));
   g_return_if_fail (color);
@@ -1563,23 +1631,8 @@ gegl_buffer_set_color (GeglBuffer          *dst,
     {
       dst_rect = gegl_buffer_get_extent (dst);
     }
-  if (dst_rect->width == 0 ||
-      dst_rect->height == 0)
-    return;
-
-  pxsize = babl_format_get_bytes_per_pixel (dst->soft_format);
 
-  /* FIXME: this can be even further optimized by special casing it so
-   * that fully filled tiles are shared.
-   */
-  i = gegl_buffer_iterator_new (dst, dst_rect, 0, dst->soft_format, 
-                                GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
-  while (gegl_buffer_iterator_next (i))
-    {
-      int j;
-      for (j = 0; j < i->length; j++)
-        memcpy (((guchar*)(i->data[0])) + pxsize * j, buf, pxsize);
-    }
+  gegl_buffer_fill (dst, dst_rect, buf);
 }
 
 GeglBuffer *
@@ -1589,7 +1642,16 @@ gegl_buffer_dup (GeglBuffer *buffer)
 
   g_return_val_if_fail (GEGL_IS_BUFFER (buffer), NULL);
 
-  new_buffer = gegl_buffer_new (gegl_buffer_get_extent (buffer), buffer->soft_format);
+  /* use the tile grid of buffer, to let gegl_buffer_copy share the tiles */
+  new_buffer = g_object_new (GEGL_TYPE_BUFFER,
+                             "x",           buffer->extent.x,
+                             "y",           buffer->extent.y,
+                             "width",       buffer->extent.width,
+                             "height",      buffer->extent.height,
+                             "format",      buffer->soft_format,
+                             "tile-width",  buffer->tile_storage->tile_width,
+                             "tile-height", buffer->tile_storage->tile_height,
+                             NULL);
   gegl_buffer_copy (buffer, gegl_buffer_get_extent (buffer),
                     new_buffer, gegl_buffer_get_extent (buffer));
   return new_buffer;
@@ -23,6 +23,7 @@
 
 #include <glib-object.h>
 #include <glib/gprintf.h>
+#include <gio/gio.h>
 
 #include "gegl.h"
 #include "gegl-types-internal.h"
@@ -31,6 +32,7 @@
 #include "gegl-buffer-private.h"
 #include "gegl-tile-storage.h"
 #include "gegl-utils.h"
+#include "gegl-config.h"
 
 #include "gegl-buffer-cl-cache.h"
 
@@ -56,6 +58,7 @@ typedef struct GeglBufferTileIterator
                             */
   gboolean       same_format;
   gint           level;
+  gboolean       strided;  /* partial tiles are accessed in place too */
 } GeglBufferTileIterator;
 
 #define GEGL_BUFFER_SCAN_COMPATIBLE   128   /* should be integrated into enum */
@@ -69,6 +72,8 @@ typedef struct GeglBufferIterators
   gint          length;             /* length of current data in pixels */
   gpointer      data[GEGL_BUFFER_MAX_ITERATORS];
   GeglRectangle roi[GEGL_BUFFER_MAX_ITERATORS]; /* roi of the current data */
+  gint          level;
+  gint          rowstride[GEGL_BUFFER_MAX_ITERATORS]; /* of the current data */
 
   /* the following is private: */
   gint           iterators;
@@ -81,6 +86,7 @@ typedef struct GeglBufferIterators
   guint          flags      [GEGL_BUFFER_MAX_ITERATORS];
   gpointer       buf        [GEGL_BUFFER_MAX_ITERATORS]; /* no idea */
   GeglBufferTileIterator   i[GEGL_BUFFER_MAX_ITERATORS];
+  gboolean       uniform    [GEGL_BUFFER_MAX_ITERATORS]; /* data of the current chunk is one repeated pixel */
 } GeglBufferIterators;
 
 
@@ -166,7 +172,7 @@ gulp:
   /* unref previously held tile */
   if (i->tile)
     {
-      if (i->write && i->subrect.width == tile_width && i->same_format)
+      if (i->write && (i->subrect.width == tile_width || i->strided) && i->same_format)
         {
           gegl_tile_unlock (i->tile);
         }
@@ -198,7 +204,7 @@ gulp:
                                         gegl_tile_indice (tiledx, tile_width),
                                         gegl_tile_indice (tiledy, tile_height),
                                         0);
-         if (i->write && i->subrect.width == tile_width && i->same_format)
+         if (i->write && (i->subrect.width == tile_width || i->strided) && i->same_format)
            {
              gegl_tile_lock (i->tile);
            }
@@ -298,6 +304,7 @@ gegl_buffer_iterator_add (GeglBufferIterator  *iterator,
     {
       i->flags[self] |= GEGL_BUFFER_SCAN_COMPATIBLE;
       gegl_buffer_tile_iterator_init (&i->i[self], i->buffer[self], i->rect[self], ((i->flags[self] & GEGL_BUFFER_WRITE) != 0), i->format[self], iterator->level);
+      i->i[self].strided = (i->flags[self] & GEGL_BUFFER_STRIDED) != 0;
     }
   else
     {
@@ -310,6 +317,7 @@ gegl_buffer_iterator_add (GeglBufferIterator  *iterator,
         {
           i->flags[self] |= GEGL_BUFFER_SCAN_COMPATIBLE;
           gegl_buffer_tile_iterator_init (&i->i[self], i->buffer[self], i->rect[self], ((i->flags[self] & GEGL_BUFFER_WRITE) != 0), i->format[self], iterator->level);
+          i->i[self].strided = (i->flags[self] & GEGL_BUFFER_STRIDED) != 0;
         }
     }
 
@@ -383,6 +391,21 @@ static void iterator_buf_pool_release (gpointer buf)
   g_static_mutex_unlock (&pool_mutex);
 }
 
+/* whether the data of the current chunk of iterator no is accessed in place,
+ * chunks of scan compatible iterators never span more than one tile. Tiles
+ * written in place have to be locked by the tile iterator.
+ */
+static gboolean
+direct_access (GeglBufferIterators *i,
+               gint                 no)
+{
+  return (i->flags[no] & GEGL_BUFFER_SCAN_COMPATIBLE) &&
+         (i->flags[no] & GEGL_BUFFER_FORMAT_COMPATIBLE) &&
+         (!(i->flags[no] & GEGL_BUFFER_WRITE) || i->i[no].same_format) &&
+         (i->roi[no].width == i->i[no].buffer->tile_storage->tile_width ||
+          (i->flags[no] & GEGL_BUFFER_STRIDED));
+}
+
 static void ensure_buf (GeglBufferIterators *i, gint no)
 {
   if (i->buf[no]==NULL)
@@ -466,9 +489,7 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
           if (i->flags[no] & GEGL_BUFFER_WRITE)
             {
 
-              if (i->flags[no] & GEGL_BUFFER_SCAN_COMPATIBLE &&
-                  i->flags[no] & GEGL_BUFFER_FORMAT_COMPATIBLE &&
-                  i->roi[no].width == i->i[no].buffer->tile_storage->tile_width && (i->flags[no] & GEGL_BUFFER_FORMAT_COMPATIBLE))
+              if (direct_access (i, no))
                 { /* direct access, don't need to do anything */
 #if DEBUG_DIRECT
                    direct_write += i->roi[no].width * i->roi[no].height;
@@ -504,6 +525,12 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
             }
           i->roi[no] = i->i[no].roi2;
 
+          /* the chunk never spans more than the current tile */
+          i->uniform[no] = res &&
+                           !(i->flags[no] & GEGL_BUFFER_WRITE) &&
+                           i->i[no].tile &&
+                           i->i[no].tile->is_uniform;
+
           /* since they were scan compatible this should be true */
           if (res != result)
             {
@@ -511,12 +538,11 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
             }
           g_assert (res == result);
 
-          if ((i->flags[no] & GEGL_BUFFER_FORMAT_COMPATIBLE) &&
-              i->roi[no].width == i->i[no].buffer->tile_storage->tile_width
-           )
+          if (direct_access (i, no))
             {
               /* direct access */
               i->data[no]=i->i[no].sub_data;
+              i->rowstride[no]=i->i[no].rowstride;
 #if DEBUG_DIRECT
               direct_read += i->roi[no].width * i->roi[no].height;
 #endif
@@ -531,6 +557,8 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
                 }
 
               i->data[no]=i->buf[no];
+              i->rowstride[no]=i->roi[no].width *
+                               babl_format_get_bytes_per_pixel (i->format[no]);
 #if DEBUG_DIRECT
               in_direct_read += i->roi[no].width * i->roi[no].height;
 #endif
@@ -542,6 +570,7 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
           i->roi[no] = i->roi[0];
           i->roi[no].x += (i->rect[no].x-i->rect[0].x);
           i->roi[no].y += (i->rect[no].y-i->rect[0].y);
+          i->uniform[no] = FALSE;
 
           ensure_buf (i, no);
 
@@ -550,6 +579,8 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
               gegl_buffer_get_unlocked (i->buffer[no], 1.0, &(i->roi[no]), i->format[no], i->buf[no], GEGL_AUTO_ROWSTRIDE);
             }
           i->data[no]=i->buf[no];
+          i->rowstride[no]=i->roi[no].width *
+                           babl_format_get_bytes_per_pixel (i->format[no]);
 
 #if DEBUG_DIRECT
           in_direct_read += i->roi[no].width * i->roi[no].height;
@@ -566,6 +597,17 @@ gegl_buffer_iterator_next (GeglBufferIterator *iterator)
   return result;
 }
 
+gboolean
+gegl_buffer_iterator_is_uniform (GeglBufferIterator *iterator,
+                                 gint                index)
+{
+  GeglBufferIterators *i = (gpointer)iterator;
+
+  g_return_val_if_fail (index >= 0 && index < i->iterators, FALSE);
+
+  return i->uniform[index];
+}
+
 GeglBufferIterator *
 gegl_buffer_iterator_new (GeglBuffer          *buffer,
                           const GeglRectangle *roi,
@@ -582,3 +624,315 @@ gegl_buffer_iterator_new (GeglBuffer          *buffer,
   return i;
 }
 
+typedef struct GeglBufferIteratorJob
+{
+  GeglBufferIterators    *iterator;  /* the iteration to perform, never
+                                      * iterated itself
+                                      */
+  GeglBufferIteratorFunc  func;
+  gpointer                user_data;
+  GCancellable           *cancellable;
+
+  gint                    tile_x;    /* the first tile of buffer 0 */
+  gint                    tile_y;
+  gint                    cols_per_cell;
+  gint                    cells_per_row;
+  gint                    n_cells;
+  volatile gint           next_cell;
+
+  GMutex                 *mutex;
+  GCond                  *cond;
+  gint                    done_cells;
+  volatile gint           ref_count;
+} GeglBufferIteratorJob;
+
+static GThreadPool  *iterator_pool       = NULL;
+static GStaticMutex  iterator_pool_mutex = G_STATIC_MUTEX_INIT;
+
+static GStaticPrivate thread_cancellable = G_STATIC_PRIVATE_INIT;
+static GStaticPrivate thread_is_worker   = G_STATIC_PRIVATE_INIT;
+
+GCancellable *
+gegl_buffer_thread_get_cancellable (void)
+{
+  return g_static_private_get (&thread_cancellable);
+}
+
+GCancellable *
+gegl_buffer_thread_set_cancellable (GCancellable *cancellable)
+{
+  GCancellable *previous = g_static_private_get (&thread_cancellable);
+
+  g_static_private_set (&thread_cancellable, cancellable, NULL);
+
+  return previous;
+}
+
+gboolean
+gegl_buffer_thread_is_worker (void)
+{
+  return g_static_private_get (&thread_is_worker) != NULL;
+}
+
+gboolean
+gegl_buffer_thread_set_worker (gboolean is_worker)
+{
+  gboolean previous = g_static_private_get (&thread_is_worker) != NULL;
+
+  g_static_private_set (&thread_is_worker,
+                        is_worker ? GINT_TO_POINTER (TRUE) : NULL, NULL);
+
+  return previous;
+}
+
+static void
+iterator_job_unref (GeglBufferIteratorJob *job)
+{
+  GeglBufferIterators *i = job->iterator;
+  gint                 no;
+
+  if (!g_atomic_int_dec_and_test (&job->ref_count))
+    return;
+
+  for (no = 0; no < i->iterators; no++)
+    g_object_unref (i->buffer[no]);
+  g_slice_free (GeglBufferIterators, i);
+
+  g_mutex_free (job->mutex);
+  g_cond_free (job->cond);
+  if (job->cancellable)
+    g_object_unref (job->cancellable);
+  g_slice_free (GeglBufferIteratorJob, job);
+}
+
+/* iterates to the end, once cancellable is cancelled the chunks left are
+ * still walked, so that the buffers are left as gegl_buffer_iterator_next()
+ * leaves them, but no longer processed
+ */
+static void
+iterator_run (GeglBufferIterator     *iterator,
+              GeglBufferIteratorFunc  func,
+              gpointer                user_data,
+              GCancellable           *cancellable)
+{
+  while (gegl_buffer_iterator_next (iterator))
+    if (!g_cancellable_is_cancelled (cancellable))
+      func (iterator, user_data);
+}
+
+/* iterates the part of the iteration that lies within one cell, a band of
+ * tiles of buffer 0
+ */
+static void
+iterator_job_run_cell (GeglBufferIteratorJob *job,
+                       gint                   cell)
+{
+  GeglBufferIterators *i           = job->iterator;
+  GeglBuffer          *buffer      = i->buffer[0];
+  gint                 tile_width  = buffer->tile_storage->tile_width;
+  gint                 tile_height = buffer->tile_storage->tile_height;
+  gint                 row         = cell / job->cells_per_row;
+  gint                 col         = cell % job->cells_per_row;
+  GeglRectangle        tiles;
+  GeglRectangle        rect;
+  GeglBufferIterator  *iterator;
+  gint                 no;
+
+  tiles.x      = (job->tile_x + col * job->cols_per_cell) * tile_width -
+                 buffer->shift_x;
+  tiles.y      = (job->tile_y + row) * tile_height - buffer->shift_y;
+  tiles.width  = job->cols_per_cell * tile_width;
+  tiles.height = tile_height;
+
+  gegl_rectangle_intersect (&rect, &tiles, &i->rect[0]);
+
+  iterator = gegl_buffer_iterator_new (buffer, &rect, i->level, i->format[0],
+                                       i->flags[0] & (GEGL_BUFFER_READWRITE | GEGL_BUFFER_STRIDED),
+                                       GEGL_ABYSS_NONE);
+  for (no = 1; no < i->iterators; no++)
+    {
+      GeglRectangle rect_no = rect;
+
+      rect_no.x += i->rect[no].x - i->rect[0].x;
+      rect_no.y += i->rect[no].y - i->rect[0].y;
+      gegl_buffer_iterator_add (iterator, i->buffer[no], &rect_no, i->level,
+                                i->format[no],
+                                i->flags[no] & (GEGL_BUFFER_READWRITE | GEGL_BUFFER_STRIDED),
+                                GEGL_ABYSS_NONE);
+    }
+
+  iterator_run (iterator, job->func, job->user_data, job->cancellable);
+}
+
+static void
+iterator_job_work (GeglBufferIteratorJob *job)
+{
+  gboolean was_worker;
+  gint     cell;
+
+  /* a foreach in func iterates its part on this thread alone */
+  was_worker = gegl_buffer_thread_set_worker (TRUE);
+
+  while ((cell = g_atomic_int_exchange_and_add (&job->next_cell, 1)) <
+         job->n_cells)
+    {
+      /* cells not started when cancelled are not iterated at all */
+      if (!g_cancellable_is_cancelled (job->cancellable))
+        iterator_job_run_cell (job, cell);
+
+      g_mutex_lock (job->mutex);
+      job->done_cells++;
+      if (job->done_cells == job->n_cells)
+        g_cond_signal (job->cond);
+      g_mutex_unlock (job->mutex);
+    }
+
+  gegl_buffer_thread_set_worker (was_worker);
+}
+
+static void
+iterator_pool_func (gpointer data,
+                    gpointer unused)
+{
+  GeglBufferIteratorJob *job = data;
+  GCancellable          *previous;
+
+  previous = gegl_buffer_thread_set_cancellable (job->cancellable);
+
+  /* by the time a worker gets here all cells might have been taken by the
+   * caller and other workers, which is why the job is reference counted
+   */
+  iterator_job_work (job);
+
+  gegl_buffer_thread_set_cancellable (previous);
+  iterator_job_unref (job);
+}
+
+/* whether chunks of different tiles of buffer 0 can be processed at the
+ * same time without two threads touching the same tile for writing
+ */
+static gboolean
+iterator_can_split (GeglBufferIterators *i)
+{
+  gint a, b;
+
+  if (i->level != 0)
+    return FALSE;
+
+  for (a = 1; a < i->iterators; a++)
+    if ((i->flags[a] & GEGL_BUFFER_WRITE) &&
+        !(i->flags[a] & GEGL_BUFFER_SCAN_COMPATIBLE))
+      return FALSE;
+
+  for (a = 0; a < i->iterators; a++)
+    for (b = a + 1; b < i->iterators; b++)
+      if (i->buffer[a]->tile_storage == i->buffer[b]->tile_storage &&
+          ((i->flags[a] | i->flags[b]) & GEGL_BUFFER_WRITE) &&
+          (i->rect[a].x + i->buffer[a]->shift_x !=
+           i->rect[b].x + i->buffer[b]->shift_x ||
+           i->rect[a].y + i->buffer[a]->shift_y !=
+           i->rect[b].y + i->buffer[b]->shift_y))
+        return FALSE;
+
+  return TRUE;
+}
+
+void
+gegl_buffer_iterator_foreach (GeglBufferIterator     *iterator,
+                              GeglBufferIteratorFunc  func,
+                              gpointer                user_data)
+{
+  GeglBufferIterators   *i = (gpointer)iterator;
+  GeglBufferIteratorJob *job;
+  GeglBuffer            *buffer;
+  gint                   threads;
+  gint                   tile_width, tile_height;
+  gint                   cols, rows;
+  gint                   n_helpers;
+  gint                   n;
+
+  g_return_if_fail (i->iteration_no == 0);
+  g_return_if_fail (func != NULL);
+
+  buffer      = i->buffer[0];
+  tile_width  = buffer->tile_storage->tile_width;
+  tile_height = buffer->tile_storage->tile_height;
+  threads     = gegl_config ()->threads;
+
+  /* on a thread that is already one of many, more threads would only
+   * compete with the others for the cores
+   */
+  if (threads <= 1 || gegl_buffer_thread_is_worker () ||
+      i->rect[0].width <= 0 || i->rect[0].height <= 0 ||
+      !iterator_can_split (i))
+    {
+      iterator_run (iterator, func, user_data, gegl_buffer_thread_get_cancellable ());
+      return;
+    }
+
+  job = g_slice_new0 (GeglBufferIteratorJob);
+  job->iterator  = i;
+  job->func      = func;
+  job->user_data = user_data;
+
+  job->tile_x = gegl_tile_indice (i->rect[0].x + buffer->shift_x, tile_width);
+  job->tile_y = gegl_tile_indice (i->rect[0].y + buffer->shift_y, tile_height);
+  cols = gegl_tile_indice (i->rect[0].x + i->rect[0].width - 1 +
+                           buffer->shift_x, tile_width) - job->tile_x + 1;
+  rows = gegl_tile_indice (i->rect[0].y + i->rect[0].height - 1 +
+                           buffer->shift_y, tile_height) - job->tile_y + 1;
+
+  /* a cell is a row of tiles, split in narrower cells when there are too
+   * few rows to keep all threads busy
+   */
+  job->cols_per_cell = cols;
+  while (job->cols_per_cell > 1 &&
+         rows * ((cols + job->cols_per_cell - 1) / job->cols_per_cell) <
+         threads * 4)
+    job->cols_per_cell = (job->cols_per_cell + 1) / 2;
+  job->cells_per_row = (cols + job->cols_per_cell - 1) / job->cols_per_cell;
+  job->n_cells       = rows * job->cells_per_row;
+
+  if (job->n_cells < 2)
+    {
+      g_slice_free (GeglBufferIteratorJob, job);
+      iterator_run (iterator, func, user_data, gegl_buffer_thread_get_cancellable ());
+      return;
+    }
+
+  job->mutex = g_mutex_new ();
+  job->cond  = g_cond_new ();
+
+  /* the helper threads check the cancellable of the processor the calling
+   * thread renders for
+   */
+  job->cancellable = gegl_buffer_thread_get_cancellable ();
+  if (job->cancellable)
+    g_object_ref (job->cancellable);
+
+  n_helpers      = MIN (threads - 1, job->n_cells - 1);
+  job->ref_count = n_helpers + 1;
+
+  g_static_mutex_lock (&iterator_pool_mutex);
+  if (!iterator_pool)
+    iterator_pool = g_thread_pool_new (iterator_pool_func, NULL,
+                                       threads - 1, FALSE, NULL);
+  else if (g_thread_pool_get_max_threads (iterator_pool) != threads - 1)
+    g_thread_pool_set_max_threads (iterator_pool, threads - 1, NULL);
+
+  for (n = 0; n < n_helpers; n++)
+    g_thread_pool_push (iterator_pool, job, NULL);
+  g_static_mutex_unlock (&iterator_pool_mutex);
+
+  /* work along with the helpers, cells no helper got around to yet do not
+   * hold the caller up
+   */
+  iterator_job_work (job);
+
+  g_mutex_lock (job->mutex);
+  while (job->done_cells < job->n_cells)
+    g_cond_wait (job->cond, job->mutex);
+  g_mutex_unlock (job->mutex);
+
+  iterator_job_unref (job);
+}
@@ -28,6 +28,13 @@
 #define GEGL_BUFFER_WRITE     2
 #define GEGL_BUFFER_READWRITE (GEGL_BUFFER_READ|GEGL_BUFFER_WRITE)
 
+/* passed along with GEGL_BUFFER_READ or GEGL_BUFFER_WRITE by code that
+ * walks the data row by row using iterator->rowstride[], allowing chunks
+ * that cover only part of a tile's width to be accessed in place. Without
+ * it the data of every chunk is packed, with rows of roi.width pixels.
+ */
+#define GEGL_BUFFER_STRIDED   4
+
 /***
  * GeglBufferIterator:
  *
@@ -41,6 +48,9 @@ typedef struct GeglBufferIterator
   gpointer      data[GEGL_BUFFER_MAX_ITERATORS];
   GeglRectangle roi[GEGL_BUFFER_MAX_ITERATORS];
   gint          level;
+  gint          rowstride[GEGL_BUFFER_MAX_ITERATORS]; /* bytes between the
+                                                        * rows of data[]
+                                                        */
 } GeglBufferIterator;
 
 
@@ -51,7 +61,7 @@ typedef struct GeglBufferIterator
  * @level: the level at which we are iterating, the roi will indicate the
  * extent at 1:1, x,y,width and height are/(2^level)
  * @format: the format we want to process this buffers data in, pass 0 to use the buffers format.
- * @flags: whether we need reading or writing to this buffer one of GEGL_BUFFER_READ, GEGL_BUFFER_WRITE and GEGL_BUFFER_READWRITE.
+ * @flags: whether we need reading or writing to this buffer one of GEGL_BUFFER_READ, GEGL_BUFFER_WRITE and GEGL_BUFFER_READWRITE, optionally combined with GEGL_BUFFER_STRIDED.
  * @repeat_mode: how request outside the buffer extent are handled.
  * Valid values: GEGL_ABYSS_NONE
 
@@ -80,7 +90,8 @@ GeglBufferIterator * gegl_buffer_iterator_new  (GeglBuffer          *buffer,
  * @level: the level at which we are iterating, the roi will indicate the
  * extent at 1:1, x,y,width and height are/(2^level)
  * @format: the format we want to process this buffers data in, pass 0 to use the buffers format.
- * @flags: whether we need reading or writing to this buffer.
+ * @flags: whether we need reading or writing to this buffer, optionally
+ * combined with GEGL_BUFFER_STRIDED.
  * @repeat_mode: how request outside the buffer extent are handled.
  * Valid values: GEGL_ABYSS_NONE
  *
@@ -123,6 +134,58 @@ void                 gegl_buffer_iterator_stop  (GeglBufferIterator *iterator);
  */
 gboolean             gegl_buffer_iterator_next (GeglBufferIterator *iterator);
 
+/**
+ * gegl_buffer_iterator_is_uniform:
+ * @iterator: a #GeglBufferIterator
+ * @index: the handle returned by gegl_buffer_iterator_add(), 0 for the
+ * buffer passed to gegl_buffer_iterator_new()
+ *
+ * Checks whether all the pixels of iterator->data[index] in the current
+ * iteration have the same value, as is the case for regions filled by
+ * gegl_buffer_set_color() or gegl_buffer_clear(). Only buffers iterated for
+ * reading are reported as uniform.
+ *
+ * Returns: TRUE if the current data of @index is one repeated pixel.
+ */
+gboolean             gegl_buffer_iterator_is_uniform (GeglBufferIterator *iterator,
+                                                      gint                index);
+
+/**
+ * GeglBufferIteratorFunc:
+ * @iterator: a #GeglBufferIterator providing the data of the current chunk
+ * @user_data: the data passed to gegl_buffer_iterator_foreach()
+ *
+ * Processes the chunk in iterator->data[], in the same way as the body of a
+ * loop over gegl_buffer_iterator_next() does.
+ */
+typedef void (*GeglBufferIteratorFunc) (GeglBufferIterator *iterator,
+                                        gpointer            user_data);
+
+/**
+ * gegl_buffer_iterator_foreach:
+ * @iterator: a #GeglBufferIterator on which gegl_buffer_iterator_next() has
+ * not been called yet
+ * @func: the function to call for every chunk
+ * @user_data: data to pass to @func
+ *
+ * Calls @func for all the chunks the iterator covers, spreading them over
+ * the number of threads set with the "threads" property of GeglConfig.
+ * Chunks processed at the same time are on different tiles of every buffer
+ * written to, but @func must be safe to call from several threads at once.
+ * The indices returned by gegl_buffer_iterator_add() stay valid for the
+ * iterator passed to @func. The iterator handle is no longer valid
+ * afterwards. Called from @func, or from a thread rendering part of a
+ * request for the scheduler, the chunks are processed by the calling
+ * thread alone.
+ *
+ * When called while a #GeglProcessor with a "cancellable" is working, @func
+ * is no longer called once that cancellable has been cancelled, leaving the
+ * chunks not yet processed as they are.
+ */
+void                 gegl_buffer_iterator_foreach (GeglBufferIterator     *iterator,
+                                                   GeglBufferIteratorFunc  func,
+                                                   gpointer                user_data);
+
 /**
  */
 
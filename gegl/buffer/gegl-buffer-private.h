@@ -20,6 +20,8 @@
 #ifndef __GEGL_BUFFER_PRIVATE_H__
 #define __GEGL_BUFFER_PRIVATE_H__
 
+#include <gio/gio.h>
+
 #include "gegl-buffer-types.h"
 #include "gegl-buffer.h"
 #include "gegl-tile-handler.h"
@@ -97,6 +99,8 @@ void              gegl_tile_cache_init    (void);
 
 void              gegl_tile_cache_destroy (void);
 
+void              gegl_tile_cache_set_policy (const gchar *name);
+
 GeglTileBackend * gegl_buffer_backend     (GeglBuffer *buffer);
 GeglTileBackend * gegl_buffer_backend2    (GeglBuffer *buffer); /* non-cached */
 
@@ -164,6 +168,10 @@ struct _GeglTile
                                  * should in theory just have the values 0/1
                                  */
 
+  gboolean         is_uniform;  /* all pixels of data are the same value,
+                                 * cleared when the tile is locked for writing
+                                 */
+
 
 #ifdef GEGL_USE_TILE_MUTEX
   GMutex          *mutex;
@@ -186,6 +194,27 @@ struct _GeglTile
 
 void _gegl_buffer_drop_hot_tile (GeglBuffer *buffer);
 
+/* The "cancellable" of the GeglProcessor the calling thread renders for,
+ * NULL when there is none, whatever GCancellable the application made
+ * current for the thread. The threads of the scheduler and of
+ * gegl_buffer_iterator_foreach() take it over from the thread they work
+ * for. set returns the previous one, to be restored when done, no
+ * reference is taken.
+ */
+GCancellable * gegl_buffer_thread_get_cancellable (void);
+GCancellable * gegl_buffer_thread_set_cancellable (GCancellable *cancellable);
+
+/* Whether the calling thread works on a part of a parallel loop, such as
+ * a unit of the scheduler or a cell of gegl_buffer_iterator_foreach(), in
+ * which case nested loops are done by it alone. set returns the previous
+ * value, to be restored when done.
+ */
+gboolean       gegl_buffer_thread_is_worker       (void);
+gboolean       gegl_buffer_thread_set_worker      (gboolean      is_worker);
+
+/* voids the tiles of the pyramid above a base level tile */
+void gegl_tile_void_pyramid (GeglTile *tile);
+
 gboolean gegl_buffer_scan_compatible (GeglBuffer *bufferA,
                                       gint        xA,
                                       gint        yA,
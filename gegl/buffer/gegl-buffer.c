@@ -1314,6 +1314,26 @@ gegl_buffer_set_format (GeglBuffer *buffer,
   return NULL;
 }
 
+void
+gegl_buffer_set_cache_budget (GeglBuffer *buffer,
+                              guint64     budget)
+{
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+
+  if (buffer->tile_storage && buffer->tile_storage->cache)
+    gegl_tile_handler_cache_set_budget (buffer->tile_storage->cache, budget);
+}
+
+guint64
+gegl_buffer_get_cache_budget (GeglBuffer *buffer)
+{
+  g_return_val_if_fail (GEGL_IS_BUFFER (buffer), 0);
+
+  if (buffer->tile_storage && buffer->tile_storage->cache)
+    return buffer->tile_storage->cache->budget;
+  return 0;
+}
+
 gboolean gegl_buffer_is_shared (GeglBuffer *buffer)
 {
   GeglTileBackend *backend = gegl_buffer_backend (buffer);
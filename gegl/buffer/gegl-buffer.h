@@ -316,6 +316,89 @@ const Babl *    gegl_buffer_get_format        (GeglBuffer           *buffer);
 const Babl *    gegl_buffer_set_format        (GeglBuffer          *buffer,
                                                const Babl          *format);
 
+/**
+ * gegl_buffer_set_cache_budget:
+ * @buffer: a #GeglBuffer
+ * @budget: the number of bytes of tile data the buffer may keep in the tile
+ * cache, or 0 for no limit.
+ *
+ * Limit how much of the tile cache the buffer and the buffers sharing its
+ * storage (sub-buffers and the like) can use. When the budget is exceeded the
+ * least recently inserted tiles of the buffer are written back and dropped
+ * from the cache, leaving the cached tiles of other buffers alone.
+ */
+void            gegl_buffer_set_cache_budget  (GeglBuffer          *buffer,
+                                               guint64              budget);
+
+/**
+ * gegl_buffer_get_cache_budget:
+ * @buffer: a #GeglBuffer
+ *
+ * Returns: the tile cache budget of the buffer in bytes, 0 if unlimited.
+ */
+guint64         gegl_buffer_get_cache_budget  (GeglBuffer          *buffer);
+
+/**
+ * gegl_buffer_cache_shrink:
+ * @target: the number of bytes the tile cache should at most hold afterwards.
+ *
+ * Evict tiles from the global tile cache, writing back dirty tiles, until it
+ * holds no more than @target bytes. Meant to be called by applications that
+ * are notified about memory pressure, passing 0 empties the cache. Tile
+ * memory that is no longer in use is returned to the system.
+ *
+ * Returns: the number of bytes released.
+ */
+guint64         gegl_buffer_cache_shrink      (guint64              target);
+
+/**
+ * GeglBufferCachePressureFunc:
+ * @total: the number of bytes of tile data in the tile cache.
+ * @limit: the "cache-bytes" of #GeglConfig the cache went over.
+ * @user_data: the data passed to gegl_buffer_cache_set_pressure_func().
+ *
+ * Called when storing a tile brings the tile cache over its size, before
+ * GEGL evicts tiles itself. It is called without any cache locks held, from
+ * whatever thread stored the tile, and may call gegl_buffer_cache_shrink()
+ * to make room for more than one tile at a time or release memory of the
+ * application.
+ */
+typedef void (*GeglBufferCachePressureFunc) (guint64  total,
+                                             guint64  limit,
+                                             gpointer user_data);
+
+/**
+ * gegl_buffer_cache_set_pressure_func:
+ * @func: the function to call when the tile cache is over its size, or NULL.
+ * @user_data: data passed to @func.
+ *
+ * Sets the function notified about memory pressure in the tile cache,
+ * replacing the previous one.
+ */
+void            gegl_buffer_cache_set_pressure_func (GeglBufferCachePressureFunc func,
+                                                     gpointer                    user_data);
+
+/**
+ * gegl_buffer_cache_get_total:
+ *
+ * Returns: the approximate number of bytes of tile data in the tile cache.
+ */
+guint64         gegl_buffer_cache_get_total   (void);
+
+/**
+ * gegl_buffer_tile_memory_get_stats:
+ * @reserved: (out): return location for the number of bytes GEGL obtained
+ * from the system for tile data, or NULL.
+ * @in_use: (out): return location for the number of bytes of tile data
+ * currently held by tiles, or NULL.
+ *
+ * Reports the memory used by the tile allocator. The difference between
+ * @reserved and @in_use is kept for new tiles, unused memory is returned to
+ * the system by gegl_buffer_cache_shrink().
+ */
+void            gegl_buffer_tile_memory_get_stats (guint64         *reserved,
+                                                   guint64         *in_use);
+
 /**
  * gegl_buffer_clear:
  * @buffer: a #GeglBuffer
@@ -446,6 +529,55 @@ void              gegl_sampler_get            (GeglSampler    *sampler,
                                                void           *output,
                                                GeglAbyssPolicy repeat_mode);
 
+/**
+ * gegl_sampler_get_span:
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @x: homogeneous x coordinate of the first point
+ * @y: homogeneous y coordinate of the first point
+ * @w: homogeneous w coordinate of the first point
+ * @dx: increment of @x from one point to the next
+ * @dy: increment of @y from one point to the next
+ * @dw: increment of @w from one point to the next
+ * @n_points: number of points to sample
+ * @scale: matrix representing extent of sampling area in source buffer,
+ * used for all the points.
+ * @output: memory location for @n_points pixels of output data.
+ *
+ * Samples @n_points along a scanline, point i is at
+ * ((@x + i * @dx) / (@w + i * @dw), (@y + i * @dy) / (@w + i * @dw)). Pass
+ * 1.0 for @w and 0.0 for @dw for a linear scanline. This gives the same
+ * results as calling gegl_sampler_get() for every point, at a fraction of
+ * the cost.
+ */
+void              gegl_sampler_get_span       (GeglSampler    *sampler,
+                                               gdouble         x,
+                                               gdouble         y,
+                                               gdouble         w,
+                                               gdouble         dx,
+                                               gdouble         dy,
+                                               gdouble         dw,
+                                               gint            n_points,
+                                               GeglMatrix2    *scale,
+                                               void           *output);
+
+/**
+ * gegl_sampler_get_points:
+ * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
+ * @coords: @n_points pairs of x and y coordinates to sample
+ * @scales: NULL or a matrix representing the extent of the sampling area
+ * in the source buffer for each of the points.
+ * @n_points: number of points to sample
+ * @output: memory location for @n_points pixels of output data.
+ *
+ * Samples an explicit array of points, giving the same results as calling
+ * gegl_sampler_get() for each of them.
+ */
+void              gegl_sampler_get_points     (GeglSampler    *sampler,
+                                               const gdouble  *coords,
+                                               GeglMatrix2    *scales,
+                                               gint            n_points,
+                                               void           *output);
+
 /**
  * gegl_sampler_get_context_rect:
  * @sampler: a GeglSampler gotten from gegl_buffer_sampler_new
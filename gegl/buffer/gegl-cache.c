@@ -22,6 +22,7 @@
 
 #include <glib-object.h>
 #include <glib/gstdio.h>
+#include <gio/gio.h>
 
 #include <babl/babl.h>
 
@@ -32,6 +33,7 @@
 #include "graph/gegl-node.h"
 
 #include "gegl-cache.h"
+#include "gegl-buffer-private.h"
 #include "gegl-region.h"
 
 enum
@@ -85,35 +87,42 @@ gegl_cache_constructor (GType                  type,
   return object;
 }
 
-/* expand invalidated regions to be align with coordinates divisible by 8 in both
- * directions. This improves improves the performance of GeglProcessor when it
- * iterates the resulting dirtied rectangles in the GeglRegion.
- */
-static GeglRectangle gegl_rectangle_expand (const GeglRectangle *rectangle)
+static gint
+floor_div (gint a,
+           gint b)
 {
-  gint align = 8;
-  GeglRectangle expanded = *rectangle;
-  gint xdiff;
-  gint ydiff;
+  return a >= 0 ? a / b : - ((b - 1 - a) / b);
+}
 
-  if (gegl_rectangle_is_infinite_plane (rectangle))
+/* expand invalidated regions to whole tiles of the cache, the valid region
+ * then stays made up of tiles, and GeglProcessor re-renders the tiles that
+ * were touched instead of iterating ever smaller slivers around the edits.
+ */
+static GeglRectangle
+gegl_cache_expand_to_tiles (GeglCache           *self,
+                            const GeglRectangle *rectangle)
+{
+  GeglBuffer   *buffer      = GEGL_BUFFER (self);
+  gint          tile_width  = MAX (buffer->tile_width, 1);
+  gint          tile_height = MAX (buffer->tile_height, 1);
+  gint          x0, y0, x1, y1;
+  GeglRectangle expanded;
+
+  if (gegl_rectangle_is_infinite_plane (rectangle) ||
+      rectangle->width <= 0 || rectangle->height <= 0)
     return *rectangle;
 
-  xdiff = expanded.x % align;
-  if (xdiff < 0)
-    xdiff = align + xdiff;
-  expanded.width += xdiff;
-  expanded.x -= xdiff;
-  xdiff = align -(expanded.width % align);
-  expanded.width += xdiff;
-
-  ydiff = expanded.y % align;
-  if (ydiff < 0)
-    ydiff = align + ydiff;
-  expanded.height += ydiff;
-  expanded.y -= ydiff;
-  ydiff = align -(expanded.height % align);
-  expanded.height += ydiff;
+  x0 = floor_div (rectangle->x + buffer->shift_x, tile_width);
+  y0 = floor_div (rectangle->y + buffer->shift_y, tile_height);
+  x1 = floor_div (rectangle->x + rectangle->width - 1 + buffer->shift_x,
+                  tile_width) + 1;
+  y1 = floor_div (rectangle->y + rectangle->height - 1 + buffer->shift_y,
+                  tile_height) + 1;
+
+  expanded.x      = x0 * tile_width - buffer->shift_x;
+  expanded.y      = y0 * tile_height - buffer->shift_y;
+  expanded.width  = (x1 - x0) * tile_width;
+  expanded.height = (y1 - y0) * tile_height;
 
   return expanded;
 }
@@ -242,7 +251,7 @@ node_invalidated (GeglNode            *source,
                   gpointer             data)
 {
   GeglCache *cache = GEGL_CACHE (data);
-  GeglRectangle expanded = gegl_rectangle_expand (rect);
+  GeglRectangle expanded = gegl_cache_expand_to_tiles (cache, rect);
 
   {
     GeglRegion *region;
@@ -388,7 +397,7 @@ gegl_cache_invalidate (GeglCache           *self,
 
   if (roi)
     {
-      GeglRectangle expanded = gegl_rectangle_expand (roi);
+      GeglRectangle expanded = gegl_cache_expand_to_tiles (self, roi);
 
       GeglRegion *temp_region;
       temp_region = gegl_region_rectangle (&expanded);
@@ -416,6 +425,10 @@ gegl_cache_computed (GeglCache           *self,
   g_return_if_fail (GEGL_IS_CACHE (self));
   g_return_if_fail (rect != NULL);
 
+  /* parts of a cancelled render have been skipped */
+  if (g_cancellable_is_cancelled (gegl_buffer_thread_get_cancellable ()))
+    return;
+
   g_mutex_lock (self->mutex);
   gegl_region_union_with_rect (self->valid_region, rect);
   g_signal_emit (self, gegl_cache_signals[COMPUTED], 0, rect, NULL);
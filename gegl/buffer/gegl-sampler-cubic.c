@@ -42,6 +42,12 @@ static void      gegl_sampler_cubic_get (GeglSampler  *sampler,
                                          gdouble       y,
                                          GeglMatrix2  *scale,
                                          void         *output);
+static void      gegl_sampler_cubic_get_points (GeglSampler   *sampler,
+                                                const gdouble *coords,
+                                                GeglMatrix2   *scales,
+                                                gint           scales_stride,
+                                                gint           n_points,
+                                                void          *output);
 static void      get_property           (GObject      *gobject,
                                          guint         prop_id,
                                          GValue       *value,
@@ -68,6 +74,7 @@ gegl_sampler_cubic_class_init (GeglSamplerCubicClass *klass)
   object_class->finalize     = gegl_sampler_cubic_finalize;
 
   sampler_class->get     = gegl_sampler_cubic_get;
+  sampler_class->get_points = gegl_sampler_cubic_get_points;
 
   g_object_class_install_property (object_class, PROP_B,
                                    g_param_spec_double ("b",
@@ -132,12 +139,12 @@ gegl_sampler_cubic_init (GeglSamplerCubic *self)
     }
 }
 
-void
-gegl_sampler_cubic_get (GeglSampler *self,
-                        gdouble      x,
-                        gdouble      y,
-                        GeglMatrix2 *scale,
-                        void        *output)
+static inline void
+gegl_sampler_cubic_interpolate (GeglSampler *self,
+                                gdouble      x,
+                                gdouble      y,
+                                gboolean     prefetched,
+                                gfloat      *newval)
 {
   GeglSamplerCubic *cubic = (GeglSamplerCubic*)(self);
   GeglRectangle     context_rect;
@@ -148,8 +155,6 @@ gegl_sampler_cubic_get (GeglSampler *self,
   gfloat           *sampler_bptr;
   gfloat            factor;
 
-  gfloat             newval[4] = {0.0, 0.0, 0.0, 0.0};
-
   gint              u,v;
   gint              dx,dy;
   gint              i;
@@ -157,7 +162,10 @@ gegl_sampler_cubic_get (GeglSampler *self,
   context_rect = self->context_rect[0];
   dx = (gint) x;
   dy = (gint) y;
-  sampler_bptr = gegl_sampler_get_ptr (self, dx, dy);
+  sampler_bptr = prefetched ? gegl_sampler_get_ptr_unchecked (self, dx, dy)
+                            : gegl_sampler_get_ptr (self, dx, dy);
+
+  newval[0] = newval[1] = newval[2] = newval[3] = 0.0;
 
      {
        for (v=dy+context_rect.y, i=0; v < dy+context_rect.y+context_rect.height ; v++)
@@ -174,10 +182,51 @@ gegl_sampler_cubic_get (GeglSampler *self,
             newval[3] += factor * sampler_bptr[3];
            }
      }
+}
 
+void
+gegl_sampler_cubic_get (GeglSampler *self,
+                        gdouble      x,
+                        gdouble      y,
+                        GeglMatrix2 *scale,
+                        void        *output)
+{
+  gfloat newval[4];
+
+  gegl_sampler_cubic_interpolate (self, x, y, FALSE, newval);
   babl_process (self->fish, newval, output, 1);
 }
 
+static void
+gegl_sampler_cubic_get_points (GeglSampler   *self,
+                               const gdouble *coords,
+                               GeglMatrix2   *scales,
+                               gint           scales_stride,
+                               gint           n_points,
+                               void          *output)
+{
+  const gint bpp = babl_format_get_bytes_per_pixel (self->format);
+  gfloat     newval[GEGL_SAMPLER_SPAN_CHUNK * 4];
+  guchar    *out = output;
+
+  while (n_points > 0)
+    {
+      const gint     n = MIN (n_points, GEGL_SAMPLER_SPAN_CHUNK);
+      const gboolean prefetched = gegl_sampler_prefetch (self, coords, n);
+      gint           i;
+
+      for (i = 0; i < n; i++)
+        gegl_sampler_cubic_interpolate (self, coords[i * 2], coords[i * 2 + 1],
+                                        prefetched, newval + i * 4);
+
+      babl_process (self->fish, newval, out, n);
+
+      coords   += n * 2;
+      out      += n * bpp;
+      n_points -= n;
+    }
+}
+
 static void
 get_property (GObject    *object,
               guint       prop_id,
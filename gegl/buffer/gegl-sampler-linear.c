@@ -67,6 +67,12 @@ static void gegl_sampler_linear_get (GeglSampler* restrict self,
                                      const gdouble         y,
                                      GeglMatrix2          *scale,
                                      void*        restrict output);
+static void gegl_sampler_linear_get_points (GeglSampler   *self,
+                                            const gdouble *coords,
+                                            GeglMatrix2   *scales,
+                                            gint           scales_stride,
+                                            gint           n_points,
+                                            void          *output);
 
 G_DEFINE_TYPE (GeglSamplerLinear, gegl_sampler_linear, GEGL_TYPE_SAMPLER)
 
@@ -76,6 +82,7 @@ gegl_sampler_linear_class_init (GeglSamplerLinearClass *klass)
   GeglSamplerClass *sampler_class = GEGL_SAMPLER_CLASS (klass);
 
   sampler_class->get = gegl_sampler_linear_get;
+  sampler_class->get_points = gegl_sampler_linear_get_points;
 }
 
 static void
@@ -88,12 +95,12 @@ gegl_sampler_linear_init (GeglSamplerLinear *self)
   GEGL_SAMPLER (self)->interpolate_format = babl_format ("RaGaBaA float");
 }
 
-static void
-gegl_sampler_linear_get (GeglSampler* restrict self,
-                         const gdouble         absolute_x,
-                         const gdouble         absolute_y,
-                         GeglMatrix2          *scale,
-                         void*        restrict output)
+static inline void
+gegl_sampler_linear_interpolate (GeglSampler* restrict self,
+                                 const gdouble         absolute_x,
+                                 const gdouble         absolute_y,
+                                 const gboolean        prefetched,
+                                 gfloat*      restrict newval)
 {
   const gint pixels_per_buffer_row = 64;
   const gint channels = 4;
@@ -120,7 +127,9 @@ gegl_sampler_linear_get (GeglSampler* restrict self,
    * Point the data tile pointer to the first channel of the top_left
    * pixel value:
    */
-  const gfloat* restrict in_bptr = gegl_sampler_get_ptr (self, ix, iy);
+  const gfloat* restrict in_bptr =
+    prefetched ? gegl_sampler_get_ptr_unchecked (self, ix, iy)
+               : gegl_sampler_get_ptr (self, ix, iy);
 
   /*
    * First bilinear weight:
@@ -167,8 +176,6 @@ gegl_sampler_linear_get (GeglSampler* restrict self,
    */
   const gfloat w_times_z = 1.f - ( x + w_times_y );
 
-  gfloat newval[4];
-
   newval[0] =
     x_times_y * bot_rite_0
     +
@@ -204,7 +211,48 @@ gegl_sampler_linear_get (GeglSampler* restrict self,
     x_times_z * top_rite_3
     +
     w_times_z * top_left_3;
-
-    babl_process (self->fish, newval, output, 1);
   }
 }
+
+static void
+gegl_sampler_linear_get (GeglSampler* restrict self,
+                         const gdouble         absolute_x,
+                         const gdouble         absolute_y,
+                         GeglMatrix2          *scale,
+                         void*        restrict output)
+{
+  gfloat newval[4];
+
+  gegl_sampler_linear_interpolate (self, absolute_x, absolute_y, FALSE, newval);
+  babl_process (self->fish, newval, output, 1);
+}
+
+static void
+gegl_sampler_linear_get_points (GeglSampler   *self,
+                                const gdouble *coords,
+                                GeglMatrix2   *scales,
+                                gint           scales_stride,
+                                gint           n_points,
+                                void          *output)
+{
+  const gint bpp = babl_format_get_bytes_per_pixel (self->format);
+  gfloat     newval[GEGL_SAMPLER_SPAN_CHUNK * 4];
+  guchar    *out = output;
+
+  while (n_points > 0)
+    {
+      const gint     n = MIN (n_points, GEGL_SAMPLER_SPAN_CHUNK);
+      const gboolean prefetched = gegl_sampler_prefetch (self, coords, n);
+      gint           i;
+
+      for (i = 0; i < n; i++)
+        gegl_sampler_linear_interpolate (self, coords[i * 2], coords[i * 2 + 1],
+                                         prefetched, newval + i * 4);
+
+      babl_process (self->fish, newval, out, n);
+
+      coords   += n * 2;
+      out      += n * bpp;
+      n_points -= n;
+    }
+}
@@ -259,6 +259,12 @@ static void gegl_sampler_lohalo_get (      GeglSampler* restrict self,
                                      const gdouble               absolute_y,
                                            GeglMatrix2          *scale,
                                            void*        restrict output);
+static void gegl_sampler_lohalo_get_points (GeglSampler   *self,
+                                            const gdouble *coords,
+                                            GeglMatrix2   *scales,
+                                            gint           scales_stride,
+                                            gint           n_points,
+                                            void          *output);
 
 G_DEFINE_TYPE (GeglSamplerLohalo, gegl_sampler_lohalo, GEGL_TYPE_SAMPLER)
 
@@ -267,6 +273,7 @@ gegl_sampler_lohalo_class_init (GeglSamplerLohaloClass *klass)
 {
   GeglSamplerClass *sampler_class = GEGL_SAMPLER_CLASS (klass);
   sampler_class->get = gegl_sampler_lohalo_get;
+  sampler_class->get_points = gegl_sampler_lohalo_get_points;
 }
 
 
@@ -1286,12 +1293,13 @@ level_1_ewa_update (const gint              j,
 }
 
 
-static void
-gegl_sampler_lohalo_get (      GeglSampler* restrict self,
-                         const gdouble               absolute_x,
-                         const gdouble               absolute_y,
-                         GeglMatrix2                *scale,
-                               void*        restrict output)
+static inline void
+gegl_sampler_lohalo_interpolate (      GeglSampler* restrict self,
+                                 const gdouble               absolute_x,
+                                 const gdouble               absolute_y,
+                                 GeglMatrix2                *scale,
+                                 const gboolean              prefetched,
+                                       gfloat*      restrict newval)
 {
   /*
    * Needed constants related to the input pixel value pointer
@@ -1315,7 +1323,8 @@ gegl_sampler_lohalo_get (      GeglSampler* restrict self,
    * (level "0"), the one with scale=1.0.
    */
   const gfloat* restrict input_bptr =
-    (gfloat*) gegl_sampler_get_ptr (self, ix_0, iy_0);
+    prefetched ? gegl_sampler_get_ptr_unchecked (self, ix_0, iy_0)
+               : gegl_sampler_get_ptr (self, ix_0, iy_0);
 
   /*
    * (x_0,y_0) is the relative position of the sampling location
@@ -1387,12 +1396,6 @@ gegl_sampler_lohalo_get (      GeglSampler* restrict self,
   gfloat tre_one_3, tre_two_3, tre_thr_3, tre_fou_3;
   gfloat qua_one_3, qua_two_3, qua_thr_3, qua_fou_3;
 
-  /*
-   * The newval array will contain one computed resampled value per
-   * channel:
-   */
-  gfloat newval[channels];
-
   /*
    * First channel:
    */
@@ -2403,12 +2406,66 @@ gegl_sampler_lohalo_get (      GeglSampler* restrict self,
             }
           }
         }
-
-      /*
-       * Ship out the result:
-       */
-      babl_process (self->fish, newval, output, 1);
-      return;
     }
   }
 }
+
+static void
+gegl_sampler_lohalo_get (      GeglSampler* restrict self,
+                         const gdouble               absolute_x,
+                         const gdouble               absolute_y,
+                         GeglMatrix2                *scale,
+                               void*        restrict output)
+{
+  /*
+   * The newval array will contain one computed resampled value per
+   * channel:
+   */
+  gfloat newval[4];
+
+  gegl_sampler_lohalo_interpolate (self, absolute_x, absolute_y, scale,
+                                   FALSE, newval);
+
+  /*
+   * Ship out the result:
+   */
+  babl_process (self->fish, newval, output, 1);
+}
+
+/*
+ * The downsampling part of lohalo pulls pixels from the mipmap levels
+ * itself, only the level 0 context is fetched once per chunk of points.
+ */
+static void
+gegl_sampler_lohalo_get_points (GeglSampler   *self,
+                                const gdouble *coords,
+                                GeglMatrix2   *scales,
+                                gint           scales_stride,
+                                gint           n_points,
+                                void          *output)
+{
+  const gint bpp = babl_format_get_bytes_per_pixel (self->format);
+  gfloat     newval[GEGL_SAMPLER_SPAN_CHUNK * 4];
+  guchar    *out = output;
+
+  while (n_points > 0)
+    {
+      const gint     n = MIN (n_points, GEGL_SAMPLER_SPAN_CHUNK);
+      const gboolean prefetched = gegl_sampler_prefetch (self, coords, n);
+      gint           i;
+
+      for (i = 0; i < n; i++)
+        gegl_sampler_lohalo_interpolate (self, coords[i * 2], coords[i * 2 + 1],
+                                         scales ? scales + i * scales_stride
+                                                : NULL,
+                                         prefetched, newval + i * 4);
+
+      babl_process (self->fish, newval, out, n);
+
+      coords   += n * 2;
+      if (scales)
+        scales += n * scales_stride;
+      out      += n * bpp;
+      n_points -= n;
+    }
+}
@@ -37,6 +37,12 @@ static void    gegl_sampler_nearest_get (GeglSampler  *self,
                                          gdouble       y,
                                          GeglMatrix2  *scale,
                                          void         *output);
+static void    gegl_sampler_nearest_get_points (GeglSampler   *self,
+                                                const gdouble *coords,
+                                                GeglMatrix2   *scales,
+                                                gint           scales_stride,
+                                                gint           n_points,
+                                                void          *output);
 
 G_DEFINE_TYPE (GeglSamplerNearest, gegl_sampler_nearest, GEGL_TYPE_SAMPLER)
 
@@ -46,6 +52,7 @@ gegl_sampler_nearest_class_init (GeglSamplerNearestClass *klass)
   GeglSamplerClass *sampler_class = GEGL_SAMPLER_CLASS (klass);
 
   sampler_class->get     = gegl_sampler_nearest_get;
+  sampler_class->get_points = gegl_sampler_nearest_get_points;
 
 }
 
@@ -70,3 +77,43 @@ gegl_sampler_nearest_get (GeglSampler *self,
   sampler_bptr = gegl_sampler_get_from_buffer (self, (gint)x, (gint)y);
   babl_process (self->fish, sampler_bptr, output, 1);
 }
+
+static void
+gegl_sampler_nearest_get_points (GeglSampler   *self,
+                                 const gdouble *coords,
+                                 GeglMatrix2   *scales,
+                                 gint           scales_stride,
+                                 gint           n_points,
+                                 void          *output)
+{
+  const gint bpp = babl_format_get_bytes_per_pixel (self->format);
+  gfloat     newval[GEGL_SAMPLER_SPAN_CHUNK * 4];
+  guchar    *out = output;
+
+  while (n_points > 0)
+    {
+      const gint     n = MIN (n_points, GEGL_SAMPLER_SPAN_CHUNK);
+      const gboolean prefetched = gegl_sampler_prefetch (self, coords, n);
+      gint           i;
+
+      for (i = 0; i < n; i++)
+        {
+          const gint    ix = (gint) coords[i * 2];
+          const gint    iy = (gint) coords[i * 2 + 1];
+          const gfloat *sampler_bptr =
+            prefetched ? gegl_sampler_get_ptr_unchecked (self, ix, iy)
+                       : gegl_sampler_get_from_buffer (self, ix, iy);
+
+          newval[i * 4]     = sampler_bptr[0];
+          newval[i * 4 + 1] = sampler_bptr[1];
+          newval[i * 4 + 2] = sampler_bptr[2];
+          newval[i * 4 + 3] = sampler_bptr[3];
+        }
+
+      babl_process (self->fish, newval, out, n);
+
+      coords   += n * 2;
+      out      += n * bpp;
+      n_points -= n;
+    }
+}
@@ -77,6 +77,7 @@ gegl_sampler_class_init (GeglSamplerClass *klass)
 
   klass->prepare = NULL;
   klass->get     = NULL;
+  klass->get_points = NULL;
   klass->set_buffer   = set_buffer;
 
   object_class->set_property = set_property;
@@ -125,6 +126,93 @@ gegl_sampler_get (GeglSampler   *self,
   self->get (self, x, y, scale, output);
 }
 
+static void
+gegl_sampler_get_points_real (GeglSampler   *self,
+                              const gdouble *coords,
+                              GeglMatrix2   *scales,
+                              gint           scales_stride,
+                              gint           n_points,
+                              void          *output)
+{
+  if (self->get_points)
+    {
+      self->get_points (self, coords, scales, scales_stride, n_points, output);
+    }
+  else
+    {
+      const gint bpp = babl_format_get_bytes_per_pixel (self->format);
+      guchar    *out = output;
+      gint       i;
+
+      for (i = 0; i < n_points; i++)
+        self->get (self, coords[i * 2], coords[i * 2 + 1],
+                   scales ? scales + i * scales_stride : NULL,
+                   out + i * bpp);
+    }
+}
+
+void
+gegl_sampler_get_points (GeglSampler   *self,
+                         const gdouble *coords,
+                         GeglMatrix2   *scales,
+                         gint           n_points,
+                         void          *output)
+{
+  gegl_sampler_get_points_real (self, coords, scales, 1, n_points, output);
+}
+
+/*
+ * Point i of a span is at ((x + i * dx) / (w + i * dw),
+ * (y + i * dy) / (w + i * dw)), w = 1.0 and dw = 0.0 give a linear span.
+ */
+void
+gegl_sampler_get_span (GeglSampler   *self,
+                       gdouble        x,
+                       gdouble        y,
+                       gdouble        w,
+                       gdouble        dx,
+                       gdouble        dy,
+                       gdouble        dw,
+                       gint           n_points,
+                       GeglMatrix2   *scale,
+                       void          *output)
+{
+  const gint bpp = babl_format_get_bytes_per_pixel (self->format);
+  gdouble    coords[GEGL_SAMPLER_SPAN_CHUNK * 2];
+  guchar    *out = output;
+  gint       done = 0;
+
+  while (done < n_points)
+    {
+      const gint n = MIN (n_points - done, GEGL_SAMPLER_SPAN_CHUNK);
+      gint       i;
+
+      if (w == 1.0 && dw == 0.0)
+        {
+          for (i = 0; i < n; i++)
+            {
+              coords[i * 2]     = x + (done + i) * dx;
+              coords[i * 2 + 1] = y + (done + i) * dy;
+            }
+        }
+      else
+        {
+          for (i = 0; i < n; i++)
+            {
+              gdouble w_recip = 1.0 / (w + (done + i) * dw);
+
+              coords[i * 2]     = (x + (done + i) * dx) * w_recip;
+              coords[i * 2 + 1] = (y + (done + i) * dy) * w_recip;
+            }
+        }
+
+      gegl_sampler_get_points_real (self, coords, scale, 0, n, out);
+
+      out  += n * bpp;
+      done += n;
+    }
+}
+
 void
 gegl_sampler_prepare (GeglSampler *self)
 {
@@ -156,6 +244,7 @@ gegl_sampler_prepare (GeglSampler *self)
     }
 #endif
   self->get = klass->get; /* cache the sampler in the instance */
+  self->get_points = klass->get_points;
 }
 
 void
@@ -295,6 +384,86 @@ gegl_sampler_get_ptr (GeglSampler *const sampler,
   return (gfloat*)(buffer_ptr+sof);
 }
 
+gboolean
+gegl_sampler_prefetch (GeglSampler   *sampler,
+                       const gdouble *coords,
+                       gint           n_points)
+{
+  const gint    maximum_width_and_height = 64;
+  GeglRectangle area;
+  gdouble       min_x, min_y;
+  gdouble       max_x, max_y;
+  gint          i;
+
+  if (n_points < 1)
+    return FALSE;
+
+  min_x = max_x = coords[0];
+  min_y = max_y = coords[1];
+  for (i = 1; i < n_points; i++)
+    {
+      min_x = MIN (min_x, coords[i * 2]);
+      max_x = MAX (max_x, coords[i * 2]);
+      min_y = MIN (min_y, coords[i * 2 + 1]);
+      max_y = MAX (max_y, coords[i * 2 + 1]);
+    }
+
+  /* also rejects NaNs and positions far outside of the integer range */
+  if (!(max_x - min_x < maximum_width_and_height &&
+        max_y - min_y < maximum_width_and_height &&
+        min_x > -1e8 && max_x < 1e8 &&
+        min_y > -1e8 && max_y < 1e8))
+    return FALSE;
+
+  /*
+   * The samplers round the coordinates differently, one pixel of slack on
+   * either side covers all of them:
+   */
+  area.x      = (gint) floor (min_x) - 1 + sampler->context_rect[0].x;
+  area.y      = (gint) floor (min_y) - 1 + sampler->context_rect[0].y;
+  area.width  = (gint) floor (max_x) - (gint) floor (min_x) + 2 +
+                sampler->context_rect[0].width;
+  area.height = (gint) floor (max_y) - (gint) floor (min_y) + 2 +
+                sampler->context_rect[0].height;
+
+  if (area.width  > maximum_width_and_height ||
+      area.height > maximum_width_and_height)
+    return FALSE;
+
+  if (sampler->sampler_buffer[0] == NULL ||
+      !gegl_rectangle_contains (&sampler->sampler_rectangle[0], &area))
+    {
+      const gint bpp =
+        babl_format_get_bytes_per_pixel (sampler->interpolate_format);
+      GeglRectangle fetch_rectangle;
+
+      /* leave the same elbow room as gegl_sampler_get_ptr */
+      fetch_rectangle.x =
+        area.x - ( maximum_width_and_height - area.width  ) / 8;
+      fetch_rectangle.y =
+        area.y - ( maximum_width_and_height - area.height ) / 8;
+      fetch_rectangle.width  = maximum_width_and_height;
+      fetch_rectangle.height = maximum_width_and_height;
+
+      if (sampler->sampler_buffer[0] == NULL)
+        sampler->sampler_buffer[0] =
+          g_malloc0 (( maximum_width_and_height * maximum_width_and_height )
+                     * bpp);
+
+      gegl_buffer_get (sampler->buffer,
+                       &fetch_rectangle,
+                       1.0,
+                       sampler->interpolate_format,
+                       sampler->sampler_buffer[0],
+                       GEGL_AUTO_ROWSTRIDE,
+                       GEGL_ABYSS_NONE);
+
+      sampler->sampler_rectangle[0] = fetch_rectangle;
+    }
+
+  return TRUE;
+}
+
 gfloat *
 gegl_sampler_get_from_buffer (GeglSampler *const sampler,
                               const gint         x,
@@ -33,6 +33,11 @@ G_BEGIN_DECLS
 #define GEGL_SAMPLER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  GEGL_TYPE_SAMPLER, GeglSamplerClass))
 #define GEGL_SAMPLER_MIPMAP_LEVELS   3
 
+/* number of points the samplers interpolate before converting them to the
+ * output format in one go
+ */
+#define GEGL_SAMPLER_SPAN_CHUNK      32
+
 typedef struct _GeglSamplerClass GeglSamplerClass;
 
 struct _GeglSampler
@@ -59,7 +64,15 @@ struct _GeglSampler
   gdouble        x; /* mirrors the currently requested */
   gdouble        y; /* coordinates in the instance     */
 
-  gpointer       padding[8]; /* eat from the padding if adding to the struct */
+  /* cached like get, taken from the padding */
+  void (* get_points) (GeglSampler   *self,
+                       const gdouble *coords,
+                       GeglMatrix2   *scales,
+                       gint           scales_stride,
+                       gint           n_points,
+                       void          *output);
+
+  gpointer       padding[7]; /* eat from the padding if adding to the struct */
 };
 
 struct _GeglSamplerClass
@@ -74,8 +87,17 @@ struct _GeglSamplerClass
                       void        *output);
  void  (*set_buffer) (GeglSampler  *self,
                       GeglBuffer   *buffer);
-
- gpointer       padding[8]; /* eat from the padding if adding to the struct */
+  /* samples n_points (x,y) pairs from coords, the scale of point i is
+   * scales[i * scales_stride], scales may be NULL.
+   */
+  void (* get_points) (GeglSampler   *self,
+                       const gdouble *coords,
+                       GeglMatrix2   *scales,
+                       gint           scales_stride,
+                       gint           n_points,
+                       void          *output);
+
+ gpointer       padding[7]; /* eat from the padding if adding to the struct */
 };
 
 GType gegl_sampler_get_type    (void) G_GNUC_CONST;
@@ -92,6 +114,23 @@ void  gegl_sampler_get         (GeglSampler   *self,
                                 void          *output,
                                 GeglAbyssPolicy repeat_mode);
 
+void  gegl_sampler_get_span    (GeglSampler   *self,
+                                gdouble        x,
+                                gdouble        y,
+                                gdouble        w,
+                                gdouble        dx,
+                                gdouble        dy,
+                                gdouble        dw,
+                                gint           n_points,
+                                GeglMatrix2   *scale,
+                                void          *output);
+
+void  gegl_sampler_get_points  (GeglSampler   *self,
+                                const gdouble *coords,
+                                GeglMatrix2   *scales,
+                                gint           n_points,
+                                void          *output);
+
 gfloat * gegl_sampler_get_from_buffer (GeglSampler *sampler,
                                        gint         x,
                                        gint         y);
@@ -104,6 +143,29 @@ gegl_sampler_get_ptr (GeglSampler         *sampler,
                       gint                 x,
                       gint                 y);
 
+/* Makes the level 0 sampler buffer hold the context of all the n_points
+ * positions in coords, returns FALSE if they are too far apart to fit in
+ * it. After it succeeded the pixels can be reached with
+ * gegl_sampler_get_ptr_unchecked ().
+ */
+gboolean gegl_sampler_prefetch (GeglSampler         *sampler,
+                                const gdouble       *coords,
+                                gint                 n_points);
+
+/* like gegl_sampler_get_ptr without checking that the sampler buffer holds
+ * the context of x,y; all the interpolation formats have four channels.
+ */
+static inline gfloat *
+gegl_sampler_get_ptr_unchecked (GeglSampler *sampler,
+                                gint         x,
+                                gint         y)
+{
+  return (gfloat *) sampler->sampler_buffer[0] +
+         ((x - sampler->sampler_rectangle[0].x) +
+          (y - sampler->sampler_rectangle[0].y) *
+          sampler->sampler_rectangle[0].width) * 4;
+}
+
 G_END_DECLS
 
 #endif /* __GEGL_SAMPLER_H__ */
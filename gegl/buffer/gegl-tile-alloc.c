@@ -0,0 +1,495 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define USE_MMAP
+#include <sys/mman.h>
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-utils.h"
+#include "gegl-buffer.h"
+#include "gegl-tile-alloc.h"
+
+#define HEADER_SIZE     16                /* keeps the data 16 byte aligned */
+#define SLAB_SIZE       (2 * 1024 * 1024) /* the size of a huge page on x86 */
+#define MIN_BLOCKS      4   /* blocks per slab at least */
+#define MAX_CLASSES     16  /* tile sizes served from slabs */
+#define MAX_EMPTY_SLABS 1   /* unused slabs kept per size class */
+#define CACHE_BLOCKS    4   /* free blocks kept per thread and size class */
+
+typedef struct _Slab      Slab;
+typedef struct _SizeClass SizeClass;
+
+/* precedes the data of every block */
+typedef union
+{
+  struct
+  {
+    Slab  *slab;   /* NULL when the block was not allocated from a slab */
+    gsize  size;
+  } info;
+  guchar pad[HEADER_SIZE];
+} BlockHeader;
+
+struct _Slab
+{
+  SizeClass *size_class;
+  guchar    *mem;
+  gint       n_used;     /* blocks that are not in free_list */
+  gpointer   free_list;  /* free blocks, linked through their first word */
+  GList      link;       /* in size_class->available */
+};
+
+struct _SizeClass
+{
+  GStaticMutex  mutex;
+  gsize         size;
+  gsize         stride;
+  gint          n_blocks;    /* blocks per slab */
+  gsize         slab_size;
+  GQueue        available;   /* slabs with free blocks, unused slabs last */
+  gint          n_empty;
+  gint          n_slabs;
+  volatile gint n_allocated; /* blocks handed out */
+};
+
+typedef struct
+{
+  gpointer blocks[MAX_CLASSES][CACHE_BLOCKS];
+  gint     n_blocks[MAX_CLASSES];
+} ThreadCache;
+
+static SizeClass      size_classes[MAX_CLASSES];
+static volatile gint  n_size_classes     = 0;
+static GStaticMutex   size_classes_mutex = G_STATIC_MUTEX_INIT;
+static GStaticPrivate thread_cache_key   = G_STATIC_PRIVATE_INIT;
+
+static gboolean       use_huge_pages     = FALSE;
+
+/* blocks too big for a slab, or allocated when all size classes are taken */
+static GStaticMutex   large_mutex        = G_STATIC_MUTEX_INIT;
+static guint64        large_total        = 0;
+
+static guchar *
+slab_mem_alloc (gsize size)
+{
+#ifdef USE_MMAP
+  guchar *mem;
+
+  if (use_huge_pages)
+    {
+      guchar *map;
+
+      /* over allocate to be able to align the slab to a huge page */
+      map = mmap (NULL, size + SLAB_SIZE, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (map == MAP_FAILED)
+        return NULL;
+
+      mem = (guchar *) (((guintptr) map + SLAB_SIZE - 1) &
+                        ~((guintptr) SLAB_SIZE - 1));
+      if (mem > map)
+        munmap (map, mem - map);
+      if (map + SLAB_SIZE > mem)
+        munmap (mem + size, (map + SLAB_SIZE) - mem);
+#ifdef MADV_HUGEPAGE
+      madvise (mem, size, MADV_HUGEPAGE);
+#endif
+      return mem;
+    }
+
+  /* mapping the slabs directly makes sure freeing one returns its memory to
+   * the system, instead of leaving it to the heuristics of malloc
+   */
+  mem = mmap (NULL, size, PROT_READ | PROT_WRITE,
+              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return mem == MAP_FAILED ? NULL : mem;
+#else
+  return gegl_malloc (size);
+#endif
+}
+
+static void
+slab_mem_free (guchar *mem,
+               gsize   size)
+{
+#ifdef USE_MMAP
+  munmap (mem, size);
+#else
+  gegl_free (mem);
+#endif
+}
+
+/* called with the size class mutex held */
+static Slab *
+slab_new (SizeClass *size_class)
+{
+  Slab *slab;
+  gint  i;
+
+  slab = g_slice_new0 (Slab);
+  slab->mem = slab_mem_alloc (size_class->slab_size);
+  if (!slab->mem)
+    {
+      g_slice_free (Slab, slab);
+      return NULL;
+    }
+
+  slab->size_class = size_class;
+  slab->link.data  = slab;
+
+  for (i = size_class->n_blocks - 1; i >= 0; i--)
+    {
+      BlockHeader *header = (void *) (slab->mem + i * size_class->stride);
+      gpointer     data   = (guchar *) header + HEADER_SIZE;
+
+      header->info.slab = slab;
+      header->info.size = size_class->size;
+
+      *(gpointer *) data = slab->free_list;
+      slab->free_list    = data;
+    }
+
+  return slab;
+}
+
+static void
+slab_destroy (Slab *slab)
+{
+  slab_mem_free (slab->mem, slab->size_class->slab_size);
+  g_slice_free (Slab, slab);
+}
+
+static SizeClass *
+size_class_get (gsize size)
+{
+  SizeClass *size_class = NULL;
+  gint       n;
+  gint       i;
+
+  size = (size + HEADER_SIZE - 1) & ~((gsize) HEADER_SIZE - 1);
+  if (size > SLAB_SIZE)
+    return NULL;
+
+  n = g_atomic_int_get (&n_size_classes);
+  for (i = 0; i < n; i++)
+    if (size_classes[i].size == size)
+      return &size_classes[i];
+
+  g_static_mutex_lock (&size_classes_mutex);
+
+  /* another thread might have added it meanwhile */
+  n = g_atomic_int_get (&n_size_classes);
+  for (i = 0; i < n; i++)
+    if (size_classes[i].size == size)
+      size_class = &size_classes[i];
+
+  if (!size_class && n < MAX_CLASSES)
+    {
+      size_class = &size_classes[n];
+
+      g_static_mutex_init (&size_class->mutex);
+      g_queue_init (&size_class->available);
+      size_class->size      = size;
+      size_class->stride    = size + HEADER_SIZE;
+      size_class->n_blocks  = MAX (SLAB_SIZE / size_class->stride, MIN_BLOCKS);
+      size_class->slab_size = size_class->n_blocks * size_class->stride;
+      size_class->slab_size = (size_class->slab_size + SLAB_SIZE - 1) &
+                              ~((gsize) SLAB_SIZE - 1);
+
+      /* only make the size class visible once it is set up */
+      g_atomic_int_inc (&n_size_classes);
+    }
+
+  g_static_mutex_unlock (&size_classes_mutex);
+
+  return size_class;
+}
+
+static gpointer
+size_class_alloc (SizeClass *size_class)
+{
+  Slab     *slab;
+  gpointer  data;
+
+  g_static_mutex_lock (&size_class->mutex);
+
+  if (g_queue_is_empty (&size_class->available))
+    {
+      slab = slab_new (size_class);
+      if (!slab)
+        {
+          g_static_mutex_unlock (&size_class->mutex);
+          return NULL;
+        }
+      g_queue_push_tail_link (&size_class->available, &slab->link);
+      size_class->n_empty++;
+      size_class->n_slabs++;
+    }
+
+  /* partially used slabs are at the head, filling them first leaves the
+   * unused ones free to be released
+   */
+  slab = size_class->available.head->data;
+
+  data            = slab->free_list;
+  slab->free_list = *(gpointer *) data;
+
+  if (slab->n_used++ == 0)
+    size_class->n_empty--;
+  if (!slab->free_list)
+    g_queue_unlink (&size_class->available, &slab->link);
+
+  g_static_mutex_unlock (&size_class->mutex);
+
+  return data;
+}
+
+static void
+size_class_free (SizeClass *size_class,
+                 gpointer   data)
+{
+  BlockHeader *header  = (void *) ((guchar *) data - HEADER_SIZE);
+  Slab        *slab    = header->info.slab;
+  Slab        *release = NULL;
+
+  g_static_mutex_lock (&size_class->mutex);
+
+  if (!slab->free_list)
+    g_queue_push_head_link (&size_class->available, &slab->link);
+
+  *(gpointer *) data = slab->free_list;
+  slab->free_list    = data;
+
+  if (--slab->n_used == 0)
+    {
+      g_queue_unlink (&size_class->available, &slab->link);
+
+      if (size_class->n_empty >= MAX_EMPTY_SLABS)
+        {
+          size_class->n_slabs--;
+          release = slab;
+        }
+      else
+        {
+          g_queue_push_tail_link (&size_class->available, &slab->link);
+          size_class->n_empty++;
+        }
+    }
+
+  g_static_mutex_unlock (&size_class->mutex);
+
+  if (release)
+    slab_destroy (release);
+}
+
+static void
+thread_cache_flush (ThreadCache *cache)
+{
+  gint i;
+
+  for (i = 0; i < MAX_CLASSES; i++)
+    while (cache->n_blocks[i])
+      size_class_free (&size_classes[i],
+                       cache->blocks[i][--cache->n_blocks[i]]);
+}
+
+static void
+thread_cache_free (gpointer data)
+{
+  thread_cache_flush (data);
+  g_free (data);
+}
+
+static ThreadCache *
+thread_cache (void)
+{
+  ThreadCache *cache = g_static_private_get (&thread_cache_key);
+
+  if (G_UNLIKELY (!cache))
+    {
+      cache = g_new0 (ThreadCache, 1);
+      g_static_private_set (&thread_cache_key, cache, thread_cache_free);
+    }
+  return cache;
+}
+
+gpointer
+gegl_tile_alloc (gsize size)
+{
+  SizeClass   *size_class = size_class_get (size);
+  BlockHeader *header;
+
+  if (size_class)
+    {
+      ThreadCache *cache = thread_cache ();
+      gint         no    = size_class - size_classes;
+      gpointer     data;
+
+      if (cache->n_blocks[no])
+        data = cache->blocks[no][--cache->n_blocks[no]];
+      else
+        data = size_class_alloc (size_class);
+
+      if (data)
+        {
+          g_atomic_int_inc (&size_class->n_allocated);
+          return data;
+        }
+    }
+
+  header = gegl_malloc (size + HEADER_SIZE);
+  header->info.slab = NULL;
+  header->info.size = size;
+
+  g_static_mutex_lock (&large_mutex);
+  large_total += size;
+  g_static_mutex_unlock (&large_mutex);
+
+  return (guchar *) header + HEADER_SIZE;
+}
+
+void
+gegl_tile_free (gpointer data)
+{
+  BlockHeader *header = (void *) ((guchar *) data - HEADER_SIZE);
+  SizeClass   *size_class;
+  ThreadCache *cache;
+  gint         no;
+
+  if (!header->info.slab)
+    {
+      g_static_mutex_lock (&large_mutex);
+      large_total -= header->info.size;
+      g_static_mutex_unlock (&large_mutex);
+
+      gegl_free (header);
+      return;
+    }
+
+  size_class = header->info.slab->size_class;
+  no         = size_class - size_classes;
+  cache      = thread_cache ();
+
+  g_atomic_int_add (&size_class->n_allocated, -1);
+
+  /* keep half of the cached blocks to not bounce between the thread cache
+   * and the slabs
+   */
+  if (cache->n_blocks[no] == CACHE_BLOCKS)
+    while (cache->n_blocks[no] > CACHE_BLOCKS / 2)
+      size_class_free (size_class, cache->blocks[no][--cache->n_blocks[no]]);
+
+  cache->blocks[no][cache->n_blocks[no]++] = data;
+}
+
+void
+gegl_tile_alloc_set_huge_pages (gboolean huge_pages)
+{
+  use_huge_pages = huge_pages;
+}
+
+guint64
+gegl_tile_alloc_trim (void)
+{
+  guint64 released = 0;
+  gint    n;
+  gint    i;
+
+  /* the blocks cached by other threads stay in use until those threads
+   * free more tiles or exit
+   */
+  thread_cache_flush (thread_cache ());
+
+  n = g_atomic_int_get (&n_size_classes);
+  for (i = 0; i < n; i++)
+    {
+      SizeClass *size_class = &size_classes[i];
+      GSList    *unused     = NULL;
+      GSList    *iter;
+
+      g_static_mutex_lock (&size_class->mutex);
+      while (size_class->available.tail &&
+             ((Slab *) size_class->available.tail->data)->n_used == 0)
+        {
+          Slab *slab = size_class->available.tail->data;
+
+          g_queue_unlink (&size_class->available, &slab->link);
+          size_class->n_empty--;
+          size_class->n_slabs--;
+          unused = g_slist_prepend (unused, slab);
+        }
+      g_static_mutex_unlock (&size_class->mutex);
+
+      for (iter = unused; iter; iter = iter->next)
+        {
+          released += size_class->slab_size;
+          slab_destroy (iter->data);
+        }
+      g_slist_free (unused);
+    }
+
+  return released;
+}
+
+void
+gegl_tile_alloc_get_stats (guint64 *reserved,
+                           guint64 *in_use)
+{
+  guint64 total_reserved;
+  guint64 total_in_use;
+  gint    n;
+  gint    i;
+
+  g_static_mutex_lock (&large_mutex);
+  total_reserved = total_in_use = large_total;
+  g_static_mutex_unlock (&large_mutex);
+
+  n = g_atomic_int_get (&n_size_classes);
+  for (i = 0; i < n; i++)
+    {
+      SizeClass *size_class = &size_classes[i];
+
+      g_static_mutex_lock (&size_class->mutex);
+      total_reserved += (guint64) size_class->n_slabs * size_class->slab_size;
+      g_static_mutex_unlock (&size_class->mutex);
+
+      total_in_use += (guint64) g_atomic_int_get (&size_class->n_allocated) *
+                      size_class->size;
+    }
+
+  if (reserved)
+    *reserved = total_reserved;
+  if (in_use)
+    *in_use = total_in_use;
+}
+
+void
+gegl_buffer_tile_memory_get_stats (guint64 *reserved,
+                                   guint64 *in_use)
+{
+  gegl_tile_alloc_get_stats (reserved, in_use);
+}
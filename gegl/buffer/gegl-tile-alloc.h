@@ -0,0 +1,47 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_ALLOC_H__
+#define __GEGL_TILE_ALLOC_H__
+
+#include <glib.h>
+
+/***
+ * The tile allocator hands out the pixel data of tiles. Blocks of the same
+ * size are carved out of large slabs, recently freed blocks are kept in
+ * per thread free lists, and slabs that have no blocks in use are returned
+ * to the system.
+ */
+
+/* allocates size bytes, 16 byte aligned, to be freed with gegl_tile_free () */
+gpointer gegl_tile_alloc                (gsize     size);
+void     gegl_tile_free                 (gpointer  data);
+
+/* back slabs allocated from now on with huge pages, where supported */
+void     gegl_tile_alloc_set_huge_pages (gboolean  huge_pages);
+
+/* returns the memory of all unused slabs to the system, returns the number
+ * of bytes released
+ */
+guint64  gegl_tile_alloc_trim           (void);
+
+/* reserved is the number of bytes obtained from the system, in_use the number
+ * of bytes currently allocated to tiles
+ */
+void     gegl_tile_alloc_get_stats      (guint64  *reserved,
+                                         guint64  *in_use);
+
+#endif
@@ -26,6 +26,11 @@
 #include <string.h>
 #include <errno.h>
 
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+#define USE_MMAP
+#include <sys/mman.h>
+#endif
+
 #include <glib-object.h>
 #include <glib/gprintf.h>
 #include <glib/gstdio.h>
@@ -35,6 +40,8 @@
 #include "gegl-tile-backend-file.h"
 #include "gegl-buffer-index.h"
 #include "gegl-buffer-types.h"
+#include "gegl-tile.h"
+#include "gegl-config.h"
 #include "gegl-debug.h"
 //#include "gegl-types-internal.h"
 
@@ -86,7 +93,17 @@ struct _GeglTileBackendFile
    */
   GeglBufferHeader header;
 
-  gint            foffset;
+  /* current offset of i */
+  gint             foffset;
+
+  /* current offset of o, only valid while no tiles are queued for writing */
+  gint             woffset;
+
+  /* number of tile writes queued or in progress, and the most recent write
+   * of each entry that has one, both protected by the writer mutex
+   */
+  gint             pending_ops;
+  GHashTable      *pending;
 
   /* current offset, used when writing the index */
   gint             offset;
@@ -109,6 +126,23 @@ struct _GeglTileBackendFile
 
   /* for reading */
   int              i;
+
+#ifdef USE_MMAP
+  /* read only mapping of i, tiles are copied out of it instead of being
+   * read with lseek and read, leaving the caching to the page cache.
+   * map_failed is set when the file could not be mapped, in which case
+   * tiles are read the old way. Tiles are copied with map_lock held for
+   * reading, the mapping is only replaced with it held for writing.
+   */
+  GStaticRWLock    map_lock;
+  guchar          *map;
+  gsize            map_size;
+  gboolean         map_failed;
+
+  /* the part of the file readahead was last requested for */
+  guint64          readahead_start;
+  guint64          readahead_end;
+#endif
 };
 
 
@@ -117,7 +151,334 @@ static gboolean gegl_tile_backend_file_write_block  (GeglTileBackendFile *self,
                                                      GeglBufferBlock     *block);
 static void     gegl_tile_backend_file_dbg_alloc    (int                  size);
 static void     gegl_tile_backend_file_dbg_dealloc  (int                  size);
+static void     gegl_tile_backend_file_finish_writing (GeglTileBackendFile *self);
+#ifdef USE_MMAP
+static gboolean gegl_tile_backend_file_map          (GeglTileBackendFile *self,
+                                                     guint64              size);
+#endif
+
+
+/* Tile data is written to the swap by a single writer thread shared by all
+ * file backends, so evicting a tile from the cache does not stall the
+ * evicting thread on disk I/O. set_tile() only queues a copy-on-write
+ * duplicate of the tile, the writer thread writes runs of queued tiles that
+ * are adjacent in the same file with a single seek. Tiles that are read
+ * back while still queued are copied from the queue. The header and the
+ * index are still written synchronously, after the queued tiles of the file
+ * have been written.
+ */
+
+#define MAX_WRITE_RUN 32 /* max number of adjacent tiles written at once */
+
+#define READAHEAD_SIZE (1024 * 1024) /* bytes of swap to read ahead of a tile */
+
+typedef struct
+{
+  GeglTileBackendFile *file;
+  GeglBufferTile      *entry;  /* NULL when the entry has been voided */
+  GeglTile            *tile;   /* a duplicate sharing the data of the tile */
+  guint64              offset;
+  gint                 length;
+  gboolean             queued; /* FALSE once the writer has picked it up */
+} GeglFileWrite;
+
+static GMutex  *writer_mutex      = NULL;
+static GCond   *writer_queue_cond = NULL; /* signalled when writes are queued */
+static GCond   *writer_done_cond  = NULL; /* signalled when writes are done */
+static GQueue   writer_queue      = G_QUEUE_INIT;
+static gint     writer_queue_size = 0;    /* bytes of queued tiles */
+static GThread *writer_thread     = NULL;
+static gboolean writer_quit       = FALSE;
+
+static void
+gegl_tile_backend_file_write_run (GeglFileWrite **run,
+                                  gint            n)
+{
+  GeglTileBackendFile *self = run[0]->file;
+  gint                 i;
+
+  if (lseek (self->o, run[0]->offset, SEEK_SET) < 0)
+    {
+      g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
+      return;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      guchar *source        = gegl_tile_get_data (run[i]->tile);
+      gint    to_be_written = run[i]->length;
+
+      while (to_be_written > 0)
+        {
+          gint wrote;
+          wrote = write (self->o,
+                         source + run[i]->length - to_be_written,
+                         to_be_written);
+          if (wrote <= 0)
+            {
+              g_message ("unable to write tile data to self: "
+                         "%s (%d/%d bytes written)",
+                         g_strerror (errno), wrote, to_be_written);
+              return;
+            }
+          to_be_written -= wrote;
+        }
+    }
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "wrote %i tiles at %i", n, (gint)run[0]->offset);
+}
+
+static gpointer
+gegl_tile_backend_file_writer_thread (gpointer data)
+{
+  while (TRUE)
+    {
+      GeglFileWrite *run[MAX_WRITE_RUN];
+      GeglFileWrite *next;
+      gint           n = 0;
+      gint           i;
+
+      g_mutex_lock (writer_mutex);
+
+      while (g_queue_is_empty (&writer_queue) && !writer_quit)
+        g_cond_wait (writer_queue_cond, writer_mutex);
+
+      if (g_queue_is_empty (&writer_queue))
+        {
+          g_mutex_unlock (writer_mutex);
+          break;
+        }
+
+      /* take along the following writes as long as they continue where
+       * the previous one ends
+       */
+      run[n++] = g_queue_pop_head (&writer_queue);
+      while (n < MAX_WRITE_RUN &&
+             (next = g_queue_peek_head (&writer_queue)) &&
+             next->file == run[0]->file &&
+             next->offset == run[n - 1]->offset + run[n - 1]->length)
+        run[n++] = g_queue_pop_head (&writer_queue);
+
+      for (i = 0; i < n; i++)
+        run[i]->queued = FALSE;
+
+      g_mutex_unlock (writer_mutex);
+
+      gegl_tile_backend_file_write_run (run, n);
+
+      g_mutex_lock (writer_mutex);
+
+      for (i = 0; i < n; i++)
+        {
+          GeglTileBackendFile *self = run[i]->file;
+
+          if (run[i]->entry &&
+              g_hash_table_lookup (self->pending, run[i]->entry) == run[i])
+            g_hash_table_remove (self->pending, run[i]->entry);
+
+          self->pending_ops--;
+          writer_queue_size -= run[i]->length;
+        }
+      g_cond_broadcast (writer_done_cond);
+
+      g_mutex_unlock (writer_mutex);
+
+      for (i = 0; i < n; i++)
+        {
+          gegl_tile_unref (run[i]->tile);
+          g_slice_free (GeglFileWrite, run[i]);
+        }
+    }
+
+  return NULL;
+}
+
+/* set_tile() is called by the cache while it holds its locks and never
+ * waits for the writer thread, so the queue can grow past queue-size. This
+ * is called by the cache once it has released its locks, and waits until
+ * the queue is back within queue-size.
+ */
+void
+gegl_tile_backend_file_throttle (void)
+{
+  if (!writer_mutex)
+    return;
+
+  g_mutex_lock (writer_mutex);
+  while (writer_queue_size > gegl_config ()->queue_size && writer_thread)
+    g_cond_wait (writer_done_cond, writer_mutex);
+  g_mutex_unlock (writer_mutex);
+}
+
+/* writes out the queued tiles and stops the writer thread */
+void
+gegl_tile_backend_file_cleanup (void)
+{
+  if (!writer_thread)
+    return;
+
+  g_mutex_lock (writer_mutex);
+  writer_quit = TRUE;
+  g_cond_signal (writer_queue_cond);
+  g_mutex_unlock (writer_mutex);
+
+  g_thread_join (writer_thread);
+
+  g_mutex_lock (writer_mutex);
+  writer_thread = NULL;
+  writer_quit   = FALSE;
+  g_cond_broadcast (writer_done_cond);
+  g_mutex_unlock (writer_mutex);
+}
+
+/* waits until all tiles queued for self are written */
+static void
+gegl_tile_backend_file_finish_writing (GeglTileBackendFile *self)
+{
+  g_mutex_lock (writer_mutex);
+  while (self->pending_ops > 0)
+    g_cond_wait (writer_done_cond, writer_mutex);
+  g_mutex_unlock (writer_mutex);
+
+  /* the writer thread has moved o */
+  self->woffset = -1;
+}
+
+/* drops a queued write of entry, which is about to be destroyed */
+static void
+gegl_tile_backend_file_cancel_write (GeglTileBackendFile *self,
+                                     GeglBufferTile      *entry)
+{
+  GeglFileWrite *op;
+
+  g_mutex_lock (writer_mutex);
+
+  op = g_hash_table_lookup (self->pending, entry);
+  if (op)
+    {
+      g_hash_table_remove (self->pending, entry);
+      op->entry = NULL;
+
+      if (op->queued)
+        {
+          g_queue_remove (&writer_queue, op);
+          self->pending_ops--;
+          writer_queue_size -= op->length;
+          g_cond_broadcast (writer_done_cond);
+        }
+      else
+        {
+          op = NULL; /* being written, the writer thread frees it */
+        }
+    }
+
+  g_mutex_unlock (writer_mutex);
+
+  if (op)
+    {
+      gegl_tile_unref (op->tile);
+      g_slice_free (GeglFileWrite, op);
+    }
+}
+
+
+#ifdef USE_MMAP
+/* makes sure at least size bytes of the file are mapped, the file only
+ * grows so the mapping is only replaced when it is too small. Must be
+ * called with map_lock held for writing.
+ */
+static gboolean
+gegl_tile_backend_file_map (GeglTileBackendFile *self,
+                            guint64              size)
+{
+  struct stat st;
+
+  if (self->map && self->map_size >= size)
+    return TRUE;
+
+  if (self->map_failed)
+    return FALSE;
+
+  if (fstat (self->i, &st) != 0 || st.st_size < size)
+    return FALSE;
+
+  if (self->map)
+    munmap (self->map, self->map_size);
+
+  self->map = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, self->i, 0);
+  if (self->map == MAP_FAILED)
+    {
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "unable to map %s: %s", self->path, g_strerror (errno));
+      self->map        = NULL;
+      self->map_size   = 0;
+      self->map_failed = TRUE;
+      return FALSE;
+    }
+  self->map_size        = st.st_size;
+  self->readahead_start = 0;
+  self->readahead_end   = 0;
+
+  return TRUE;
+}
+
+/* copies a tile out of the mapping, with map_lock held */
+static void
+gegl_tile_backend_file_map_copy (GeglTileBackendFile *self,
+                                 goffset              offset,
+                                 guchar              *dest,
+                                 gint                 tile_size)
+{
+#ifdef MADV_WILLNEED
+  /* ask for the following tiles to be read in ahead of time, tiles
+   * are usually fetched in the order they are stored
+   */
+  if (offset < self->readahead_start ||
+      offset + tile_size > self->readahead_end)
+    {
+      gsize page  = sysconf (_SC_PAGESIZE);
+      gsize start = offset - offset % page;
+      gsize end   = MIN (offset + READAHEAD_SIZE, self->map_size);
+
+      madvise (self->map + start, end - start, MADV_WILLNEED);
+      self->readahead_start = start;
+      self->readahead_end   = end;
+    }
+#endif
+  memcpy (dest, self->map + offset, tile_size);
+}
+
+/* reads a tile through the mapping, returns FALSE when the file can not
+ * be mapped
+ */
+static gboolean
+gegl_tile_backend_file_map_read (GeglTileBackendFile *self,
+                                 goffset              offset,
+                                 guchar              *dest,
+                                 gint                 tile_size)
+{
+  gboolean mapped;
 
+  g_static_rw_lock_reader_lock (&self->map_lock);
+  mapped = self->map && self->map_size >= offset + tile_size;
+  if (mapped)
+    gegl_tile_backend_file_map_copy (self, offset, dest, tile_size);
+  g_static_rw_lock_reader_unlock (&self->map_lock);
+
+  if (mapped || self->map_failed)
+    return mapped;
+
+  /* the file has grown, the mapping is replaced when no other thread is
+   * copying out of it
+   */
+  g_static_rw_lock_writer_lock (&self->map_lock);
+  mapped = gegl_tile_backend_file_map (self, offset + tile_size);
+  if (mapped)
+    gegl_tile_backend_file_map_copy (self, offset, dest, tile_size);
+  g_static_rw_lock_writer_unlock (&self->map_lock);
+
+  return mapped;
+}
+#endif
 
 static inline void
 gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
@@ -132,6 +493,31 @@ gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
 
   gegl_tile_backend_file_ensure_exist (self);
 
+  if (self->pending_ops > 0)
+    {
+      GeglFileWrite *op;
+
+      g_mutex_lock (writer_mutex);
+      op = g_hash_table_lookup (self->pending, entry);
+      if (op)
+        memcpy (dest, gegl_tile_get_data (op->tile), tile_size);
+      g_mutex_unlock (writer_mutex);
+
+      if (op)
+        {
+          GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "read entry %i,%i,%i from write queue", entry->x, entry->y, entry->z);
+          return;
+        }
+    }
+
+#ifdef USE_MMAP
+  if (gegl_tile_backend_file_map_read (self, offset, dest, tile_size))
+    {
+      GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "read entry %i,%i,%i at %i from map", entry->x, entry->y, entry->z, (gint)offset);
+      return;
+    }
+#endif
+
   if (self->foffset != offset)
     {
       success = (lseek (self->i, offset, SEEK_SET) >= 0);
@@ -168,47 +554,54 @@ gegl_tile_backend_file_file_entry_read (GeglTileBackendFile *self,
 static inline void
 gegl_tile_backend_file_file_entry_write (GeglTileBackendFile *self,
                                          GeglBufferTile      *entry,
-                                         guchar              *source)
+                                         GeglTile            *tile)
 {
-  gint     to_be_written;
-  gboolean success;
-  goffset  offset = entry->offset;
-  gint     tile_size;
+  GeglFileWrite *op;
+  GeglTile      *old_tile = NULL;
+  gint           tile_size;
 
   gegl_tile_backend_file_ensure_exist (self);
 
-  if (self->foffset != offset)
-    {
-      success = (lseek (self->o, offset, SEEK_SET) >= 0);
-      if (success == FALSE)
-        {
-          g_warning ("unable to seek to tile in buffer: %s", g_strerror (errno));
-          return;
-        }
-      self->foffset = offset;
-    }
-
   tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (self));
 
-  to_be_written = tile_size;
+  g_mutex_lock (writer_mutex);
 
-  while (to_be_written > 0)
+  op = g_hash_table_lookup (self->pending, entry);
+  if (op && op->queued)
     {
-      gint wrote;
-      wrote = write (self->o,
-                     source + tile_size - to_be_written,
-                     to_be_written);
-      if (wrote <= 0)
-        {
-          g_message ("unable to write tile data to self: "
-                     "%s (%d/%d bytes written)",
-                     g_strerror (errno), wrote, to_be_written);
-          return;
-        }
-      to_be_written -= wrote;
-      self->foffset += wrote;
+      /* the previous revision was not written yet, write this one instead */
+      old_tile = op->tile;
+      op->tile = gegl_tile_dup (tile);
     }
-  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "wrote entry %i,%i,%i at %i", entry->x, entry->y, entry->z, (gint)offset);
+  else
+    {
+      op = g_slice_new (GeglFileWrite);
+      op->file   = self;
+      op->entry  = entry;
+      op->tile   = gegl_tile_dup (tile);
+      op->offset = entry->offset;
+      op->length = tile_size;
+      op->queued = TRUE;
+
+      g_hash_table_insert (self->pending, entry, op);
+      self->pending_ops++;
+      writer_queue_size += tile_size;
+
+      g_queue_push_tail (&writer_queue, op);
+      g_cond_signal (writer_queue_cond);
+
+      /* started on the first write, stopped by gegl_exit() */
+      if (!writer_thread)
+        writer_thread = g_thread_create (gegl_tile_backend_file_writer_thread,
+                                         NULL, TRUE, NULL);
+    }
+
+  g_mutex_unlock (writer_mutex);
+
+  if (old_tile)
+    gegl_tile_unref (old_tile);
+
+  GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "queued entry %i,%i,%i at %i", entry->x, entry->y, entry->z, (gint)entry->offset);
 }
 
 static inline GeglBufferTile *
@@ -262,6 +655,8 @@ gegl_tile_backend_file_file_entry_destroy (GeglBufferTile      *entry,
 {
   /* XXX: EEEk, throwing away bits */
   guint offset = entry->offset;
+
+  gegl_tile_backend_file_cancel_write (self, entry);
   self->free_list = g_slist_prepend (self->free_list,
                                      GUINT_TO_POINTER (offset));
   g_hash_table_remove (self->index, entry);
@@ -276,6 +671,7 @@ gegl_tile_backend_file_write_header (GeglTileBackendFile *self)
   gboolean success;
 
   gegl_tile_backend_file_ensure_exist (self);
+  gegl_tile_backend_file_finish_writing (self);
 
   success = (lseek (self->o, 0, SEEK_SET) != -1);
   if (success == FALSE)
@@ -284,7 +680,7 @@ gegl_tile_backend_file_write_header (GeglTileBackendFile *self)
       return FALSE;
     }
   write (self->o, &(self->header), 256);
-  self->foffset = 256;
+  self->woffset = 256;
   GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "Wrote header, next=%i", (gint)self->header.next);
   return TRUE;
 }
@@ -306,12 +702,12 @@ gegl_tile_backend_file_write_block (GeglTileBackendFile *self,
       else
           self->in_holding->next = next_allocation;
 
-      if (self->foffset != self->offset)
+      if (self->woffset != self->offset)
       {
         if(lseek (self->o, self->offset, G_SEEK_SET) == -1)
           goto fail;
 
-        self->foffset = self->offset;
+        self->woffset = self->offset;
       }
 
       /* XXX: should promiscuosuly try to compress here as well,. if revisions
@@ -329,7 +725,7 @@ gegl_tile_backend_file_write_block (GeglTileBackendFile *self,
         if(written != -1)
           {
             self->offset += written;
-            self->foffset += written;
+            self->woffset += written;
           }
       }
 
@@ -347,12 +743,12 @@ gegl_tile_backend_file_write_block (GeglTileBackendFile *self,
                                             * of file, worry about writing
                                             * header inside free list later
                                             */
-      if (self->foffset != self->offset)
+      if (self->woffset != self->offset)
       {
         if(lseek (self->o, self->offset, G_SEEK_SET) == -1)
           goto fail;
 
-        self->foffset = self->offset;
+        self->woffset = self->offset;
       }
     }
   self->in_holding = block;
@@ -471,7 +867,7 @@ gegl_tile_backend_file_set_tile (GeglTileSource *self,
     }
   entry->rev = gegl_tile_get_rev (tile);
 
-  gegl_tile_backend_file_file_entry_write (tile_backend_file, entry, gegl_tile_get_data (tile));
+  gegl_tile_backend_file_file_entry_write (tile_backend_file, entry, tile);
   gegl_tile_mark_as_stored (tile);
   return NULL;
 }
@@ -533,6 +929,7 @@ gegl_tile_backend_file_flush (GeglTileSource *source,
   self     = GEGL_TILE_BACKEND_FILE (backend);
 
   gegl_tile_backend_file_ensure_exist (self);
+  gegl_tile_backend_file_finish_writing (self);
 
   GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "flushing %s", self->path);
 
@@ -655,9 +1052,20 @@ gegl_tile_backend_file_finalize (GObject *object)
 {
   GeglTileBackendFile *self = (GeglTileBackendFile *) object;
 
+  gegl_tile_backend_file_finish_writing (self);
+
+  if (self->pending)
+    g_hash_table_unref (self->pending);
+
   if (self->index)
     g_hash_table_unref (self->index);
 
+#ifdef USE_MMAP
+  if (self->map)
+    munmap (self->map, self->map_size);
+  g_static_rw_lock_free (&self->map_lock);
+#endif
+
   if (self->exist)
     {
       GEGL_NOTE (GEGL_DEBUG_TILE_BACKEND, "finalizing buffer %s", self->path);
@@ -854,6 +1262,7 @@ gegl_tile_backend_file_constructor (GType                  type,
   self->file = g_file_new_for_commandline_arg (self->path);
   self->i = self->o = -1;
   self->index = g_hash_table_new (gegl_tile_backend_file_hashfunc, gegl_tile_backend_file_equalfunc);
+  self->pending = g_hash_table_new (NULL, NULL);
 
 
   /* If the file already exists open it, assuming it is a GeglBuffer. */
@@ -883,7 +1292,10 @@ gegl_tile_backend_file_constructor (GType                  type,
           if (self->o == -1)
             g_warning ("%s: Could not open '%s': %s", G_STRFUNC, self->path, g_strerror (errno));
         }
-      self->i = dup (self->o);
+      /* a separate file description for reading, the writer thread
+       * moves the offset of o
+       */
+      self->i = g_open (self->path, O_RDONLY, 0);
 
       self->header = gegl_buffer_read_header (self->i, &offset)->header;
       self->header.rev = self->header.rev -1;
@@ -948,9 +1360,8 @@ gegl_tile_backend_file_ensure_exist (GeglTileBackendFile *self)
                                backend->priv->format
                                );
       gegl_tile_backend_file_write_header (self);
-      self->foffset       = 256;
       fsync (self->o);
-      self->i = dup (self->o);
+      self->i = g_open (self->path, O_RDONLY, 0);
 
       /*self->i = G_INPUT_STREAM (g_file_read (self->file, NULL, NULL));*/
       self->next_pre_alloc = 256;  /* reserved space for header */
@@ -975,6 +1386,10 @@ gegl_tile_backend_file_class_init (GeglTileBackendFileClass *klass)
 
   GEGL_BUFFER_STRUCT_CHECK_PADDING;
 
+  writer_mutex      = g_mutex_new ();
+  writer_queue_cond = g_cond_new ();
+  writer_done_cond  = g_cond_new ();
+
   g_object_class_install_property (gobject_class, PROP_PATH,
                                    g_param_spec_string ("path",
                                                         "path",
@@ -993,7 +1408,16 @@ gegl_tile_backend_file_init (GeglTileBackendFile *self)
   self->i              = -1;
   self->o              = -1;
   self->index          = NULL;
+  self->pending        = NULL;
+  self->pending_ops    = 0;
+  self->woffset        = -1;
   self->free_list      = NULL;
+#ifdef USE_MMAP
+  g_static_rw_lock_init (&self->map_lock);
+  self->map            = NULL;
+  self->map_size       = 0;
+  self->map_failed     = FALSE;
+#endif
   self->next_pre_alloc = 256;  /* reserved space for header */
   self->total          = 256;  /* reserved space for header */
 }
@@ -51,6 +51,9 @@ void  gegl_tile_backend_file_stats    (void);
 gboolean gegl_tile_backend_file_try_lock (GeglTileBackendFile *file);
 gboolean gegl_tile_backend_file_unlock   (GeglTileBackendFile *file);
 
+void     gegl_tile_backend_file_throttle (void);
+void     gegl_tile_backend_file_cleanup  (void);
+
 G_END_DECLS
 
 #endif
@@ -25,6 +25,7 @@
 #include "gegl-buffer-backend.h"
 #include "gegl-tile-backend.h"
 #include "gegl-tile-backend-ram.h"
+#include "gegl-tile-compression.h"
 
 static void dbg_alloc (int size);
 static void dbg_dealloc (int size);
@@ -37,6 +38,8 @@ struct _RamEntry
   gint    y;
   gint    z;
   guchar *offset;
+  gint    size;                            /* bytes stored at offset */
+  const GeglTileCompression *compression;  /* NULL when stored as is */
 };
 
 static inline void
@@ -45,28 +48,94 @@ ram_entry_read (GeglTileBackendRam *ram,
                 guchar             *dest)
 {
   gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
+  gint bpp       = babl_format_get_bytes_per_pixel (
+                     gegl_tile_backend_get_format (GEGL_TILE_BACKEND (ram)));
+
+  if (entry->compression)
+    {
+      if (!gegl_tile_compression_decompress (entry->compression,
+                                             entry->offset, entry->size,
+                                             dest, tile_size / bpp, bpp))
+        {
+          g_warning ("unable to decompress tile %i,%i,%i",
+                     entry->x, entry->y, entry->z);
+          memset (dest, 0, tile_size);
+        }
+      return;
+    }
 
   memcpy (dest, entry->offset, tile_size);
 }
 
+/* the tile data is kept compressed when the default tile compression
+ * makes it at least a quarter smaller, tiles are only stored here when
+ * they are evicted from the cache, so this only affects tiles that
+ * have gone cold.
+ */
 static inline void
 ram_entry_write (GeglTileBackendRam *ram,
                  RamEntry           *entry,
                  guchar             *source)
 {
-  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
+  const GeglTileCompression *compression = gegl_tile_compression_get_default ();
+  gint    tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
+  gint    bpp       = babl_format_get_bytes_per_pixel (
+                        gegl_tile_backend_get_format (GEGL_TILE_BACKEND (ram)));
+  guchar *data      = NULL;
+  gint    size      = tile_size;
+
+  if (compression)
+    {
+      gint max_size = tile_size - tile_size / 4;
+
+      data = g_malloc (max_size);
+      if (gegl_tile_compression_compress (compression, source,
+                                          tile_size / bpp, bpp,
+                                          data, max_size, &size))
+        {
+          data = g_realloc (data, size);
+        }
+      else
+        {
+          g_free (data);
+          data        = NULL;
+          size        = tile_size;
+          compression = NULL;
+        }
+    }
+
+  if (!data)
+    {
+      /* reuse the allocation if it is stored as is already */
+      if (entry->offset && !entry->compression)
+        {
+          memcpy (entry->offset, source, tile_size);
+          return;
+        }
+      data = g_malloc (tile_size);
+      memcpy (data, source, tile_size);
+    }
 
-  memcpy (entry->offset, source, tile_size);
+  if (entry->offset)
+    {
+      g_free (entry->offset);
+      dbg_dealloc (entry->size);
+    }
+  entry->offset      = data;
+  entry->size        = size;
+  entry->compression = compression;
+  dbg_alloc (size);
 }
 
 static inline RamEntry *
 ram_entry_new (GeglTileBackendRam *ram)
 {
   RamEntry *self = g_slice_new (RamEntry);
-  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
 
-  self->offset = g_malloc (tile_size);
-  dbg_alloc (tile_size);
+  /* the data is allocated by ram_entry_write */
+  self->offset      = NULL;
+  self->size        = 0;
+  self->compression = NULL;
   return self;
 }
 
@@ -74,11 +143,13 @@ static inline void
 ram_entry_destroy (RamEntry           *entry,
                    GeglTileBackendRam *ram)
 {
-  gint tile_size = gegl_tile_backend_get_tile_size (GEGL_TILE_BACKEND (ram));
-  g_free (entry->offset);
+  if (entry->offset)
+    {
+      g_free (entry->offset);
+      dbg_dealloc (entry->size);
+    }
   g_hash_table_remove (ram->entries, entry);
 
-  dbg_dealloc (tile_size);
   g_slice_free (RamEntry, entry);
 }
 
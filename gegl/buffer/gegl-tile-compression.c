@@ -0,0 +1,267 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "gegl-tile-compression.h"
+
+struct _GeglTileCompression
+{
+  const gchar *name;
+  gboolean   (*compress)   (const guchar *data,
+                            gint          n_pixels,
+                            gint          bpp,
+                            guchar       *compressed,
+                            gint          max_size,
+                            gint         *size);
+  gboolean   (*decompress) (const guchar *compressed,
+                            gint          size,
+                            guchar       *data,
+                            gint          n_pixels,
+                            gint          bpp);
+};
+
+/* Run length encoding of whole pixels, which suits masks, flat colors and
+ * transparent areas. The data is a sequence of packets starting with a
+ * control byte c, c < 128 is followed by c + 1 literal pixels, c >= 128 by
+ * a single pixel repeated c - 126 times.
+ */
+
+#define RLE_MAX_LITERAL 128
+#define RLE_MAX_RUN     129
+
+static inline gboolean
+rle_same_pixel (const guchar *a,
+                const guchar *b,
+                gint          bpp)
+{
+  return memcmp (a, b, bpp) == 0;
+}
+
+static gboolean
+rle_compress (const guchar *data,
+              gint          n_pixels,
+              gint          bpp,
+              guchar       *compressed,
+              gint          max_size,
+              gint         *size)
+{
+  gint i   = 0;
+  gint out = 0;
+
+  while (i < n_pixels)
+    {
+      const guchar *pixel = data + i * bpp;
+      gint          run   = 1;
+
+      while (i + run < n_pixels && run < RLE_MAX_RUN &&
+             rle_same_pixel (pixel, pixel + run * bpp, bpp))
+        run++;
+
+      if (run > 1)
+        {
+          if (out + 1 + bpp > max_size)
+            return FALSE;
+
+          compressed[out++] = run + 126;
+          memcpy (compressed + out, pixel, bpp);
+          out += bpp;
+          i   += run;
+        }
+      else
+        {
+          gint literal = 1;
+
+          /* extend the literal up to where a run starts */
+          while (i + literal < n_pixels && literal < RLE_MAX_LITERAL &&
+                 (i + literal + 1 >= n_pixels ||
+                  !rle_same_pixel (pixel + literal * bpp,
+                                   pixel + (literal + 1) * bpp, bpp)))
+            literal++;
+
+          if (out + 1 + literal * bpp > max_size)
+            return FALSE;
+
+          compressed[out++] = literal - 1;
+          memcpy (compressed + out, pixel, literal * bpp);
+          out += literal * bpp;
+          i   += literal;
+        }
+    }
+
+  *size = out;
+  return TRUE;
+}
+
+static gboolean
+rle_decompress (const guchar *compressed,
+                gint          size,
+                guchar       *data,
+                gint          n_pixels,
+                gint          bpp)
+{
+  const guchar *in     = compressed;
+  const guchar *in_end = compressed + size;
+  guchar       *out     = data;
+  guchar       *out_end = data + n_pixels * bpp;
+
+  while (in < in_end)
+    {
+      gint c = *in++;
+
+      if (c < 128)
+        {
+          gint length = (c + 1) * bpp;
+
+          if (in + length > in_end || out + length > out_end)
+            return FALSE;
+
+          memcpy (out, in, length);
+          in  += length;
+          out += length;
+        }
+      else
+        {
+          gint run = c - 126;
+          gint j;
+
+          if (in + bpp > in_end || out + run * bpp > out_end)
+            return FALSE;
+
+          for (j = 0; j < run; j++)
+            {
+              memcpy (out, in, bpp);
+              out += bpp;
+            }
+          in += bpp;
+        }
+    }
+
+  return out == out_end;
+}
+
+/* Delta coding followed by run length encoding. Every byte of a pixel is
+ * replaced by its difference to the same byte of the previous pixel, which
+ * turns the channels of 8 bit gradients into runs of equal pixels.
+ */
+
+static gboolean
+delta_rle_compress (const guchar *data,
+                    gint          n_pixels,
+                    gint          bpp,
+                    guchar       *compressed,
+                    gint          max_size,
+                    gint         *size)
+{
+  gint     length = n_pixels * bpp;
+  guchar  *delta  = g_malloc (length);
+  gboolean success;
+  gint     i;
+
+  for (i = 0; i < MIN (bpp, length); i++)
+    delta[i] = data[i];
+  for (; i < length; i++)
+    delta[i] = data[i] - data[i - bpp];
+
+  success = rle_compress (delta, n_pixels, bpp, compressed, max_size, size);
+
+  g_free (delta);
+
+  return success;
+}
+
+static gboolean
+delta_rle_decompress (const guchar *compressed,
+                      gint          size,
+                      guchar       *data,
+                      gint          n_pixels,
+                      gint          bpp)
+{
+  gint length = n_pixels * bpp;
+  gint i;
+
+  if (!rle_decompress (compressed, size, data, n_pixels, bpp))
+    return FALSE;
+
+  for (i = bpp; i < length; i++)
+    data[i] += data[i - bpp];
+
+  return TRUE;
+}
+
+static const GeglTileCompression compressions[] =
+{
+  { "rle",       rle_compress,       rle_decompress },
+  { "delta-rle", delta_rle_compress, delta_rle_decompress }
+};
+
+static const GeglTileCompression *default_compression = NULL;
+
+const GeglTileCompression *
+gegl_tile_compression_get_default (void)
+{
+  return default_compression;
+}
+
+void
+gegl_tile_compression_set_default (const gchar *name)
+{
+  gint i;
+
+  if (!name || !strcmp (name, "none"))
+    {
+      default_compression = NULL;
+      return;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (compressions); i++)
+    if (!strcmp (compressions[i].name, name))
+      {
+        default_compression = &compressions[i];
+        return;
+      }
+
+  g_warning ("unknown tile compression '%s', not compressing tiles", name);
+  default_compression = NULL;
+}
+
+gboolean
+gegl_tile_compression_compress (const GeglTileCompression *compression,
+                                const guchar              *data,
+                                gint                       n_pixels,
+                                gint                       bpp,
+                                guchar                    *compressed,
+                                gint                       max_size,
+                                gint                      *size)
+{
+  return compression->compress (data, n_pixels, bpp,
+                                compressed, max_size, size);
+}
+
+gboolean
+gegl_tile_compression_decompress (const GeglTileCompression *compression,
+                                  const guchar              *compressed,
+                                  gint                       size,
+                                  guchar                    *data,
+                                  gint                       n_pixels,
+                                  gint                       bpp)
+{
+  return compression->decompress (compressed, size, data, n_pixels, bpp);
+}
@@ -0,0 +1,56 @@
+/* This file is part of GEGL.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_TILE_COMPRESSION_H__
+#define __GEGL_TILE_COMPRESSION_H__
+
+#include <glib.h>
+
+/***
+ * GeglTileCompression is a codec used by tile backends for keeping the
+ * pixel data of tiles that are not in the cache compressed.
+ */
+
+typedef struct _GeglTileCompression GeglTileCompression;
+
+/* the codec set with the "tile-compression" property of GeglConfig, NULL
+ * when tiles are kept uncompressed
+ */
+const GeglTileCompression * gegl_tile_compression_get_default (void);
+void                        gegl_tile_compression_set_default (const gchar *name);
+
+/* compresses n_pixels pixels of bpp bytes each from data into compressed,
+ * returns FALSE if the result would not fit in max_size bytes.
+ */
+gboolean gegl_tile_compression_compress   (const GeglTileCompression *compression,
+                                           const guchar              *data,
+                                           gint                       n_pixels,
+                                           gint                       bpp,
+                                           guchar                    *compressed,
+                                           gint                       max_size,
+                                           gint                      *size);
+
+/* decompresses size bytes from compressed into n_pixels pixels of bpp bytes
+ * each at data, returns FALSE if compressed is not valid.
+ */
+gboolean gegl_tile_compression_decompress (const GeglTileCompression *compression,
+                                           const guchar              *compressed,
+                                           gint                       size,
+                                           guchar                    *data,
+                                           gint                       n_pixels,
+                                           gint                       bpp);
+
+#endif
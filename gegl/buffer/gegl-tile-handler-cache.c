@@ -18,6 +18,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include <glib.h>
 #include <glib-object.h>
 
@@ -29,6 +31,8 @@
 #include "gegl-tile.h"
 #include "gegl-tile-handler-cache.h"
 #include "gegl-tile-storage.h"
+#include "gegl-tile-alloc.h"
+#include "gegl-tile-backend-file.h"
 #include "gegl-debug.h"
 
 #include "gegl-buffer-cl-cache.h"
@@ -41,19 +45,78 @@ typedef struct CacheItem
 {
   GeglTileHandlerCache *handler; /* The specific handler that cached this item*/
   GeglTile *tile;                /* The tile */
-  GList     link;                /*  Link in the cache_queue, to avoid
+  GList     link;                /*  Link in the shard queue, to avoid
                                   *  queue lookups involving g_list_find() */
+  GList     handler_link;        /*  Link in the queue of the handler */
+  gint      size;                /*  The size of the tile when inserted */
 
   gint      x;                   /* The coordinates this tile was cached for */
   gint      y;
   gint      z;
+
+  guint     stamp;               /* shard tick of the last access */
+  guint     dirty      : 1;      /* the item is on the dirty queue */
+  guint     referenced : 1;      /* reference bit used by the CLOCK policy */
 } CacheItem;
 
 #define LINK_GET_ITEM(link) \
         ((CacheItem *) ((guchar *) link - G_STRUCT_OFFSET (CacheItem, link)))
+#define HANDLER_LINK_GET_ITEM(link) \
+        ((CacheItem *) ((guchar *) link - G_STRUCT_OFFSET (CacheItem, handler_link)))
+
+/* The cache is split into CACHE_SHARDS independent shards, each protected by
+ * its own mutex and keeping its own queues and hash table. A tile is placed
+ * in a shard based on a hash of (handler, x, y, z), so threads working on
+ * different tiles rarely contend for the same lock. The byte budget is global,
+ * the bytes held by all shards are counted in cache_total, which has a lock
+ * of its own that is only held for updating or reading the count.
+ *
+ * Every handler additionally keeps its items in a queue of its own, in
+ * insertion order, protected by the handler's mutex. It is used for
+ * enforcing per-buffer budgets and for dropping all items of a handler
+ * without visiting the other handlers' items. The lock order is shard
+ * before handler.
+ */
+#define CACHE_SHARDS 32 /* must be a power of two */
+
+typedef struct CacheShard
+{
+  GStaticMutex  mutex;
+  GQueue        clean; /* items whose tile is stored, newest at the head */
+  GQueue        dirty; /* items whose tile needs to be written back */
+  GHashTable   *ht;
+  guint         tick;  /* incremented on every access to the shard */
+} CacheShard;
+
+/* Within a shard clean and dirty tiles are kept on separate queues, this
+ * lets the washer find a dirty tile to write back in constant time and lets
+ * eviction prefer dropping clean tiles. Tiles move to the dirty queue when
+ * they are modified (see gegl_tile_handler_cache_mark_dirty ()), tiles that
+ * got stored behind the cache's back are moved back lazily.
+ *
+ * How items are ordered within a queue is up to the eviction policy, which
+ * is picked with the "cache-policy" property of GeglConfig.
+ */
+typedef struct CachePolicy
+{
+  const gchar *name;
+  /* called with the shard locked whenever item is accessed */
+  void        (*touch)  (CacheShard *shard,
+                         CacheItem  *item);
+  /* returns the item of queue that should be evicted first */
+  CacheItem * (*victim) (CacheShard *shard,
+                         GQueue     *queue);
+} CachePolicy;
+
+/* a dirty tile has to be written to swap before it can be dropped, it is
+ * only picked for eviction over a clean tile when it has been unused for
+ * CACHE_DIRTY_COST times as long.
+ */
+#define CACHE_DIRTY_COST 4
 
 
 static void       gegl_tile_handler_cache_dispose    (GObject              *object);
+static void       gegl_tile_handler_cache_finalize   (GObject              *object);
 static gboolean   gegl_tile_handler_cache_wash       (GeglTileHandlerCache *cache);
 static gpointer   gegl_tile_handler_cache_command    (GeglTileSource       *tile_store,
                                                       GeglTileCommand       command,
@@ -82,16 +145,51 @@ static void       gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cach
                                                       gint                  x,
                                                       gint                  y,
                                                       gint                  z);
+static CacheItem *cache_lookup                       (CacheShard           *shard,
+                                                      GeglTileHandlerCache *cache,
+                                                      gint                  x,
+                                                      gint                  y,
+                                                      gint                  z);
+
 
+static void       lru_touch                          (CacheShard           *shard,
+                                                      CacheItem            *item);
+static CacheItem *lru_victim                         (CacheShard           *shard,
+                                                      GQueue               *queue);
+static void       clock_touch                        (CacheShard           *shard,
+                                                      CacheItem            *item);
+static CacheItem *clock_victim                       (CacheShard           *shard,
+                                                      GQueue               *queue);
 
-static GStaticMutex mutex                 = G_STATIC_MUTEX_INIT;
-static GQueue      *cache_queue           = NULL;
-static GHashTable  *cache_ht              = NULL;
-static gint         cache_wash_percentage = 20;
-static gint         cache_total           = 0; /* approximate amount of bytes stored */
+
+static const CachePolicy cache_policies[] =
+{
+  { "lru",   lru_touch,   lru_victim },
+  { "clock", clock_touch, clock_victim }
+};
+
+static const CachePolicy *cache_policy = &cache_policies[0];
+
+static CacheShard    cache_shards[CACHE_SHARDS];
+static gboolean      cache_initialized     = FALSE;
+static gint          cache_wash_percentage = 20;
+static volatile gint cache_trim_shard      = 0; /* where the next eviction starts */
+static volatile gint cache_wash_shard      = 0; /* where the next wash starts */
+static guint64       cache_total           = 0; /* bytes held by all shards */
+static GStaticMutex  cache_total_mutex     = G_STATIC_MUTEX_INIT;
+
+/* notified when an insert brings the cache over its size, protected by
+ * cache_total_mutex
+ */
+static GeglBufferCachePressureFunc cache_pressure_func = NULL;
+static gpointer                    cache_pressure_data = NULL;
+/* set while the pressure function runs in a thread, tiles it stores do not
+ * notify it again
+ */
+static GStaticPrivate              cache_in_pressure   = G_STATIC_PRIVATE_INIT;
 #ifdef GEGL_DEBUG_CACHE_HITS
-static gint         cache_hits            = 0;
-static gint         cache_misses          = 0;
+static volatile gint cache_hits            = 0;
+static volatile gint cache_misses          = 0;
 #endif
 
 
@@ -103,30 +201,298 @@ gegl_tile_handler_cache_class_init (GeglTileHandlerCacheClass *class)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (class);
 
-  gobject_class->dispose = gegl_tile_handler_cache_dispose;
+  gobject_class->dispose  = gegl_tile_handler_cache_dispose;
+  gobject_class->finalize = gegl_tile_handler_cache_finalize;
 }
 
 static void
 gegl_tile_handler_cache_init (GeglTileHandlerCache *cache)
 {
   ((GeglTileSource*)cache)->command = gegl_tile_handler_cache_command;
+  g_static_mutex_init (&cache->mutex);
+  g_queue_init (&cache->queue);
+  cache->total  = 0;
+  cache->budget = 0;
   gegl_tile_cache_init ();
 }
 
+static void
+gegl_tile_handler_cache_finalize (GObject *object)
+{
+  GeglTileHandlerCache *cache = (GeglTileHandlerCache*) (object);
+
+  g_static_mutex_free (&cache->mutex);
+
+  G_OBJECT_CLASS (gegl_tile_handler_cache_parent_class)->finalize (object);
+}
+
+/* bytes held by all shards, a 64-bit value cannot be read atomically on
+ * all platforms
+ */
+static guint64
+cache_get_total (void)
+{
+  guint64 total;
+
+  g_static_mutex_lock (&cache_total_mutex);
+  total = cache_total;
+  g_static_mutex_unlock (&cache_total_mutex);
+
+  return total;
+}
+
+static inline void
+cache_add_total (gint64 bytes)
+{
+  g_static_mutex_lock (&cache_total_mutex);
+  cache_total += bytes;
+  g_static_mutex_unlock (&cache_total_mutex);
+}
+
+/* bytes held by the items of cache */
+static guint64
+cache_get_handler_total (GeglTileHandlerCache *cache)
+{
+  guint64 total;
+
+  g_static_mutex_lock (&cache->mutex);
+  total = cache->total;
+  g_static_mutex_unlock (&cache->mutex);
+
+  return total;
+}
+
+static inline CacheShard *
+cache_shard (GeglTileHandlerCache *cache,
+             gint                  x,
+             gint                  y,
+             gint                  z)
+{
+  guint hash = (guint) x * 73856093u ^
+               (guint) y * 19349663u ^
+               (guint) z * 83492791u ^
+               (GPOINTER_TO_UINT (cache) >> 4);
+
+  hash ^= hash >> 16;
+  return &cache_shards[hash & (CACHE_SHARDS - 1)];
+}
+
+static inline GQueue *
+cache_item_queue (CacheShard *shard,
+                  CacheItem  *item)
+{
+  return item->dirty ? &shard->dirty : &shard->clean;
+}
+
+/* adds item to shard and to its handler, the shard has to be locked */
+static inline void
+cache_item_link (CacheShard *shard,
+                 CacheItem  *item)
+{
+  GeglTileHandlerCache *cache = item->handler;
+
+  g_queue_push_head_link (cache_item_queue (shard, item), &item->link);
+  g_hash_table_insert (shard->ht, item, item);
+  cache_add_total (item->size);
+
+  g_static_mutex_lock (&cache->mutex);
+  g_queue_push_head_link (&cache->queue, &item->handler_link);
+  cache->total += item->size;
+  g_static_mutex_unlock (&cache->mutex);
+}
+
+/* removes item from shard and from its handler, the shard has to be locked */
+static inline void
+cache_item_unlink (CacheShard *shard,
+                   CacheItem  *item)
+{
+  GeglTileHandlerCache *cache = item->handler;
+
+  g_queue_unlink (cache_item_queue (shard, item), &item->link);
+  g_hash_table_remove (shard->ht, item);
+  cache_add_total (- (gint64) item->size);
+
+  g_static_mutex_lock (&cache->mutex);
+  g_queue_unlink (&cache->queue, &item->handler_link);
+  cache->total -= item->size;
+  g_static_mutex_unlock (&cache->mutex);
+}
+
+/* moves item to the head of the clean or dirty queue */
+static inline void
+cache_item_set_dirty (CacheShard *shard,
+                      CacheItem  *item,
+                      gboolean    dirty)
+{
+  g_queue_unlink (cache_item_queue (shard, item), &item->link);
+  item->dirty = dirty ? 1 : 0;
+  g_queue_push_head_link (cache_item_queue (shard, item), &item->link);
+}
 
 static void
-gegl_tile_handler_cache_reinit_buffer_tiles (gpointer itm,
-                                             gpointer userdata)
+lru_touch (CacheShard *shard,
+           CacheItem  *item)
 {
-  CacheItem *item;
-  item = itm;
-  if (item->handler == userdata)
+  GQueue *queue = cache_item_queue (shard, item);
+
+  if (g_queue_peek_head_link (queue) != &item->link)
     {
-      GeglTileHandlerCache *cache = userdata;
-      cache->free_list = g_slist_prepend (cache->free_list, item);
+      g_queue_unlink (queue, &item->link);
+      g_queue_push_head_link (queue, &item->link);
     }
 }
 
+static CacheItem *
+lru_victim (CacheShard *shard,
+            GQueue     *queue)
+{
+  GList *link = g_queue_peek_tail_link (queue);
+
+  return link ? LINK_GET_ITEM (link) : NULL;
+}
+
+/* CLOCK only sets a reference bit on access, avoiding the relinking done
+ * by LRU for every cache hit; items with the bit set get a second chance
+ * when they come up for eviction.
+ */
+static void
+clock_touch (CacheShard *shard,
+             CacheItem  *item)
+{
+  item->referenced = 1;
+}
+
+static CacheItem *
+clock_victim (CacheShard *shard,
+              GQueue     *queue)
+{
+  guint  n = g_queue_get_length (queue);
+  GList *link;
+
+  while ((link = g_queue_peek_tail_link (queue)) && n--)
+    {
+      CacheItem *item = LINK_GET_ITEM (link);
+
+      if (!item->referenced)
+        return item;
+
+      item->referenced = 0;
+      g_queue_unlink (queue, link);
+      g_queue_push_head_link (queue, link);
+    }
+
+  return link ? LINK_GET_ITEM (link) : NULL;
+}
+
+/* picks the item to evict from shard, weighing the age of the oldest clean
+ * and the oldest dirty item against the cost of writing a dirty tile back.
+ */
+static CacheItem *
+cache_shard_victim (CacheShard *shard)
+{
+  CacheItem *clean = cache_policy->victim (shard, &shard->clean);
+  CacheItem *dirty = cache_policy->victim (shard, &shard->dirty);
+
+  if (clean == NULL)
+    return dirty;
+  if (dirty == NULL)
+    return clean;
+
+  if ((guint64) (shard->tick - dirty->stamp) >
+      (guint64) (shard->tick - clean->stamp) * CACHE_DIRTY_COST)
+    return dirty;
+
+  return clean;
+}
+
+/* sets the eviction policy by name, NULL selects the default policy */
+void
+gegl_tile_cache_set_policy (const gchar *name)
+{
+  gint i;
+
+  if (name == NULL)
+    {
+      cache_policy = &cache_policies[0];
+      return;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (cache_policies); i++)
+    if (!strcmp (cache_policies[i].name, name))
+      {
+        cache_policy = &cache_policies[i];
+        return;
+      }
+
+  g_warning ("unknown tile cache policy '%s', using '%s'",
+             name, cache_policies[0].name);
+  cache_policy = &cache_policies[0];
+}
+
+/* removes the oldest item of cache from its shard, and returns it. Returns
+ * NULL when cache has no items besides keep. Dirty tiles are stored while
+ * the shard is still locked when store is TRUE.
+ */
+static CacheItem *
+gegl_tile_handler_cache_steal_oldest (GeglTileHandlerCache *cache,
+                                      CacheItem            *keep,
+                                      gboolean              store)
+{
+  while (TRUE)
+    {
+      CacheShard *shard;
+      CacheItem  *item;
+      GList      *link;
+      gint        x, y, z;
+
+      /* the handler lock cannot be held while locking a shard, remember the
+       * coordinates of the oldest item and look it up again in its shard
+       */
+      g_static_mutex_lock (&cache->mutex);
+      link = g_queue_peek_tail_link (&cache->queue);
+      if (link == NULL || HANDLER_LINK_GET_ITEM (link) == keep)
+        {
+          g_static_mutex_unlock (&cache->mutex);
+          return NULL;
+        }
+      item = HANDLER_LINK_GET_ITEM (link);
+      x = item->x;
+      y = item->y;
+      z = item->z;
+      g_static_mutex_unlock (&cache->mutex);
+
+      shard = cache_shard (cache, x, y, z);
+
+      g_static_mutex_lock (&shard->mutex);
+      item = cache_lookup (shard, cache, x, y, z);
+      if (item == keep)
+        item = NULL;
+      if (item)
+        {
+          if (store && !gegl_tile_is_stored (item->tile))
+            gegl_tile_store (item->tile);
+          cache_item_unlink (shard, item);
+        }
+      g_static_mutex_unlock (&shard->mutex);
+
+      /* if the item went away in the meantime, try again */
+      if (item)
+        return item;
+    }
+}
+
+/* unlinks all items belonging to cache and prepends them to
+ * cache->free_list
+ */
+static void
+gegl_tile_handler_cache_collect_items (GeglTileHandlerCache *cache)
+{
+  CacheItem *item;
+
+  while ((item = gegl_tile_handler_cache_steal_oldest (cache, NULL, FALSE)))
+    cache->free_list = g_slist_prepend (cache->free_list, item);
+}
+
 static void
 gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
 {
@@ -139,44 +505,26 @@ gegl_tile_handler_cache_reinit (GeglTileHandlerCache *cache)
       cache->tile_storage->hot_tile = NULL;
     }
 
-  if (!cache->count)
+  if (!g_atomic_int_get (&cache->count))
     return;
 
-  g_static_mutex_lock (&mutex);
   /* only throw out items belonging to this cache instance */
 
   cache->free_list = NULL;
-  g_queue_foreach (cache_queue, gegl_tile_handler_cache_reinit_buffer_tiles, cache);
+  gegl_tile_handler_cache_collect_items (cache);
   for (iter = cache->free_list; iter; iter = g_slist_next (iter))
     {
       item = iter->data;
       if (item->tile)
         {
-          cache_total -= item->tile->size;
           gegl_tile_mark_as_stored (item->tile); /* to avoid saving */
           gegl_tile_unref (item->tile);
-          cache->count--;
+          g_atomic_int_add (&cache->count, -1);
         }
-      g_queue_unlink (cache_queue, &item->link);
-      g_hash_table_remove (cache_ht, item);
       g_slice_free (CacheItem, item);
     }
   g_slist_free (cache->free_list);
   cache->free_list = NULL;
-  g_static_mutex_unlock (&mutex);
-}
-
-static void
-gegl_tile_handler_cache_dispose_buffer_tiles (gpointer itm,
-                                              gpointer userdata)
-{
-  CacheItem *item;
-  item = itm;
-  if (item->handler == userdata)
-    {
-      GeglTileHandlerCache *cache = userdata;
-      cache->free_list = g_slist_prepend (cache->free_list, item);
-    }
 }
 
 static void
@@ -191,31 +539,22 @@ gegl_tile_handler_cache_dispose (GObject *object)
   /* only throw out items belonging to this cache instance */
 
   cache->free_list = NULL;
-  /* XXX: for optimization this could be delayed,. or collected among multiple
-   * buffer destructions, to avoid the overhead of walking the full queue for
-   * every tiny buffer being destroyed.
-   */
 
-  if (cache->count)
+  if (g_atomic_int_get (&cache->count))
     {
-      g_static_mutex_lock (&mutex);
-      g_queue_foreach (cache_queue, gegl_tile_handler_cache_dispose_buffer_tiles, cache);
+      gegl_tile_handler_cache_collect_items (cache);
       for (iter = cache->free_list; iter; iter = g_slist_next (iter))
         {
             item = iter->data;
             if (item->tile)
               {
-                cache_total -= item->tile->size;
                 gegl_tile_unref (item->tile);
-                cache->count--;
+                g_atomic_int_add (&cache->count, -1);
               }
-            g_queue_unlink (cache_queue, &item->link);
-            g_hash_table_remove (cache_ht, item);
             g_slice_free (CacheItem, item);
         }
       g_slist_free (cache->free_list);
       cache->free_list = NULL;
-      g_static_mutex_unlock (&mutex);
     }
 
   if (cache->count < 0)
@@ -242,12 +581,12 @@ gegl_tile_handler_cache_get_tile_command (GeglTileSource *tile_store,
   if (tile)
     {
 #ifdef GEGL_DEBUG_CACHE_HITS
-      cache_hits++;
+      g_atomic_int_inc (&cache_hits);
 #endif
       return tile;
     }
 #ifdef GEGL_DEBUG_CACHE_HITS
-  cache_misses++;
+  g_atomic_int_inc (&cache_misses);
 #endif
 
   if (source)
@@ -275,22 +614,34 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
       case GEGL_TILE_FLUSH:
         {
           GList     *link;
+          gint       i;
 
           if (gegl_cl_is_accelerated ())
             gegl_buffer_cl_cache_flush2 (cache, NULL);
 
-          if (cache->count)
+          if (g_atomic_int_get (&cache->count))
             {
-              for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+              for (i = 0; i < CACHE_SHARDS; i++)
                 {
-                  CacheItem *item = LINK_GET_ITEM (link);
-                  GeglTile  *tile = item->tile;
-
-                  if (tile != NULL &&
-                      item->handler == cache)
+                  CacheShard *shard = &cache_shards[i];
+
+                  /* only the dirty queue needs to be visited, tiles on it that
+                   * get stored stay there until the washer or eviction moves
+                   * them to the clean queue
+                   */
+                  g_static_mutex_lock (&shard->mutex);
+                  for (link = g_queue_peek_head_link (&shard->dirty); link; link = link->next)
                     {
-                      gegl_tile_store (tile);
+                      CacheItem *item = LINK_GET_ITEM (link);
+                      GeglTile  *tile = item->tile;
+
+                      if (tile != NULL &&
+                          item->handler == cache)
+                        {
+                          gegl_tile_store (tile);
+                        }
                     }
+                  g_static_mutex_unlock (&shard->mutex);
                 }
             }
         }
@@ -334,41 +685,66 @@ gegl_tile_handler_cache_command (GeglTileSource  *tile_store,
   return gegl_tile_handler_source_command (handler, command, x, y, z, data);
 }
 
-/* write the least recently used dirty tile to disk if it
- * is in the wash_percentage (20%) least recently used tiles,
- * calling this function in an idle handler distributes the
- * tile flushing overhead over time.
+/* write the least recently used dirty tile of a shard to disk if it is
+ * older than the wash_percentage (20%) least recently used tiles of the
+ * shard, calling this function in an idle handler distributes the tile
+ * flushing overhead over time. Successive calls visit the shards in
+ * round-robin order, and finding the candidate within a shard is a
+ * constant time operation.
  */
 gboolean
 gegl_tile_handler_cache_wash (GeglTileHandlerCache *cache)
 {
-  GeglTile  *last_dirty = NULL;
-  guint      count      = 0;
-  gint       length     = g_queue_get_length (cache_queue);
-  gint       wash_tiles = cache_wash_percentage * length / 100;
-  GList     *link;
+  gint i;
+  gint start = g_atomic_int_exchange_and_add (&cache_wash_shard, 1);
 
-  for (link = g_queue_peek_head_link (cache_queue); link; link = link->next)
+  for (i = 0; i < CACHE_SHARDS; i++)
     {
-      CacheItem *item = LINK_GET_ITEM (link);
-      GeglTile  *tile = item->tile;
+      CacheShard *shard      = &cache_shards[(start + i) & (CACHE_SHARDS - 1)];
+      GeglTile   *last_dirty = NULL;
+      GList      *link;
 
-      count++;
-      if (!gegl_tile_is_stored (tile))
-        if (count > length - wash_tiles)
-          last_dirty = tile;
-    }
+      g_static_mutex_lock (&shard->mutex);
+      while ((link = g_queue_peek_tail_link (&shard->dirty)))
+        {
+          CacheItem *item   = LINK_GET_ITEM (link);
+          guint      length = g_queue_get_length (&shard->clean) +
+                              g_queue_get_length (&shard->dirty);
 
-  if (last_dirty != NULL)
-    {
-      gegl_tile_store (last_dirty);
-      return TRUE;
+          if (gegl_tile_is_stored (item->tile))
+            {
+              /* stored by someone else, move it over and look further */
+              g_queue_unlink (&shard->dirty, link);
+              item->dirty = 0;
+              g_queue_push_tail_link (&shard->clean, link);
+              continue;
+            }
+
+          if ((guint64) (shard->tick - item->stamp) * 100 >=
+              (guint64) length * (100 - cache_wash_percentage))
+            {
+              last_dirty = gegl_tile_ref (item->tile);
+              g_queue_unlink (&shard->dirty, link);
+              item->dirty = 0;
+              g_queue_push_tail_link (&shard->clean, link);
+            }
+          break;
+        }
+      g_static_mutex_unlock (&shard->mutex);
+
+      if (last_dirty != NULL)
+        {
+          gegl_tile_store (last_dirty);
+          gegl_tile_unref (last_dirty);
+          return TRUE;
+        }
     }
   return FALSE;
 }
 
-static inline CacheItem *
-cache_lookup (GeglTileHandlerCache *cache,
+static CacheItem *
+cache_lookup (CacheShard           *shard,
+              GeglTileHandlerCache *cache,
               gint                  x,
               gint                  y,
               gint                  z)
@@ -380,7 +756,7 @@ cache_lookup (GeglTileHandlerCache *cache,
   key.z       = z;
   key.handler = cache;
 
-  return g_hash_table_lookup (cache_ht, &key);
+  return g_hash_table_lookup (shard->ht, &key);
 }
 
 /* returns the requested Tile if it is in the cache, NULL otherwize.
@@ -391,22 +767,25 @@ gegl_tile_handler_cache_get_tile (GeglTileHandlerCache *cache,
                                   gint                  y,
                                   gint                  z)
 {
-  CacheItem *result;
+  CacheShard *shard;
+  CacheItem  *result;
+  GeglTile   *tile = NULL;
 
-  if (cache->count == 0)
+  if (g_atomic_int_get (&cache->count) == 0)
     return NULL;
 
-  g_static_mutex_lock (&mutex);
-  result = cache_lookup (cache, x, y, z);
+  shard = cache_shard (cache, x, y, z);
+
+  g_static_mutex_lock (&shard->mutex);
+  result = cache_lookup (shard, cache, x, y, z);
   if (result)
     {
-      g_queue_unlink (cache_queue, &result->link);
-      g_queue_push_head_link (cache_queue, &result->link);
-      g_static_mutex_unlock (&mutex);
-      return gegl_tile_ref (result->tile);
+      result->stamp = ++shard->tick;
+      cache_policy->touch (shard, result);
+      tile = gegl_tile_ref (result->tile);
     }
-  g_static_mutex_unlock (&mutex);
-  return NULL;
+  g_static_mutex_unlock (&shard->mutex);
+  return tile;
 }
 
 static gboolean
@@ -426,22 +805,44 @@ gegl_tile_handler_cache_has_tile (GeglTileHandlerCache *cache,
   return FALSE;
 }
 
+/* evicts an item from the next non-empty shard, skipping keep (the item
+ * that was just inserted). Dirty tiles are stored while the shard is still
+ * locked, so that a concurrent miss for the same tile cannot fetch stale
+ * data from the backend.
+ */
 static gboolean
-gegl_tile_handler_cache_trim (GeglTileHandlerCache *cache)
+gegl_tile_handler_cache_trim (CacheItem *keep)
 {
-  GList *link;
-
-  link = g_queue_pop_tail_link (cache_queue);
+  gint start = g_atomic_int_exchange_and_add (&cache_trim_shard, 1);
+  gint i;
 
-  if (link != NULL)
+  for (i = 0; i < CACHE_SHARDS; i++)
     {
-      CacheItem *last_writable = LINK_GET_ITEM (link);
+      CacheShard *shard = &cache_shards[(start + i) & (CACHE_SHARDS - 1)];
+      CacheItem  *last_writable;
 
-      g_hash_table_remove (cache_ht, last_writable);
-      cache_total  -= last_writable->tile->size;
-      gegl_tile_unref (last_writable->tile);
-      g_slice_free (CacheItem, last_writable);
-      return TRUE;
+      g_static_mutex_lock (&shard->mutex);
+      last_writable = cache_shard_victim (shard);
+      if (last_writable == keep)
+        {
+          last_writable = NULL;
+        }
+      else if (last_writable != NULL)
+        {
+          if (!gegl_tile_is_stored (last_writable->tile))
+            gegl_tile_store (last_writable->tile);
+
+          cache_item_unlink (shard, last_writable);
+        }
+      g_static_mutex_unlock (&shard->mutex);
+
+      if (last_writable != NULL)
+        {
+          g_atomic_int_add (&last_writable->handler->count, -1);
+          gegl_tile_unref (last_writable->tile);
+          g_slice_free (CacheItem, last_writable);
+          return TRUE;
+        }
     }
 
   return FALSE;
@@ -453,21 +854,23 @@ gegl_tile_handler_cache_invalidate (GeglTileHandlerCache *cache,
                                     gint                  y,
                                     gint                  z)
 {
-  CacheItem *item;
+  CacheShard *shard = cache_shard (cache, x, y, z);
+  CacheItem  *item;
+
+  g_static_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, x, y, z);
+  if (item)
+    cache_item_unlink (shard, item);
+  g_static_mutex_unlock (&shard->mutex);
 
-  g_static_mutex_lock (&mutex);
-  item = cache_lookup (cache, x, y, z);
   if (item)
     {
-      cache_total -= item->tile->size;
+      g_atomic_int_add (&cache->count, -1);
       item->tile->tile_storage = NULL;
       gegl_tile_mark_as_stored (item->tile); /* to cheat it out of being stored */
       gegl_tile_unref (item->tile);
-      g_queue_unlink (cache_queue, &item->link);
-      g_hash_table_remove (cache_ht, item);
       g_slice_free (CacheItem, item);
     }
-  g_static_mutex_unlock (&mutex);
 }
 
 
@@ -477,21 +880,22 @@ gegl_tile_handler_cache_void (GeglTileHandlerCache *cache,
                               gint                  y,
                               gint                  z)
 {
-  CacheItem *item;
+  CacheShard *shard = cache_shard (cache, x, y, z);
+  CacheItem  *item;
+
+  g_static_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, x, y, z);
+  if (item)
+    cache_item_unlink (shard, item);
+  g_static_mutex_unlock (&shard->mutex);
 
-  g_static_mutex_lock (&mutex);
-  item = cache_lookup (cache, x, y, z);
   if (item)
     {
       gegl_tile_void (item->tile);
-      cache_total -= item->tile->size;
+      g_atomic_int_add (&cache->count, -1);
       gegl_tile_unref (item->tile);
-      g_queue_unlink (cache_queue, &item->link);
-      g_hash_table_remove (cache_ht, item);
       g_slice_free (CacheItem, item);
-      cache->count --;
     }
-  g_static_mutex_unlock (&mutex);
 }
 
 void
@@ -501,38 +905,147 @@ gegl_tile_handler_cache_insert (GeglTileHandlerCache *cache,
                                 gint                  y,
                                 gint                  z)
 {
-  CacheItem *item = g_slice_new (CacheItem);
+  CacheShard *shard = cache_shard (cache, x, y, z);
+  CacheItem  *item  = g_slice_new (CacheItem);
 
   item->handler   = cache;
   item->tile      = gegl_tile_ref (tile);
+  item->size      = tile->size;
   item->link.data = item;
   item->link.next = NULL;
   item->link.prev = NULL;
+  item->handler_link.data = item;
+  item->handler_link.next = NULL;
+  item->handler_link.prev = NULL;
   item->x         = x;
   item->y         = y;
   item->z         = z;
+  item->dirty     = !gegl_tile_is_stored (tile);
+  item->referenced = 0;
 
   // XXX : remove entry if it already exists
   gegl_tile_handler_cache_void (cache, x, y, z);
 
-  g_static_mutex_lock (&mutex);
-  cache_total  += item->tile->size;
-  g_queue_push_head_link (cache_queue, &item->link);
+  g_static_mutex_lock (&shard->mutex);
+  item->stamp = ++shard->tick;
+  cache_item_link (shard, item);
+  g_static_mutex_unlock (&shard->mutex);
 
-  cache->count ++;
+  g_atomic_int_inc (&cache->count);
 
+  /* a buffer over its own budget makes room among its own tiles first */
+  while (cache->budget && cache_get_handler_total (cache) > cache->budget)
+    {
+      CacheItem *oldest = gegl_tile_handler_cache_steal_oldest (cache, item, TRUE);
 
-  g_hash_table_insert (cache_ht, item, item);
+      if (!oldest)
+        break;
+      g_atomic_int_add (&cache->count, -1);
+      gegl_tile_unref (oldest->tile);
+      g_slice_free (CacheItem, oldest);
+    }
 
-  while (cache_total > gegl_config()->cache_size)
+  if (cache_get_total () > gegl_config()->cache_size &&
+      !g_static_private_get (&cache_in_pressure))
+    {
+      GeglBufferCachePressureFunc func;
+      gpointer                    user_data;
+
+      g_static_mutex_lock (&cache_total_mutex);
+      func      = cache_pressure_func;
+      user_data = cache_pressure_data;
+      g_static_mutex_unlock (&cache_total_mutex);
+
+      if (func)
+        {
+          g_static_private_set (&cache_in_pressure, GINT_TO_POINTER (TRUE), NULL);
+          func (cache_get_total (), gegl_config()->cache_size, user_data);
+          g_static_private_set (&cache_in_pressure, NULL, NULL);
+        }
+    }
+
+  while (cache_get_total () > gegl_config()->cache_size)
     {
 #ifdef GEGL_DEBUG_CACHE_HITS
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:%i > cache_size:%i", cache_total, gegl_config()->cache_size);
-      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i  %i]", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses, g_queue_get_length (cache_queue));
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "cache_total:%"G_GUINT64_FORMAT" > cache_size:%"G_GUINT64_FORMAT, cache_get_total (), gegl_config()->cache_size);
+      GEGL_NOTE(GEGL_DEBUG_CACHE, "%f%% hit:%i miss:%i", cache_hits*100.0/(cache_hits+cache_misses), cache_hits, cache_misses);
 #endif
-      gegl_tile_handler_cache_trim (cache);
+      if (!gegl_tile_handler_cache_trim (item))
+        break;
+    }
+
+  /* the tiles stored above were only queued for the swap */
+  gegl_tile_backend_file_throttle ();
+}
+
+void
+gegl_tile_handler_cache_set_budget (GeglTileHandlerCache *cache,
+                                    guint64               budget)
+{
+  cache->budget = budget;
+
+  while (cache->budget && cache_get_handler_total (cache) > cache->budget)
+    {
+      CacheItem *oldest = gegl_tile_handler_cache_steal_oldest (cache, NULL, TRUE);
+
+      if (!oldest)
+        break;
+      g_atomic_int_add (&cache->count, -1);
+      gegl_tile_unref (oldest->tile);
+      g_slice_free (CacheItem, oldest);
+    }
+}
+
+guint64
+gegl_buffer_cache_shrink (guint64 target)
+{
+  guint64 before = cache_get_total ();
+  guint64 after;
+
+  while (cache_get_total () > target)
+    {
+      if (!gegl_tile_handler_cache_trim (NULL))
+        break;
     }
-  g_static_mutex_unlock (&mutex);
+
+  after = cache_get_total ();
+
+  gegl_tile_alloc_trim ();
+
+  return before > after ? before - after : 0;
+}
+
+void
+gegl_buffer_cache_set_pressure_func (GeglBufferCachePressureFunc func,
+                                     gpointer                    user_data)
+{
+  g_static_mutex_lock (&cache_total_mutex);
+  cache_pressure_func = func;
+  cache_pressure_data = user_data;
+  g_static_mutex_unlock (&cache_total_mutex);
+}
+
+guint64
+gegl_buffer_cache_get_total (void)
+{
+  return cache_get_total ();
+}
+
+void
+gegl_tile_handler_cache_mark_dirty (GeglTileHandlerCache *cache,
+                                    GeglTile             *tile)
+{
+  CacheShard *shard = cache_shard (cache, tile->x, tile->y, tile->z);
+  CacheItem  *item;
+
+  if (g_atomic_int_get (&cache->count) == 0)
+    return;
+
+  g_static_mutex_lock (&shard->mutex);
+  item = cache_lookup (shard, cache, tile->x, tile->y, tile->z);
+  if (item && item->tile == tile && !item->dirty)
+    cache_item_set_dirty (shard, item, TRUE);
+  g_static_mutex_unlock (&shard->mutex);
 }
 
 GeglTileHandlerCache *
@@ -586,22 +1099,42 @@ gegl_tile_handler_cache_equalfunc (gconstpointer a,
 void
 gegl_tile_cache_init (void)
 {
-  if (cache_queue == NULL)
-    cache_queue = g_queue_new ();
-  if (cache_ht == NULL)
-    cache_ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc, gegl_tile_handler_cache_equalfunc);
+  gint i;
+
+  if (cache_initialized)
+    return;
+
+  for (i = 0; i < CACHE_SHARDS; i++)
+    {
+      CacheShard *shard = &cache_shards[i];
+
+      g_static_mutex_init (&shard->mutex);
+      g_queue_init (&shard->clean);
+      g_queue_init (&shard->dirty);
+      shard->tick = 0;
+      shard->ht = g_hash_table_new (gegl_tile_handler_cache_hashfunc,
+                                    gegl_tile_handler_cache_equalfunc);
+    }
+  cache_initialized = TRUE;
 }
 
 void
 gegl_tile_cache_destroy (void)
 {
-  if (cache_queue)
+  gint i;
+
+  if (!cache_initialized)
+    return;
+
+  for (i = 0; i < CACHE_SHARDS; i++)
     {
-      while (g_queue_pop_head_link (cache_queue));
-      g_queue_free (cache_queue);
+      CacheShard *shard = &cache_shards[i];
+
+      while (g_queue_pop_head_link (&shard->clean));
+      while (g_queue_pop_head_link (&shard->dirty));
+      g_hash_table_destroy (shard->ht);
+      shard->ht = NULL;
+      g_static_mutex_free (&shard->mutex);
     }
-  if (cache_ht)
-    g_hash_table_destroy (cache_ht);
-  cache_queue = NULL;
-  cache_ht = NULL;
+  cache_initialized = FALSE;
 }
@@ -42,6 +42,10 @@ struct _GeglTileHandlerCache
   GeglTileStorage *tile_storage;
   GSList          *free_list;
   int              count; /* number of items held by cache */
+  GStaticMutex     mutex; /* protects queue and total */
+  GQueue           queue; /* items held by cache, most recent first */
+  guint64          total; /* bytes held by cache */
+  guint64          budget; /* bytes cache may hold, 0 for no limit */
 };
 
 struct _GeglTileHandlerCacheClass
@@ -56,5 +60,11 @@ void                   gegl_tile_handler_cache_insert   (GeglTileHandlerCache *c
                                                          gint                  x,
                                                          gint                  y,
                                                          gint                  z);
+void                   gegl_tile_handler_cache_mark_dirty
+                                                        (GeglTileHandlerCache *cache,
+                                                         GeglTile             *tile);
+void                   gegl_tile_handler_cache_set_budget
+                                                        (GeglTileHandlerCache *cache,
+                                                         guint64               budget);
 
 #endif
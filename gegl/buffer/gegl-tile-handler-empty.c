@@ -105,5 +105,6 @@ gegl_tile_handler_empty_new (GeglTileBackend      *backend,
   empty->cache = cache;
   empty->tile = gegl_tile_new (tile_size);
   memset (gegl_tile_get_data (empty->tile), 0x00, tile_size);
+  empty->tile->is_uniform = TRUE;
   return (void*)empty;
 }
@@ -36,6 +36,7 @@
 #include "gegl-tile.h"
 #include "gegl-tile-source.h"
 #include "gegl-tile-storage.h"
+#include "gegl-tile-alloc.h"
 
 #include "gegl-utils.h"
 
@@ -47,7 +48,12 @@ GeglTile *gegl_tile_ref (GeglTile *tile)
   return tile;
 }
 
+/* markers for the destroy_notify of tiles whose data is freed without a
+ * callback, data given to gegl_tile_set_data () is freed with gegl_free (),
+ * data of gegl_tile_alloc () with gegl_tile_free ()
+ */
 static int free_data_directly;
+static int free_tile_alloc_data;
 
 void gegl_tile_unref (GeglTile *tile)
 {
@@ -63,22 +69,30 @@ void gegl_tile_unref (GeglTile *tile)
 
   if (tile->data)
     {
-      if (tile->next_shared == tile)
-        { /* no clones */
+      gboolean clones;
+
+      g_static_mutex_lock (&cowmutex);
+      clones = tile->next_shared != tile;
+      if (clones)
+        {
+          tile->prev_shared->next_shared = tile->next_shared;
+          tile->next_shared->prev_shared = tile->prev_shared;
+        }
+      g_static_mutex_unlock (&cowmutex);
+
+      if (!clones)
+        {
           if (tile->destroy_notify)
             {
               if (tile->destroy_notify == (void*)&free_data_directly)
                 gegl_free (tile->data);
+              else if (tile->destroy_notify == (void*)&free_tile_alloc_data)
+                gegl_tile_free (tile->data);
               else
                 tile->destroy_notify (tile->destroy_notify_data);
             }
           tile->data = NULL;
         }
-      else
-        {
-          tile->prev_shared->next_shared = tile->next_shared;
-          tile->next_shared->prev_shared = tile->prev_shared;
-        }
     }
 
 #ifdef GEGL_USE_TILE_MUTEX
@@ -101,6 +115,7 @@ gegl_tile_new_bare (void)
   tile->stored_rev = 1;
   tile->rev        = 1;
   tile->lock       = 0;
+  tile->is_uniform = FALSE;
   tile->data       = NULL;
 
   tile->next_shared = tile;
@@ -122,8 +137,12 @@ gegl_tile_dup (GeglTile *src)
   GeglTile *tile = gegl_tile_new_bare ();
 
   tile->tile_storage    = src->tile_storage;
+
+  /* the tiles sharing data might be unreffed or uncloned in other threads */
+  g_static_mutex_lock (&cowmutex);
   tile->data       = src->data;
   tile->size       = src->size;
+  tile->is_uniform = src->is_uniform;
 
   tile->destroy_notify      = src->destroy_notify;
   tile->destroy_notify_data = src->destroy_notify_data;
@@ -131,29 +150,8 @@ gegl_tile_dup (GeglTile *src)
   tile->next_shared              = src->next_shared;
   src->next_shared               = tile;
   tile->prev_shared              = src;
-#ifdef GEGL_USE_TILE_MUTEX
-  if (tile->next_shared != src)
-    {
-      g_mutex_lock (tile->next_shared->mutex);
-    }
-#endif
-  if (tile->next_shared != src)
-    {
-      g_static_mutex_lock (&cowmutex);
-    }
-
   tile->next_shared->prev_shared = tile;
-
-  if (tile->next_shared != src)
-    {
-      g_static_mutex_unlock (&cowmutex);
-    }
-#ifdef GEGL_USE_TILE_MUTEX
-  if (tile->next_shared != src)
-    {
-      g_mutex_unlock (tile->next_shared->mutex);
-    }
-#endif
+  g_static_mutex_unlock (&cowmutex);
 
   return tile;
 }
@@ -163,9 +161,11 @@ gegl_tile_new (gint size)
 {
   GeglTile *tile = gegl_tile_new_bare ();
 
-  tile->data = gegl_malloc (size);
+  tile->data = gegl_tile_alloc (size);
   tile->size = size;
 
+  tile->destroy_notify = (void*)&free_tile_alloc_data;
+
   return tile;
 }
 
@@ -173,7 +173,7 @@ static gpointer
 gegl_memdup (gpointer src, gsize size)
 {
   gpointer ret;
-  ret = gegl_malloc (size);
+  ret = gegl_tile_alloc (size);
   memcpy (ret, src, size);
   return ret;
 }
@@ -181,21 +181,25 @@ gegl_memdup (gpointer src, gsize size)
 static void
 gegl_tile_unclone (GeglTile *tile)
 {
+  if (tile->next_shared == tile)
+    return;
+
+  g_static_mutex_lock (&cowmutex);
+  /* the other tiles might have gone away while we waited for the lock */
   if (tile->next_shared != tile)
     {
       /* the tile data is shared with other tiles,
        * create a local copy
        */
-      g_static_mutex_lock (&cowmutex);
       tile->data                     = gegl_memdup (tile->data, tile->size);
-      tile->destroy_notify           = (void*)&free_data_directly;
+      tile->destroy_notify           = (void*)&free_tile_alloc_data;
       tile->destroy_notify_data      = NULL;
       tile->prev_shared->next_shared = tile->next_shared;
       tile->next_shared->prev_shared = tile->prev_shared;
       tile->prev_shared              = tile;
       tile->next_shared              = tile;
-      g_static_mutex_unlock (&cowmutex);
     }
+  g_static_mutex_unlock (&cowmutex);
 }
 #if 0
 static gint total_locks   = 0;
@@ -221,6 +225,7 @@ gegl_tile_lock (GeglTile *tile)
 #endif
 
   tile->lock++;
+  tile->is_uniform = FALSE;
   /*fprintf (stderr, "global tile locking: %i %i\n", locks, unlocks);*/
 
   gegl_tile_unclone (tile);
@@ -238,7 +243,7 @@ _gegl_tile_void_pyramid (GeglTileSource *source,
   _gegl_tile_void_pyramid (source, x/2, y/2, z+1);
 }
 
-static void
+void
 gegl_tile_void_pyramid (GeglTile *tile)
 {
   if (tile->tile_storage &&
@@ -276,7 +281,17 @@ gegl_tile_unlock (GeglTile *tile)
       gegl_tile_void_pyramid (tile);
     }
   if (tile->lock==0)
-    tile->rev++;
+    {
+      gboolean was_stored = gegl_tile_is_stored (tile);
+
+      tile->rev++;
+
+      /* let the cache move the tile over to its dirty tiles */
+      if (was_stored &&
+          tile->tile_storage &&
+          tile->tile_storage->cache)
+        gegl_tile_handler_cache_mark_dirty (tile->tile_storage->cache, tile);
+    }
 #ifdef GEGL_USE_TILE_MUTEX
   g_mutex_unlock (tile->mutex);
 #endif
@@ -328,8 +343,10 @@ void gegl_tile_set_data (GeglTile *tile,
                          gpointer  pixel_data,
                          gint      pixel_data_size)
 {
-  tile->data = pixel_data;
-  tile->size = pixel_data_size;
+  tile->data                = pixel_data;
+  tile->size                = pixel_data_size;
+  tile->destroy_notify      = (void*)&free_data_directly;
+  tile->destroy_notify_data = NULL;
 }
 
 void gegl_tile_set_data_full (GeglTile      *tile,
@@ -49,6 +49,7 @@ void         gegl_tile_set_rev        (GeglTile         *tile,
 guint        gegl_tile_get_rev        (GeglTile         *tile);
 
 guchar      *gegl_tile_get_data       (GeglTile         *tile);
+/* pixel_data is freed with gegl_free () along with the tile */
 void         gegl_tile_set_data       (GeglTile         *tile,
                                        gpointer          pixel_data,
                                        gint              pixel_data_size);
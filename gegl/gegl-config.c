@@ -26,6 +26,10 @@
 #include "gegl-types-internal.h"
 #include "gegl-config.h"
 
+#include "buffer/gegl-buffer-private.h"
+#include "buffer/gegl-tile-alloc.h"
+#include "buffer/gegl-tile-compression.h"
+
 #include "opencl/gegl-cl.h"
 
 G_DEFINE_TYPE (GeglConfig, gegl_config, G_TYPE_OBJECT)
@@ -37,7 +41,13 @@ enum
   PROP_0,
   PROP_QUALITY,
   PROP_CACHE_SIZE,
+  PROP_CACHE_BYTES,
+  PROP_RESULT_CACHE_SIZE,
+  PROP_CACHE_POLICY,
+  PROP_TILE_COMPRESSION,
+  PROP_TILE_HUGE_PAGES,
   PROP_CHUNK_SIZE,
+  PROP_QUEUE_SIZE,
   PROP_SWAP,
   PROP_BABL_TOLERANCE,
   PROP_TILE_WIDTH,
@@ -57,13 +67,37 @@ gegl_config_get_property (GObject    *gobject,
   switch (property_id)
     {
       case PROP_CACHE_SIZE:
-        g_value_set_int (value, config->cache_size);
+        g_value_set_int (value, MIN (config->cache_size, G_MAXINT));
+        break;
+
+      case PROP_CACHE_BYTES:
+        g_value_set_uint64 (value, config->cache_size);
+        break;
+
+      case PROP_RESULT_CACHE_SIZE:
+        g_value_set_uint64 (value, config->result_cache_size);
+        break;
+
+      case PROP_CACHE_POLICY:
+        g_value_set_string (value, config->cache_policy);
+        break;
+
+      case PROP_TILE_COMPRESSION:
+        g_value_set_string (value, config->tile_compression);
+        break;
+
+      case PROP_TILE_HUGE_PAGES:
+        g_value_set_boolean (value, config->tile_huge_pages);
         break;
 
       case PROP_CHUNK_SIZE:
         g_value_set_int (value, config->chunk_size);
         break;
 
+      case PROP_QUEUE_SIZE:
+        g_value_set_int (value, config->queue_size);
+        break;
+
       case PROP_TILE_WIDTH:
         g_value_set_int (value, config->tile_width);
         break;
@@ -111,9 +145,34 @@ gegl_config_set_property (GObject      *gobject,
       case PROP_CACHE_SIZE:
         config->cache_size = g_value_get_int (value);
         break;
+      case PROP_CACHE_BYTES:
+        config->cache_size = g_value_get_uint64 (value);
+        break;
+      case PROP_RESULT_CACHE_SIZE:
+        config->result_cache_size = g_value_get_uint64 (value);
+        break;
+      case PROP_CACHE_POLICY:
+        if (config->cache_policy)
+         g_free (config->cache_policy);
+        config->cache_policy = g_value_dup_string (value);
+        gegl_tile_cache_set_policy (config->cache_policy);
+        break;
+      case PROP_TILE_COMPRESSION:
+        if (config->tile_compression)
+         g_free (config->tile_compression);
+        config->tile_compression = g_value_dup_string (value);
+        gegl_tile_compression_set_default (config->tile_compression);
+        break;
+      case PROP_TILE_HUGE_PAGES:
+        config->tile_huge_pages = g_value_get_boolean (value);
+        gegl_tile_alloc_set_huge_pages (config->tile_huge_pages);
+        break;
       case PROP_CHUNK_SIZE:
         config->chunk_size = g_value_get_int (value);
         break;
+      case PROP_QUEUE_SIZE:
+        config->queue_size = g_value_get_int (value);
+        break;
       case PROP_TILE_WIDTH:
         config->tile_width = g_value_get_int (value);
         break;
@@ -181,6 +240,12 @@ gegl_config_finalize (GObject *gobject)
   if (config->swap)
     g_free (config->swap);
 
+  if (config->cache_policy)
+    g_free (config->cache_policy);
+
+  if (config->tile_compression)
+    g_free (config->tile_compression);
+
   G_OBJECT_CLASS (gegl_config_parent_class)->finalize (gobject);
 }
 
@@ -215,10 +280,50 @@ gegl_config_class_init (GeglConfigClass *klass)
   g_object_class_install_property (gobject_class, PROP_CACHE_SIZE,
                                    g_param_spec_int ("cache-size",
                                                      "Cache size",
-                                                     "size of cache in bytes",
+                                                     "size of cache in bytes, a view of cache-bytes limited to 2GB",
                                                      0, G_MAXINT, 512 * 1024 * 1024,
-                                                     G_PARAM_READWRITE |
-                                                     G_PARAM_CONSTRUCT));
+                                                     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_CACHE_BYTES,
+                                   g_param_spec_uint64 ("cache-bytes",
+                                                        "Cache bytes",
+                                                        "size of cache in bytes, also set by cache-size",
+                                                        0, G_MAXUINT64,
+                                                        (guint64) 512 * 1024 * 1024,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_RESULT_CACHE_SIZE,
+                                   g_param_spec_uint64 ("result-cache-size",
+                                                        "Result cache size",
+                                                        "bytes of results shared between graphs with identical nodes, 0 disables sharing",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_CACHE_POLICY,
+                                   g_param_spec_string ("cache-policy",
+                                                        "Cache policy",
+                                                        "eviction policy of the tile cache, \"lru\" or \"clock\"",
+                                                        "lru",
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_COMPRESSION,
+                                   g_param_spec_string ("tile-compression",
+                                                        "Tile compression",
+                                                        "how tiles outside the cache are compressed in memory, \"none\", \"rle\" or \"delta-rle\"",
+                                                        "none",
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_CONSTRUCT));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_HUGE_PAGES,
+                                   g_param_spec_boolean ("tile-huge-pages",
+                                                         "Tile huge pages",
+                                                         "back the memory of tiles with huge pages where supported",
+                                                         FALSE,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_CONSTRUCT));
 
 
   g_object_class_install_property (gobject_class, PROP_CHUNK_SIZE,
@@ -229,6 +334,14 @@ gegl_config_class_init (GeglConfigClass *klass)
                                                      G_PARAM_READWRITE |
                                                      G_PARAM_CONSTRUCT));
 
+  g_object_class_install_property (gobject_class, PROP_QUEUE_SIZE,
+                                   g_param_spec_int ("queue-size",
+                                                     "Queue size",
+                                                     "maximum number of bytes of tiles waiting to be written to swap, the cache can go past it while evicting and waits for the writer once it has let go of its locks",
+                                                     0, G_MAXINT, 50 * 1024 * 1024,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT));
+
   g_object_class_install_property (gobject_class, PROP_QUALITY,
                                    g_param_spec_double ("quality",
                                                         "Quality",
@@ -38,8 +38,15 @@ struct _GeglConfig
   GObject  parent_instance;
 
   gchar   *swap;
-  gint     cache_size;
+  guint64  cache_size;
+  guint64  result_cache_size; /* bytes of results shared between graphs,
+                                 0 disables sharing */
+  gchar   *cache_policy;
+  gchar   *tile_compression;
+  gboolean tile_huge_pages;
   gint     chunk_size; /* The size of elements being processed at once */
+  gint     queue_size; /* bytes of tiles waiting to be written to swap,
+                        at least one tile is let through */
   gdouble  quality;
   gdouble  babl_tolerance;
   gint     tile_width;
@@ -94,6 +94,7 @@ guint gegl_debug_flags = 0;
 #include "buffer/gegl-buffer-private.h"
 #include "gegl-config.h"
 #include "graph/gegl-node.h"
+#include "process/gegl-result-cache.h"
 
 
 /* if this function is made to return NULL swapping is disabled */
@@ -202,6 +203,9 @@ gegl_init (gint    *argc,
 
 static gchar   *cmd_gegl_swap=NULL;
 static gchar   *cmd_gegl_cache_size=NULL;
+static gchar   *cmd_gegl_result_cache_size=NULL;
+static gchar   *cmd_gegl_cache_policy=NULL;
+static gchar   *cmd_gegl_tile_compression=NULL;
 static gchar   *cmd_gegl_chunk_size=NULL;
 static gchar   *cmd_gegl_quality=NULL;
 static gchar   *cmd_gegl_tile_size=NULL;
@@ -225,6 +229,21 @@ static const GOptionEntry cmd_entries[]=
      G_OPTION_ARG_STRING, &cmd_gegl_cache_size,
      N_("How much memory to (approximately) use for caching imagery"), "<megabytes>"
     },
+    {
+     "gegl-result-cache-size", 0, 0,
+     G_OPTION_ARG_STRING, &cmd_gegl_result_cache_size,
+     N_("How much memory to use for results shared between graphs"), "<megabytes>"
+    },
+    {
+     "gegl-cache-policy", 0, 0,
+     G_OPTION_ARG_STRING, &cmd_gegl_cache_policy,
+     N_("Eviction policy of the tile cache"), "<lru|clock>"
+    },
+    {
+     "gegl-tile-compression", 0, 0,
+     G_OPTION_ARG_STRING, &cmd_gegl_tile_compression,
+     N_("How tiles outside the cache are compressed in memory"), "<none|rle|delta-rle>"
+    },
     {
      "gegl-tile-size", 0, 0,
      G_OPTION_ARG_STRING, &cmd_gegl_tile_size,
@@ -280,7 +299,18 @@ GeglConfig *gegl_config (void)
       if (g_getenv ("GEGL_QUALITY"))
         config->quality = atof(g_getenv("GEGL_QUALITY"));
       if (g_getenv ("GEGL_CACHE_SIZE"))
-        config->cache_size = atoi(g_getenv("GEGL_CACHE_SIZE"))* 1024*1024;
+        config->cache_size =
+          g_ascii_strtoull (g_getenv ("GEGL_CACHE_SIZE"), NULL, 10) * 1024 * 1024;
+      if (g_getenv ("GEGL_RESULT_CACHE_SIZE"))
+        config->result_cache_size =
+          g_ascii_strtoull (g_getenv ("GEGL_RESULT_CACHE_SIZE"), NULL, 10) * 1024 * 1024;
+      if (g_getenv ("GEGL_CACHE_POLICY"))
+        g_object_set (config, "cache-policy", g_getenv ("GEGL_CACHE_POLICY"), NULL);
+      if (g_getenv ("GEGL_TILE_COMPRESSION"))
+        g_object_set (config, "tile-compression", g_getenv ("GEGL_TILE_COMPRESSION"), NULL);
+      if (g_getenv ("GEGL_TILE_HUGE_PAGES"))
+        g_object_set (config, "tile-huge-pages",
+                      g_str_equal (g_getenv ("GEGL_TILE_HUGE_PAGES"), "yes"), NULL);
       if (g_getenv ("GEGL_CHUNK_SIZE"))
         config->chunk_size = atoi(g_getenv("GEGL_CHUNK_SIZE"));
       if (g_getenv ("GEGL_TILE_SIZE"))
@@ -316,6 +346,7 @@ GeglConfig *gegl_config (void)
 void gegl_tile_backend_ram_stats (void);
 void gegl_tile_backend_tiledir_stats (void);
 void gegl_tile_backend_file_stats (void);
+void gegl_tile_backend_file_cleanup (void);
 
 
 static void swap_clean (void)
@@ -362,8 +393,10 @@ gegl_exit (void)
 {
   glong timing = gegl_ticks ();
 
+  gegl_result_cache_cleanup ();
   gegl_tile_storage_cache_cleanup ();
   gegl_tile_cache_destroy ();
+  gegl_tile_backend_file_cleanup ();
   gegl_operation_gtype_cleanup ();
   gegl_extension_handler_cleanup ();
 
@@ -485,7 +518,15 @@ gegl_post_parse_hook (GOptionContext *context,
   if (cmd_gegl_quality)
     config->quality = atof (cmd_gegl_quality);
   if (cmd_gegl_cache_size)
-    config->cache_size = atoi (cmd_gegl_cache_size)*1024*1024;
+    config->cache_size =
+      g_ascii_strtoull (cmd_gegl_cache_size, NULL, 10) * 1024 * 1024;
+  if (cmd_gegl_result_cache_size)
+    config->result_cache_size =
+      g_ascii_strtoull (cmd_gegl_result_cache_size, NULL, 10) * 1024 * 1024;
+  if (cmd_gegl_cache_policy)
+    g_object_set (config, "cache-policy", cmd_gegl_cache_policy, NULL);
+  if (cmd_gegl_tile_compression)
+    g_object_set (config, "tile-compression", cmd_gegl_tile_compression, NULL);
   if (cmd_gegl_chunk_size)
     config->chunk_size = atoi (cmd_gegl_chunk_size);
   if (cmd_gegl_tile_size)
@@ -284,6 +284,78 @@ sort_children (Timing *parent)
     }
 }
 
+#define CONVERSIONS_COL  64
+
+typedef struct _Conversion Conversion;
+
+struct _Conversion
+{
+  const gchar *from;
+  const gchar *to;
+  long         count;
+  long         bytes;
+  Conversion  *next;
+};
+
+static Conversion   *conversions      = NULL;
+static GStaticMutex  conversion_mutex = G_STATIC_MUTEX_INIT;
+
+void
+gegl_instrument_conversion (const gchar *from,
+                            const gchar *to,
+                            long         bytes)
+{
+  Conversion *iter;
+
+  g_static_mutex_lock (&conversion_mutex);
+  for (iter = conversions; iter; iter = iter->next)
+    if (!strcmp (iter->from, from) && !strcmp (iter->to, to))
+      break;
+
+  if (!iter)
+    {
+      iter        = g_slice_new0 (Conversion);
+      iter->from  = from;
+      iter->to    = to;
+      iter->next  = conversions;
+      conversions = iter;
+    }
+
+  iter->count++;
+  iter->bytes += bytes;
+  g_static_mutex_unlock (&conversion_mutex);
+}
+
+static GString *
+conversions_utf8 (GString *s)
+{
+  Conversion *iter;
+
+  if (!conversions)
+    return s;
+
+  s = g_string_append (s, "Conversions between nodes:\n");
+
+  g_static_mutex_lock (&conversion_mutex);
+  for (iter = conversions; iter; iter = iter->next)
+    {
+      gchar *buf;
+
+      s   = tab_to (s, INDENT_SPACES);
+      buf = g_strdup_printf ("%s -> %s", iter->from, iter->to);
+      s   = g_string_append (s, buf);
+      g_free (buf);
+      s   = tab_to (s, CONVERSIONS_COL);
+      buf = g_strdup_printf ("%6li %8.1fMB\n", iter->count,
+                             iter->bytes / 1024.0 / 1024.0);
+      s   = g_string_append (s, buf);
+      g_free (buf);
+    }
+  g_static_mutex_unlock (&conversion_mutex);
+
+  return s;
+}
+
 gchar *
 gegl_instrument_utf8 (void)
 {
@@ -335,6 +407,8 @@ gegl_instrument_utf8 (void)
       iter = iter_next (iter);
     }
 
+  s = conversions_utf8 (s);
+
   ret = g_strdup (s->str);
   g_string_free (s, TRUE);
   return ret;
@@ -33,4 +33,11 @@ void gegl_instrument          (const gchar *parent,
  */
 gchar * gegl_instrument_utf8 (void);
 
+/* count a conversion of bytes worth of pixels between two formats, the
+ * names are expected to stay around, the counts are listed after the
+ * timings by gegl_instrument_utf8 */
+void gegl_instrument_conversion (const gchar *from,
+                                 const gchar *to,
+                                 long         bytes);
+
 #endif
@@ -69,6 +69,9 @@ GType gegl_processor_get_type  (void) G_GNUC_CONST;
 #define GEGL_PROCESSOR(obj)    (G_TYPE_CHECK_INSTANCE_CAST ((obj), GEGL_TYPE_PROCESSOR, GeglProcessor))
 #define GEGL_IS_PROCESSOR(obj) (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GEGL_TYPE_PROCESSOR))
 
+typedef gdouble (*GeglProcessorPriorityFunc) (const GeglRectangle *chunk,
+                                              gpointer             user_data);
+
 G_END_DECLS
 
 #endif /* __GEGL_TYPES_H__ */
@@ -204,6 +204,36 @@
             rectangle->height == G_MAXINT);
   }
 
+  void
+  gegl_rectangle_to_level (GeglRectangle       *dest,
+                           const GeglRectangle *rectangle,
+                           gint                 level)
+  {
+    gint factor = 1 << level;
+    gint x0, y0, x1, y1;
+
+    if (level <= 0 || gegl_rectangle_is_infinite_plane (rectangle))
+      {
+        *dest = *rectangle;
+        return;
+      }
+
+    /* rounding outwards, the pixels of the level cover the rectangle */
+    x0 = rectangle->x >= 0 ? rectangle->x / factor
+                           : - ((factor - 1 - rectangle->x) / factor);
+    y0 = rectangle->y >= 0 ? rectangle->y / factor
+                           : - ((factor - 1 - rectangle->y) / factor);
+    x1 = rectangle->x + rectangle->width;
+    y1 = rectangle->y + rectangle->height;
+    x1 = x1 >= 0 ? (x1 + factor - 1) / factor : - ((- x1) / factor);
+    y1 = y1 >= 0 ? (y1 + factor - 1) / factor : - ((- y1) / factor);
+
+    dest->x      = x0;
+    dest->y      = y0;
+    dest->width  = rectangle->width  > 0 ? x1 - x0 : 0;
+    dest->height = rectangle->height > 0 ? y1 - y0 : 0;
+  }
+
   void
   gegl_rectangle_dump (const GeglRectangle *rectangle)
   {
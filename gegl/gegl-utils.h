@@ -162,6 +162,21 @@ GeglRectangle gegl_rectangle_infinite_plane (void);
  */
 gboolean gegl_rectangle_is_infinite_plane (const GeglRectangle *rectangle);
 
+/**
+ * gegl_rectangle_to_level:
+ * @dest: a #GeglRectangle
+ * @rectangle: a #GeglRectangle
+ * @level: the level, 0 is 1:1, 1 is 1:2, 2 is 1:4 ..
+ *
+ * Stores in @dest the rectangle covering @rectangle in the coordinates of
+ * the given level, @dest and @rectangle may be the same rectangle.
+ *
+ * For internal use, not stable API.
+ */
+void     gegl_rectangle_to_level          (GeglRectangle       *dest,
+                                           const GeglRectangle *rectangle,
+                                           gint                 level);
+
 /**
  * gegl_rectangle_dump:
  * @rectangle: A GeglRectangle.
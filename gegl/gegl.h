@@ -783,7 +783,9 @@ GeglProcessor *gegl_node_new_processor      (GeglNode            *node,
  * @rectangle: the new #GeglRectangle the processor shold work on or NULL
  * to make it work on all data in the buffer.
  *
- * Change the rectangle a #GeglProcessor is working on.
+ * Change the rectangle a #GeglProcessor is working on. Work queued for the
+ * parts of the previous rectangle that are out of the new one is dropped,
+ * the rest is ordered again for the new rectangle.
  */
 void           gegl_processor_set_rectangle (GeglProcessor       *processor,
                                              const GeglRectangle *rectangle);
@@ -805,10 +807,75 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
  * while (gegl_processor_work (processor, &progress))
  *   g_warning ("%f%% complete", progress);
  * g_object_unref (processor);
+ * ---
+ *
+ * When the #GCancellable set as the "cancellable" property of the processor
+ * is cancelled, from any thread, the chunk being rendered is abandoned and
+ * FALSE is returned until the cancellable is reset with
+ * g_cancellable_reset(), after which the work carries on where it stopped.
  */
 gboolean       gegl_processor_work          (GeglProcessor *processor,
                                              gdouble       *progress);
 
+/**
+ * gegl_processor_work_for:
+ * @processor: a #GeglProcessor
+ * @msecs: the number of milliseconds to work for
+ * @progress: a location to store the (estimated) percentage complete.
+ *
+ * Do iterations of work for the processor until there is no more work or
+ * @msecs have passed, for instance from an idle handler of a user
+ * interface. The chunks rendered are made smaller as the time runs out,
+ * based on how fast the processor has rendered so far, so the time is
+ * only exceeded by the first chunk and by writing the result to a sink.
+ *
+ * Returns TRUE if there is more work to be done.
+ */
+gboolean       gegl_processor_work_for      (GeglProcessor *processor,
+                                             gint           msecs,
+                                             gdouble       *progress);
+
+/**
+ * gegl_processor_set_focus:
+ * @processor: a #GeglProcessor
+ * @x: x coordinate of the focus
+ * @y: y coordinate of the focus
+ *
+ * Makes the processor render the chunks closest to (@x, @y) first, for
+ * instance the point under the pointer in a viewer. Without a focus the
+ * chunks closest to the center of the rectangle of the processor come
+ * first.
+ */
+void           gegl_processor_set_focus     (GeglProcessor *processor,
+                                             gint           x,
+                                             gint           y);
+
+/**
+ * GeglProcessorPriorityFunc:
+ * @chunk: a rectangle the processor is about to queue
+ * @user_data: the data passed to gegl_processor_set_priority_func()
+ *
+ * Returns: the priority of @chunk, chunks with lower values are rendered
+ * first.
+ */
+
+/**
+ * gegl_processor_set_priority_func:
+ * @processor: a #GeglProcessor
+ * @func: (allow-none): the function ordering the chunks, or NULL to order
+ * them by the distance to the focus
+ * @user_data: data to pass to @func
+ * @destroy: (allow-none): called with @user_data when it is no longer used
+ *
+ * Sets the order in which the processor renders the chunks of its
+ * rectangle, in place of the distance to the focus.
+ */
+void           gegl_processor_set_priority_func
+                                            (GeglProcessor             *processor,
+                                             GeglProcessorPriorityFunc  func,
+                                             gpointer                   user_data,
+                                             GDestroyNotify             destroy);
+
 
 /***
  * GeglConfig:
@@ -825,6 +892,9 @@ gboolean       gegl_processor_work          (GeglProcessor *processor,
  * "cache-size" "quality" and "swap", the two first is an integer denoting
  * number of bytes, the secons a double value between 0 and 1 and the last
  * the path of the directory to swap to (or "ram" to not use diskbased swap)
+ *
+ * "cache-bytes" is the same size as "cache-size" as a 64 bit unsigned
+ * integer, for caches of 2GB and more, "cache-size" reads G_MAXINT then.
  */
 GeglConfig      * gegl_config (void);
 
@@ -44,6 +44,7 @@
 #include "process/gegl-prepare-visitor.h"
 #include "process/gegl-finish-visitor.h"
 #include "process/gegl-processor.h"
+#include "process/gegl-scheduler.h"
 
 enum
 {
@@ -71,7 +72,9 @@ struct _GeglNodePrivate
   gchar           *name;
   GeglProcessor   *processor;
   GHashTable      *contexts;
-  GeglEvalManager *eval_manager[GEGL_MAX_THREADS];
+  GSList          *eval_managers; /* idle eval managers, one is leased for
+                                     every request */
+  gchar           *result_key;    /* memoized gegl_node_get_result_key () */
 };
 
 
@@ -112,6 +115,7 @@ static void            gegl_node_disconnect_sources       (GeglNode      *self);
 static void            gegl_node_property_changed         (GObject       *gobject,
                                                            GParamSpec    *arg1,
                                                            gpointer       user_data);
+static void            gegl_node_forget_result_key        (GeglNode      *self);
 
 
 G_DEFINE_TYPE_WITH_CODE (GeglNode, gegl_node, G_TYPE_OBJECT,
@@ -232,15 +236,12 @@ gegl_node_dispose (GObject *gobject)
       self->cache = NULL;
     }
 
-  {
-    gint i;
-    for (i=0; i<GEGL_MAX_THREADS; i++)
-      if (self->priv->eval_manager[i])
-        {
-          g_object_unref (self->priv->eval_manager[i]);
-          self->priv->eval_manager[i] = NULL;
-        }
-  }
+  if (self->priv->eval_managers)
+    {
+      g_slist_foreach (self->priv->eval_managers, (GFunc) g_object_unref, NULL);
+      g_slist_free (self->priv->eval_managers);
+      self->priv->eval_managers = NULL;
+    }
 
   if (self->priv->processor)
     {
@@ -278,6 +279,7 @@ gegl_node_finalize (GObject *gobject)
     {
       g_free (self->priv->name);
     }
+  g_free (self->priv->result_key);
   g_hash_table_destroy (self->priv->contexts);
   g_mutex_free (self->mutex);
 
@@ -536,6 +538,8 @@ gegl_node_invalidated (GeglNode            *node,
   if (!rect)
     rect = &node->have_rect;
 
+  gegl_node_forget_result_key (node);
+
   if (node->cache)
     {
       if (rect && clear_cache)
@@ -863,89 +867,119 @@ gegl_node_link_many (GeglNode *source,
   va_end (var_args);
 }
 
-static void gegl_node_ensure_eval_manager (GeglNode    *self,
-                                       const gchar *pad,
-                                       gint         no)
+/* The per request state of an evaluation lives in the contexts of its eval
+ * manager, a manager evaluates one request at a time. Requests lease an
+ * idle manager of the node, or a new one when they are all busy, so any
+ * number of threads can render regions of the same node at once.
+ */
+static GeglEvalManager *
+gegl_node_lease_eval_manager (GeglNode    *self,
+                              const gchar *pad)
+{
+  GeglEvalManager *manager = NULL;
+  GSList          *iter;
+
+  g_mutex_lock (self->mutex);
+  for (iter = self->priv->eval_managers; iter; iter = g_slist_next (iter))
+    {
+      GeglEvalManager *idle = iter->data;
+
+      if (!strcmp (idle->pad_name, pad))
+        {
+          manager = idle;
+          self->priv->eval_managers =
+            g_slist_delete_link (self->priv->eval_managers, iter);
+          break;
+        }
+    }
+  g_mutex_unlock (self->mutex);
+
+  if (!manager)
+    manager = gegl_eval_manager_new (self, pad);
+
+  return manager;
+}
+
+static void
+gegl_node_release_eval_manager (GeglNode        *self,
+                                GeglEvalManager *manager)
 {
-  if (!self->priv->eval_manager[no])
-    self->priv->eval_manager[no] = gegl_eval_manager_new (self, pad);
+  g_mutex_lock (self->mutex);
+  self->priv->eval_managers = g_slist_prepend (self->priv->eval_managers,
+                                               manager);
+  g_mutex_unlock (self->mutex);
 }
 
-/* Will set the eval_manager's roi to the supplied roi if defined, otherwise
- * it will use the node's bounding box. Then the gegl_eval_manager_apply will
- * be called.
+/* Will set the roi of a leased eval_manager to the supplied roi if defined,
+ * otherwise it will use the node's bounding box. Then the
+ * gegl_eval_manager_apply will be called. The roi is in the coordinates
+ * of the level rendered at.
  */
 static GeglBuffer *
 gegl_node_apply_roi (GeglNode            *self,
                      const gchar         *output_pad_name,
                      const GeglRectangle *roi,
-                     gint                 tid)
+                     gint                 level)
 {
-  /* This is a potential spot to multiplex paralell processing,
-   * doing so, might cause a lot of tile overlap between
-   * processes if were not careful (wouldn't neccesarily be totally
-   * bad if that happens though.
-   */
-  GeglBuffer *buffer;
+  GeglEvalManager *manager;
+  GeglBuffer      *buffer;
 
-  /*g_print ("%i %i %i %i %i\n", tid, roi->x, roi->y, roi->width, roi->height);*/
+  manager = gegl_node_lease_eval_manager (self, output_pad_name);
+  manager->level = level;
 
   if (roi)
     {
-      self->priv->eval_manager[tid]->roi = *roi;
+      manager->roi = *roi;
     }
   else
     {
-      self->priv->eval_manager[tid]->roi = gegl_node_get_bounding_box (self);
+      GeglRectangle bounding_box = gegl_node_get_bounding_box (self);
+
+      gegl_rectangle_to_level (&manager->roi, &bounding_box, level);
     }
-  buffer = gegl_eval_manager_apply (self->priv->eval_manager[tid]);
+  buffer = gegl_eval_manager_apply (manager);
+
+  gegl_node_release_eval_manager (self, manager);
   return buffer;
 }
 
 
-typedef struct ThreadData
+typedef struct
 {
   GeglNode      *node;
-  gint           tid;
-  GeglRectangle  roi;
   const gchar   *pad;
+  GeglRectangle  roi;
 
-  const Babl          *format;
-  gpointer             destination_buf;
-  gint                 rowstride;
-  GeglBlitFlags        flags;
-} ThreadData;
-
-static GThreadPool *pool = NULL;
-static GMutex *mutex = NULL;
-static GCond  *cond = NULL;
-static gint    remaining_tasks = 0;
+  const Babl    *format;
+  gpointer       destination_buf;
+  gint           rowstride;
+  gint           bpp;
+} BlitData;
 
-static void spawnrender (gpointer data,
-                         gpointer foo)
+static void
+gegl_node_blit_unit (const GeglRectangle *unit,
+                     gint                 worker,
+                     gpointer             user_data)
 {
-  ThreadData *td = data;
-  GeglBuffer * buffer;
-  buffer = gegl_node_apply_roi (td->node, td->pad, &td->roi, td->tid);
+  BlitData   *data = user_data;
+  GeglBuffer *buffer;
 
-  if ((buffer ) && td->destination_buf)
+  buffer = gegl_node_apply_roi (data->node, data->pad, unit, 0);
+
+  if (buffer && data->destination_buf)
     {
-      gegl_buffer_get (buffer, &td->roi, 1.0, td->format, td->destination_buf, td->rowstride,
+      guchar *dest = data->destination_buf;
+
+      dest += (unit->y - data->roi.y) * data->rowstride +
+              (unit->x - data->roi.x) * data->bpp;
+
+      gegl_buffer_get (buffer, unit, 1.0, data->format, dest, data->rowstride,
                        GEGL_ABYSS_NONE);
     }
 
   /* and unrefing to ultimately clean it off from the graph */
   if (buffer)
     g_object_unref (buffer);
-
-  g_mutex_lock (mutex);
-  remaining_tasks --;
-  if (remaining_tasks == 0)
-    {
-      /* we were the last task, we're not busy rendering any more */
-      g_cond_signal (cond);
-    }
-  g_mutex_unlock (mutex);
 }
 
 
@@ -966,116 +1000,33 @@ gegl_node_blit (GeglNode            *self,
   if (threads > GEGL_MAX_THREADS)
     threads = 1;
 
-  if (pool == NULL)
-    {
-      pool = g_thread_pool_new (spawnrender, NULL, threads, TRUE, NULL);
-      mutex = g_mutex_new ();
-      cond = g_cond_new ();
-    }
-
   if (flags == GEGL_BLIT_DEFAULT)
-#if 1  /* multi threaded version */
     {
-      ThreadData data[GEGL_MAX_THREADS];
-      gint i;
-
-      /* Subdivide along the largest of width/height, this should be further
-       * extended similar to the subdivizion done in GeglProcessor, to get as
-       * square as possible subregions.
-       */
-      gboolean horizontal = roi->width > roi->height;
-
-      gint rowskip = 0;
+      BlitData data;
 
       if (!format)
         format = babl_format ("RGBA float"); /* XXX: This probably duplicates
                                                 another hardcoded format, they
                                                 should be turned into a
                                                 constant. */
-      if (horizontal)
-        rowskip = (roi->width/threads) * babl_format_get_bytes_per_pixel (format);
-
-      if (rowstride == GEGL_AUTO_ROWSTRIDE)
-        rowstride = roi->width * babl_format_get_bytes_per_pixel (format);
-
-      data[0].node = self;
-      data[0].pad = "output";
-      data[0].format = format;
-      data[0].destination_buf = destination_buf;
-      data[0].rowstride = rowstride;
-      data[0].flags = flags;
 
-      for (i=0;i<threads;i++)
-        {
-          data[i] = data[0];
-          data[i].roi = *roi;
-          gegl_node_ensure_eval_manager (self, "output", i);
-          if (horizontal)
-            {
-              data[i].roi.width = roi->width / threads;
-              data[i].roi.x = roi->x + roi->width/threads * i;
-            }
-          else
-            {
-              data[i].roi.height = roi->height / threads;
-              data[i].roi.y = roi->y + roi->height/threads * i;
-            }
-
-          data[i].tid = i;
-          if (horizontal)
-            data[i].destination_buf = ((gchar*)destination_buf + rowskip * i);
-          else
-            data[i].destination_buf = ((gchar*)destination_buf + rowstride * (roi->height/threads) * i);
-        }
-      if (horizontal)
-        data[threads-1].roi.width = roi->width - (roi->width / threads)*(threads-1);
-      else
-        data[threads-1].roi.height = roi->height - (roi->height / threads)*(threads-1);
+      data.node            = self;
+      data.pad             = "output";
+      data.roi             = *roi;
+      data.format          = format;
+      data.destination_buf = destination_buf;
+      data.bpp             = babl_format_get_bytes_per_pixel (format);
+      data.rowstride       = rowstride;
 
-      remaining_tasks+=threads;
+      if (rowstride == GEGL_AUTO_ROWSTRIDE)
+        data.rowstride = roi->width * data.bpp;
 
-      if (threads==1)
-        {
-          spawnrender (&data[0], NULL);
-        }
-      else
-        {
-          for (i=0; i<threads-1; i++)
-            g_thread_pool_push (pool, &data[i], NULL);
-          spawnrender (&data[threads-1], NULL);
-
-          g_mutex_lock (mutex);
-          while (remaining_tasks!=0)
-            g_cond_wait (cond, mutex);
-          g_mutex_unlock (mutex);
-        }
-    }
-#else /* thread free version, could be removed, left behind in case it 
-         is needed for debugging
+      /* the request is split into tile aligned units, idle workers steal
+       * units from busy ones so that cheap and expensive parts of the
+       * request balance out
        */
-    {
-      GeglBuffer *buffer;
-
-      gegl_node_ensure_eval_manager (self, "output", 0);
-      buffer = gegl_node_apply_roi (self, "output", roi, 0);
-      if (buffer && destination_buf)
-        {
-          if (destination_buf)
-            {
-              gegl_buffer_get (buffer, 1.0, roi, format, destination_buf, rowstride);
-            }
-
-          if (scale != 1.0)
-            {
-              g_warning ("Scale %f!=1.0 in blit without cache NYI", scale);
-            }
-        }
-
-      /* and unrefing to ultimately clean it off from the graph */
-      if (buffer)
-        g_object_unref (buffer);
+      gegl_scheduler_run (roi, threads, gegl_node_blit_unit, &data);
     }
-#endif
   else
     if ((flags & GEGL_BLIT_CACHE))
     {
@@ -1097,6 +1048,21 @@ gegl_node_blit (GeglNode            *self,
     }
 }
 
+/* Renders roi of the output of the node at a level coarser than 1:1, roi
+ * and the returned buffer are in the coordinates of the level. All the
+ * operations involved should be level aware.
+ */
+GeglBuffer *
+gegl_node_render_level (GeglNode            *self,
+                        const GeglRectangle *roi,
+                        gint                 level)
+{
+  g_return_val_if_fail (GEGL_IS_NODE (self), NULL);
+  g_return_val_if_fail (roi != NULL, NULL);
+
+  return gegl_node_apply_roi (self, "output", roi, level);
+}
+
 static GSList *
 gegl_node_get_depends_on (GeglNode *self)
 {
@@ -1202,6 +1168,7 @@ gegl_node_invalidate_have_rect (GObject    *gobject,
                                 gpointer    user_data)
 {
   GEGL_NODE (user_data)->valid_have_rect = FALSE;
+  gegl_node_forget_result_key (GEGL_NODE (user_data));
   return TRUE;
 }
 
@@ -1287,6 +1254,7 @@ gegl_node_set_operation_object (GeglNode      *self,
 
     g_object_ref (operation);
     self->operation = operation;
+    gegl_node_forget_result_key (self);
 
     /* FIXME: handle multiple outputs */
 
@@ -1802,7 +1770,7 @@ gegl_node_process (GeglNode *self)
 
   input   = gegl_node_get_producer (self, "input", NULL);
   defined = gegl_node_get_bounding_box (input);
-  buffer  = gegl_node_apply_roi (input, "output", &defined, 3);
+  buffer  = gegl_node_apply_roi (input, "output", &defined, 0);
 
   g_assert (GEGL_IS_BUFFER (buffer));
   context = gegl_node_add_context (self, &defined);
@@ -2062,6 +2030,186 @@ gegl_node_get_cache (GeglNode *node)
   return node->cache;
 }
 
+static void
+gegl_node_forget_result_key (GeglNode *self)
+{
+  g_mutex_lock (self->mutex);
+  g_free (self->priv->result_key);
+  self->priv->result_key = NULL;
+  g_mutex_unlock (self->mutex);
+}
+
+/* appends the value of a property to the description of a node, returns
+ * FALSE for values that can not be described by their contents
+ */
+static gboolean
+gegl_node_describe_value (GString      *description,
+                          const GValue *value)
+{
+  GType type = G_VALUE_TYPE (value);
+
+  if (type == G_TYPE_DOUBLE || type == G_TYPE_FLOAT)
+    {
+      gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+      g_ascii_dtostr (buf, sizeof (buf), type == G_TYPE_DOUBLE ?
+                      g_value_get_double (value) : g_value_get_float (value));
+      g_string_append (description, buf);
+    }
+  else if (type == GEGL_TYPE_COLOR)
+    {
+      GeglColor *color = g_value_get_object (value);
+      gdouble    rgba[4] = { 0.0, };
+      gchar      buf[G_ASCII_DTOSTR_BUF_SIZE];
+      gint       i;
+
+      if (color)
+        gegl_color_get_rgba (color, &rgba[0], &rgba[1], &rgba[2], &rgba[3]);
+      for (i = 0; i < 4; i++)
+        {
+          g_ascii_dtostr (buf, sizeof (buf), rgba[i]);
+          g_string_append_printf (description, "%s ", buf);
+        }
+    }
+  else if (type == GEGL_TYPE_PATH)
+    {
+      GeglPath *path = g_value_get_object (value);
+
+      if (path)
+        {
+          gchar *str = gegl_path_to_string (path);
+
+          g_string_append (description, str);
+          g_free (str);
+        }
+    }
+  else if (G_TYPE_IS_OBJECT (type) || G_TYPE_IS_INTERFACE (type) ||
+           type == G_TYPE_POINTER ||
+           !g_value_type_transformable (type, G_TYPE_STRING))
+    {
+      /* buffers and other objects can change without their properties
+       * changing
+       */
+      return FALSE;
+    }
+  else
+    {
+      GValue       str = { 0, };
+      const gchar *contents;
+
+      g_value_init (&str, G_TYPE_STRING);
+      g_value_transform (value, &str);
+      contents = g_value_get_string (&str);
+
+      /* strings are quoted and escaped, so that neither the unquoted
+       * marker of a NULL string nor the separators can be mistaken for one
+       */
+      if (contents)
+        {
+          gchar *escaped = g_strescape (contents, NULL);
+
+          g_string_append_printf (description, "\"%s\"", escaped);
+          g_free (escaped);
+        }
+      else
+        {
+          g_string_append (description, "NULL");
+        }
+      g_value_unset (&str);
+    }
+
+  return TRUE;
+}
+
+/**
+ * gegl_node_get_result_key:
+ * @self: a #GeglNode
+ *
+ * Computes a key identifying the output of the node by how it is
+ * computed: the operation, its properties and, recursively, the keys of
+ * the nodes connected to its inputs. Nodes of different graphs that get
+ * the same key produce the same output.
+ *
+ * Returns: a newly allocated string, or NULL if the output of the node
+ * can not be identified, like for operations with buffers as properties.
+ */
+gchar *
+gegl_node_get_result_key (GeglNode *self)
+{
+  GString      *description;
+  GParamSpec  **pspecs;
+  guint         n_pspecs;
+  GSList       *iter;
+  gboolean      valid = TRUE;
+  gchar        *key;
+  guint         i;
+
+  g_return_val_if_fail (GEGL_IS_NODE (self), NULL);
+
+  if (!self->operation)
+    return NULL;
+
+  g_mutex_lock (self->mutex);
+  key = g_strdup (self->priv->result_key);
+  g_mutex_unlock (self->mutex);
+  if (key)
+    return key;
+
+  description = g_string_new (gegl_node_get_operation (self));
+
+  pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (self->operation),
+                                           &n_pspecs);
+  for (i = 0; i < n_pspecs && valid; i++)
+    {
+      GValue value = { 0, };
+
+      /* inputs are described by their sources below */
+      if (!(pspecs[i]->flags & G_PARAM_READABLE) ||
+          gegl_node_has_pad (self, pspecs[i]->name))
+        continue;
+
+      g_value_init (&value, G_PARAM_SPEC_VALUE_TYPE (pspecs[i]));
+      g_object_get_property (G_OBJECT (self->operation), pspecs[i]->name,
+                             &value);
+      g_string_append_printf (description, "\n%s=", pspecs[i]->name);
+      valid = gegl_node_describe_value (description, &value);
+      g_value_unset (&value);
+    }
+  g_free (pspecs);
+
+  for (iter = self->input_pads; iter && valid; iter = g_slist_next (iter))
+    {
+      GeglPad *pad        = iter->data;
+      GeglPad *source_pad = gegl_pad_get_connected_to (pad);
+      gchar   *source_key;
+
+      if (!source_pad)
+        continue;
+
+      source_key = gegl_node_get_result_key (gegl_pad_get_node (source_pad));
+      if (source_key)
+        g_string_append_printf (description, "\n%s<%s.%s", gegl_pad_get_name (pad),
+                                source_key, gegl_pad_get_name (source_pad));
+      else
+        valid = FALSE;
+      g_free (source_key);
+    }
+
+  if (valid)
+    key = g_compute_checksum_for_string (G_CHECKSUM_SHA1, description->str, -1);
+  g_string_free (description, TRUE);
+
+  if (key)
+    {
+      g_mutex_lock (self->mutex);
+      if (!self->priv->result_key)
+        self->priv->result_key = g_strdup (key);
+      g_mutex_unlock (self->mutex);
+    }
+
+  return key;
+}
+
 const gchar *
 gegl_node_get_name (GeglNode *self)
 {
@@ -212,7 +212,11 @@ gint          gegl_node_get_consumers       (GeglNode      *node,
                                              GeglNode    ***nodes,
                                              const gchar ***pads);
 
+GeglBuffer  * gegl_node_render_level        (GeglNode      *self,
+                                             const GeglRectangle *roi,
+                                             gint           level);
 GeglCache   * gegl_node_get_cache           (GeglNode      *node);
+gchar       * gegl_node_get_result_key      (GeglNode      *self);
 void          gegl_node_invalidated         (GeglNode      *node,
                                              const GeglRectangle *rect,
                                              gboolean             clean_cache);
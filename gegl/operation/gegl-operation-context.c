@@ -368,6 +368,7 @@ gegl_operation_context_get_target (GeglOperationContext *context,
       output = g_object_ref (emptybuf());
     }
   else if (node->dont_cache == FALSE &&
+      context->level == 0 &&
       ! GEGL_OPERATION_CLASS (G_OBJECT_GET_CLASS (operation))->no_cache)
     {
       GeglBuffer    *cache;
@@ -60,6 +60,9 @@ struct _GeglOperationContext
                                                                    2 = 1:4,
                                                                    4 = 1:8,
                                                                    6 = 1:16 .. */
+  gboolean       fused;         /* true if the operation is processed in the
+                                   same pass as the point operation consuming
+                                   its output, it has no output of its own */
 };
 
 GeglBuffer     *gegl_operation_context_get_target      (GeglOperationContext *self,
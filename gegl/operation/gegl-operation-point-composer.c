@@ -79,6 +79,13 @@ gegl_operation_point_composer_init (GeglOperationPointComposer *self)
 
 }
 
+gboolean gegl_operation_point_is_position_dependent (GeglOperation *operation);
+void     gegl_operation_point_replicate_rows        (gpointer       data,
+                                                     gint           bpp,
+                                                     gint           width,
+                                                     gint           height,
+                                                     gint           rowstride);
+
 gboolean gegl_can_do_inplace_processing (GeglOperation       *operation,
                                          GeglBuffer          *input,
                                          const GeglRectangle *result);
@@ -223,6 +230,61 @@ gegl_operation_point_composer_cl_process (GeglOperation       *operation,
   return TRUE;
 }
 
+typedef struct
+{
+  GeglOperation                   *operation;
+  GeglOperationPointComposerClass *klass;
+  gint                             read;
+  gint                             aux;   /* -1 without aux buffer */
+  gint                             level;
+  gboolean                         uniform_ok;
+  gint                             in_bpp;
+  gint                             aux_bpp;
+  gint                             out_bpp;
+} PointComposerData;
+
+/* called for every chunk, possibly from several threads at once */
+static void
+gegl_operation_point_composer_process_chunk (GeglBufferIterator *i,
+                                             gpointer            user_data)
+{
+  PointComposerData *data  = user_data;
+  gint               read  = data->read;
+  gint               width = i->roi[0].width;
+  gpointer           aux   = data->aux >= 0 ? i->data[data->aux] : NULL;
+  gint               row;
+
+  if (data->uniform_ok &&
+      gegl_buffer_iterator_is_uniform (i, read) &&
+      (data->aux < 0 || gegl_buffer_iterator_is_uniform (i, data->aux)))
+    {
+      /* every input pixel is the same, so is every output pixel */
+      data->klass->process (data->operation, i->data[read], aux, i->data[0], 1, &(i->roi[0]), data->level);
+      gegl_operation_point_replicate_rows (i->data[0], data->out_bpp, width,
+                                           i->roi[0].height, i->rowstride[0]);
+    }
+  else if (i->rowstride[read] == width * data->in_bpp &&
+           i->rowstride[0]    == width * data->out_bpp &&
+           (data->aux < 0 || i->rowstride[data->aux] == width * data->aux_bpp))
+    {
+      data->klass->process (data->operation, i->data[read], aux, i->data[0], i->length, &(i->roi[0]), data->level);
+    }
+  else
+    {
+      /* part of a tile accessed in place, process it row by row */
+      for (row = 0; row < i->roi[0].height; row++)
+        {
+          GeglRectangle roi = {i->roi[0].x, i->roi[0].y + row, width, 1};
+
+          data->klass->process (data->operation,
+                                (guchar*)i->data[read] + row * i->rowstride[read],
+                                aux ? (guchar*)aux + row * i->rowstride[data->aux] : NULL,
+                                (guchar*)i->data[0] + row * i->rowstride[0],
+                                width, &roi, data->level);
+        }
+    }
+}
+
 static gboolean
 gegl_operation_point_composer_process (GeglOperation       *operation,
                                        GeglBuffer          *input,
@@ -246,28 +308,23 @@ gegl_operation_point_composer_process (GeglOperation       *operation,
         }
 
       {
-        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format, GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
-        gint read = /*output == input ? 0 :*/ gegl_buffer_iterator_add (i, input,  result, level, in_format, GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format, GEGL_BUFFER_WRITE | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE);
+        PointComposerData   data;
+
         /* using separate read and write iterators for in-place ideally a single
          * readwrite indice would be sufficient
          */
-
-        if (aux)
-          {
-            gint foo = gegl_buffer_iterator_add (i, aux, result, level, aux_format, GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
-
-            while (gegl_buffer_iterator_next (i))
-              {
-                 point_composer_class->process (operation, i->data[read], i->data[foo], i->data[0], i->length, &(i->roi[0]), level);
-              }
-          }
-        else
-          {
-            while (gegl_buffer_iterator_next (i))
-              {
-                 point_composer_class->process (operation, i->data[read], NULL, i->data[0], i->length, &(i->roi[0]), level);
-              }
-          }
+        data.read       = /*output == input ? 0 :*/ gegl_buffer_iterator_add (i, input,  result, level, in_format, GEGL_BUFFER_READ | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE);
+        data.aux        = aux ? gegl_buffer_iterator_add (i, aux, result, level, aux_format, GEGL_BUFFER_READ | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE) : -1;
+        data.operation  = operation;
+        data.klass      = point_composer_class;
+        data.level      = level;
+        data.uniform_ok = !gegl_operation_point_is_position_dependent (operation);
+        data.in_bpp     = babl_format_get_bytes_per_pixel (in_format);
+        data.aux_bpp    = aux ? babl_format_get_bytes_per_pixel (aux_format) : 0;
+        data.out_bpp    = babl_format_get_bytes_per_pixel (out_format);
+
+        gegl_buffer_iterator_foreach (i, gegl_operation_point_composer_process_chunk, &data);
       }
       return TRUE;
     }
@@ -35,6 +35,27 @@
 
 #include "opencl/gegl-cl.h"
 
+gboolean gegl_operation_point_is_position_dependent (GeglOperation *operation);
+void     gegl_operation_point_replicate             (gpointer       data,
+                                                     gint           bpp,
+                                                     gint           n_pixels);
+void     gegl_operation_point_replicate_rows        (gpointer       data,
+                                                     gint           bpp,
+                                                     gint           width,
+                                                     gint           height,
+                                                     gint           rowstride);
+gboolean gegl_can_do_inplace_processing             (GeglOperation       *operation,
+                                                     GeglBuffer          *input,
+                                                     const GeglRectangle *result);
+gboolean gegl_operation_point_filter_can_fuse       (GeglOperation *producer,
+                                                     GeglOperation *consumer);
+gboolean gegl_operation_point_filter_process_chain  (GeglOperation       **operations,
+                                                     gint                  n_operations,
+                                                     GeglOperationContext *first,
+                                                     GeglOperationContext *last,
+                                                     const GeglRectangle  *roi,
+                                                     gint                  level);
+
 static gboolean gegl_operation_point_filter_process
                               (GeglOperation       *operation,
                                GeglBuffer          *input,
@@ -148,6 +169,54 @@ gegl_operation_point_filter_cl_process (GeglOperation       *operation,
   return TRUE;
 }
 
+typedef struct
+{
+  GeglOperation                 *operation;
+  GeglOperationPointFilterClass *klass;
+  gint                           read;
+  gint                           level;
+  gboolean                       uniform_ok;
+  gint                           in_bpp;
+  gint                           out_bpp;
+} PointFilterData;
+
+/* called for every chunk, possibly from several threads at once */
+static void
+gegl_operation_point_filter_process_chunk (GeglBufferIterator *i,
+                                           gpointer            user_data)
+{
+  PointFilterData *data  = user_data;
+  gint             read  = data->read;
+  gint             width = i->roi[0].width;
+  gint             row;
+
+  if (data->uniform_ok && gegl_buffer_iterator_is_uniform (i, read))
+    {
+      /* every input pixel is the same, so is every output pixel */
+      data->klass->process (data->operation, i->data[read], i->data[0], 1, &i->roi[0], data->level);
+      gegl_operation_point_replicate_rows (i->data[0], data->out_bpp, width,
+                                           i->roi[0].height, i->rowstride[0]);
+    }
+  else if (i->rowstride[read] == width * data->in_bpp &&
+           i->rowstride[0]    == width * data->out_bpp)
+    {
+      data->klass->process (data->operation, i->data[read], i->data[0], i->length, &i->roi[0], data->level);
+    }
+  else
+    {
+      /* part of a tile accessed in place, process it row by row */
+      for (row = 0; row < i->roi[0].height; row++)
+        {
+          GeglRectangle roi = {i->roi[0].x, i->roi[0].y + row, width, 1};
+
+          data->klass->process (data->operation,
+                                (guchar*)i->data[read] + row * i->rowstride[read],
+                                (guchar*)i->data[0] + row * i->rowstride[0],
+                                width, &roi, data->level);
+        }
+    }
+}
+
 static gboolean
 gegl_operation_point_filter_process (GeglOperation       *operation,
                                      GeglBuffer          *input,
@@ -171,21 +240,272 @@ gegl_operation_point_filter_process (GeglOperation       *operation,
         }
 
       {
-        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format, GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
-        gint read = /*output == input ? 0 :*/ gegl_buffer_iterator_add (i, input,  result, level, in_format, GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+        GeglBufferIterator *i = gegl_buffer_iterator_new (output, result, level, out_format, GEGL_BUFFER_WRITE | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE);
+        PointFilterData     data;
+
         /* using separate read and write iterators for in-place ideally a single
          * readwrite indice would be sufficient
          */
-          while (gegl_buffer_iterator_next (i))
-            point_filter_class->process (operation, i->data[read], i->data[0], i->length, &i->roi[0], level);
+        data.read       = /*output == input ? 0 :*/ gegl_buffer_iterator_add (i, input,  result, level, in_format, GEGL_BUFFER_READ | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE);
+        data.operation  = operation;
+        data.klass      = point_filter_class;
+        data.level      = level;
+        data.uniform_ok = !gegl_operation_point_is_position_dependent (operation);
+        data.in_bpp     = babl_format_get_bytes_per_pixel (in_format);
+        data.out_bpp    = babl_format_get_bytes_per_pixel (out_format);
+
+        gegl_buffer_iterator_foreach (i, gegl_operation_point_filter_process_chunk, &data);
       }
     }
   return TRUE;
 }
 
-gboolean gegl_can_do_inplace_processing (GeglOperation       *operation,
-                                         GeglBuffer          *input,
-                                         const GeglRectangle *result);
+/* point operations whose output depends on the coordinates and not only on
+ * the input pixels set the "position-dependent" key to "true", they can not
+ * process uniform input as a single pixel.
+ */
+gboolean
+gegl_operation_point_is_position_dependent (GeglOperation *operation)
+{
+  const gchar *value;
+
+  value = gegl_operation_class_get_key (GEGL_OPERATION_GET_CLASS (operation),
+                                        "position-dependent");
+  return value && !strcmp (value, "true");
+}
+
+/* copies the first pixel of data over the following n_pixels - 1 pixels */
+void
+gegl_operation_point_replicate (gpointer data,
+                                gint     bpp,
+                                gint     n_pixels)
+{
+  gint done = 1;
+
+  while (done < n_pixels)
+    {
+      gint n = MIN (done, n_pixels - done);
+
+      memcpy ((guchar*)data + done * bpp, data, n * bpp);
+      done += n;
+    }
+}
+
+/* copies the first pixel of data over a width x height area with rows
+ * rowstride bytes apart
+ */
+void
+gegl_operation_point_replicate_rows (gpointer data,
+                                     gint     bpp,
+                                     gint     width,
+                                     gint     height,
+                                     gint     rowstride)
+{
+  gint row;
+
+  if (rowstride == width * bpp)
+    {
+      gegl_operation_point_replicate (data, bpp, width * height);
+      return;
+    }
+
+  gegl_operation_point_replicate (data, bpp, width);
+  for (row = 1; row < height; row++)
+    memcpy ((guchar*)data + row * rowstride, data, width * bpp);
+}
+
+/* the pixels a chain of point filters processes at a time, small enough for
+ * the data passed between the filters to stay in the cache
+ */
+#define POINT_CHAIN_SAMPLES 1024
+
+typedef struct
+{
+  GeglOperation                 **operations;
+  GeglOperationPointFilterClass **klasses;
+  gint                            n_operations;
+  gint                            read;
+  gint                            level;
+  gboolean                        uniform_ok;
+  gint                            in_bpp;
+  gint                            out_bpp;
+  gint                            max_bpp;
+} PointChainData;
+
+/* runs the filters of the chain one after the other, passing the pixels
+ * between them through the scratch memory
+ */
+static void
+gegl_operation_point_filter_run_chain (PointChainData      *data,
+                                       gpointer             in_buf,
+                                       gpointer             out_buf,
+                                       glong                samples,
+                                       const GeglRectangle *roi,
+                                       guchar              *scratch)
+{
+  gpointer src = in_buf;
+  gint     j;
+
+  for (j = 0; j < data->n_operations; j++)
+    {
+      gpointer dst;
+
+      if (j == data->n_operations - 1)
+        dst = out_buf;
+      else
+        dst = scratch + (j % 2) * samples * data->max_bpp;
+
+      data->klasses[j]->process (data->operations[j], src, dst, samples, roi, data->level);
+      src = dst;
+    }
+}
+
+static void
+gegl_operation_point_filter_process_chain_chunk (GeglBufferIterator *i,
+                                                 gpointer            user_data)
+{
+  PointChainData *data   = user_data;
+  gint            read   = data->read;
+  gint            width  = i->roi[0].width;
+  gint            height = i->roi[0].height;
+  gint            rows   = 1;
+  gint            row;
+  guchar         *scratch;
+
+  if (data->uniform_ok && gegl_buffer_iterator_is_uniform (i, read))
+    {
+      guchar pixels[2 * 64];
+
+      if (2 * data->max_bpp <= sizeof (pixels))
+        {
+          gegl_operation_point_filter_run_chain (data, i->data[read], i->data[0], 1, &i->roi[0], pixels);
+          gegl_operation_point_replicate_rows (i->data[0], data->out_bpp, width,
+                                               height, i->rowstride[0]);
+          return;
+        }
+    }
+
+  /* rows without padding between them are processed several at a time */
+  if (i->rowstride[read] == width * data->in_bpp &&
+      i->rowstride[0]    == width * data->out_bpp)
+    rows = CLAMP (POINT_CHAIN_SAMPLES / width, 1, height);
+
+  scratch = g_malloc (2 * rows * width * data->max_bpp);
+
+  for (row = 0; row < height; row += rows)
+    {
+      GeglRectangle roi = {i->roi[0].x, i->roi[0].y + row,
+                           width, MIN (rows, height - row)};
+
+      gegl_operation_point_filter_run_chain (data,
+                                             (guchar*)i->data[read] + row * i->rowstride[read],
+                                             (guchar*)i->data[0] + row * i->rowstride[0],
+                                             roi.width * roi.height, &roi, scratch);
+    }
+
+  g_free (scratch);
+}
+
+/* Whether the output of producer can be passed straight to consumer, in
+ * the same loop over the pixels. Operations overriding the process of the
+ * point filter, for instance to pass their input through, are left alone.
+ */
+gboolean
+gegl_operation_point_filter_can_fuse (GeglOperation *producer,
+                                      GeglOperation *consumer)
+{
+  GeglOperation *operations[2] = { producer, consumer };
+  gint           j;
+
+  if (gegl_cl_is_accelerated ())
+    return FALSE;
+
+  for (j = 0; j < 2; j++)
+    {
+      GeglOperationClass *operation_class;
+
+      if (!GEGL_IS_OPERATION_POINT_FILTER (operations[j]))
+        return FALSE;
+
+      operation_class = GEGL_OPERATION_GET_CLASS (operations[j]);
+      if (operation_class->process != gegl_operation_point_filter_op_process ||
+          !GEGL_OPERATION_POINT_FILTER_GET_CLASS (operations[j])->process)
+        return FALSE;
+    }
+
+  return gegl_operation_get_format (producer, "output") ==
+         gegl_operation_get_format (consumer, "input");
+}
+
+/* Processes a chain of point filters, each one consuming the output of the
+ * one before it, in a single pass over roi. The input of the chain is the
+ * input of the first context and the output goes to the last context, no
+ * buffers are made for the results in between.
+ */
+gboolean
+gegl_operation_point_filter_process_chain (GeglOperation       **operations,
+                                           gint                  n_operations,
+                                           GeglOperationContext *first,
+                                           GeglOperationContext *last,
+                                           const GeglRectangle  *roi,
+                                           gint                  level)
+{
+  GeglOperation      *operation  = operations[n_operations - 1];
+  const Babl         *in_format  = gegl_operation_get_format (operations[0], "input");
+  const Babl         *out_format = gegl_operation_get_format (operation, "output");
+  GeglBuffer         *input;
+  GeglBuffer         *output;
+  GeglBufferIterator *i;
+  PointChainData      data;
+  gint                j;
+
+  input = gegl_operation_context_get_source (first, "input");
+
+  if (gegl_can_do_inplace_processing (operation, input, roi))
+    {
+      output = g_object_ref (input);
+      gegl_operation_context_take_object (last, "output", G_OBJECT (output));
+    }
+  else
+    {
+      output = gegl_operation_context_get_target (last, "output");
+    }
+
+  data.operations   = operations;
+  data.klasses      = g_new (GeglOperationPointFilterClass *, n_operations);
+  data.n_operations = n_operations;
+  data.level        = level;
+  data.uniform_ok   = TRUE;
+  data.in_bpp       = babl_format_get_bytes_per_pixel (in_format);
+  data.out_bpp      = babl_format_get_bytes_per_pixel (out_format);
+  data.max_bpp      = 0;
+
+  for (j = 0; j < n_operations; j++)
+    {
+      const Babl *format = gegl_operation_get_format (operations[j], "output");
+
+      data.klasses[j] = GEGL_OPERATION_POINT_FILTER_GET_CLASS (operations[j]);
+      data.max_bpp    = MAX (data.max_bpp, babl_format_get_bytes_per_pixel (format));
+      if (gegl_operation_point_is_position_dependent (operations[j]))
+        data.uniform_ok = FALSE;
+    }
+
+  if ((roi->width > 0) && (roi->height > 0))
+    {
+      i = gegl_buffer_iterator_new (output, roi, level, out_format, GEGL_BUFFER_WRITE | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE);
+      data.read = gegl_buffer_iterator_add (i, input, roi, level, in_format, GEGL_BUFFER_READ | GEGL_BUFFER_STRIDED, GEGL_ABYSS_NONE);
+
+      gegl_buffer_iterator_foreach (i, gegl_operation_point_filter_process_chain_chunk, &data);
+    }
+
+  if (output == GEGL_BUFFER (operation->node->cache))
+    gegl_cache_computed (operation->node->cache, roi);
+
+  g_free (data.klasses);
+  if (input != NULL)
+    g_object_unref (input);
+  return TRUE;
+}
 
 gboolean gegl_can_do_inplace_processing (GeglOperation       *operation,
                                          GeglBuffer          *input,
@@ -32,6 +32,11 @@
 #include "buffer/gegl-region.h"
 #include "buffer/gegl-buffer.h"
 #include "gegl-operations.h"
+#include "gegl-operation-point-filter.h"
+#include "gegl-operation-point-composer.h"
+#include "gegl-operation-point-composer3.h"
+
+gboolean gegl_operation_point_is_position_dependent (GeglOperation *operation);
 
 static void         attach                    (GeglOperation       *self);
 
@@ -332,6 +337,51 @@ gegl_operation_get_source_node (GeglOperation *operation,
   return gegl_pad_get_node (pad);
 }
 
+const Babl *
+gegl_operation_get_source_format (GeglOperation *operation,
+                                  const gchar   *input_pad_name)
+{
+  GeglPad *pad;
+
+  g_assert (operation &&
+            operation->node &&
+            input_pad_name);
+  pad = gegl_node_get_pad (operation->node, input_pad_name);
+
+  if (!pad)
+    return NULL;
+
+  pad = gegl_pad_get_connected_to (pad);
+
+  if (!pad)
+    return NULL;
+
+  return pad->format;
+}
+
+/* operations can process at a level coarser than 1:1 when they give the
+ * same result on an image scaled down to the level, in the coordinates of
+ * the level. Point operations do unless they depend on the position, other
+ * operations say so with the "level-aware" key.
+ */
+gboolean
+gegl_operation_is_level_aware (GeglOperation *operation)
+{
+  const gchar *value;
+
+  value = gegl_operation_class_get_key (GEGL_OPERATION_GET_CLASS (operation),
+                                        "level-aware");
+  if (value)
+    return !strcmp (value, "true");
+
+  if (GEGL_IS_OPERATION_POINT_FILTER (operation) ||
+      GEGL_IS_OPERATION_POINT_COMPOSER (operation) ||
+      GEGL_IS_OPERATION_POINT_COMPOSER3 (operation))
+    return !gegl_operation_point_is_position_dependent (operation);
+
+  return FALSE;
+}
+
 GeglRectangle *
 gegl_operation_source_get_bounding_box (GeglOperation  *operation,
                                         const gchar   *input_pad_name)
@@ -393,7 +443,65 @@ get_invalidated_by_change (GeglOperation        *self,
                input_region);
     }
 #endif
-  return *input_region;
+  GeglRectangle required;
+  GeglRectangle probe;
+  GeglRectangle probe_required;
+  GeglRectangle retval;
+  gint          left, right, top, bottom;
+
+  if (self->node->is_graph)
+    return *input_region;
+
+  /* the output pixels that read the changed input are as far from it as
+   * get_required_for_output reaches out from them, mirrored, so that the
+   * padding of operations reading around their output is dirtied as well
+   */
+  required = gegl_operation_get_required_for_output (self, input_pad,
+                                                     input_region);
+
+  /* operations reading all of their input whatever the output, like
+   * stretch-contrast, require the same for a pixel elsewhere, a change
+   * anywhere affects all of their output
+   */
+  probe.x      = input_region->x + input_region->width + 1;
+  probe.y      = input_region->y + input_region->height + 1;
+  probe.width  = 1;
+  probe.height = 1;
+  probe_required = gegl_operation_get_required_for_output (self, input_pad,
+                                                           &probe);
+
+  if (!gegl_rectangle_is_empty (&required) &&
+      gegl_rectangle_equal (&required, &probe_required))
+    {
+      g_mutex_lock (self->node->mutex);
+      retval = self->node->have_rect;
+      g_mutex_unlock (self->node->mutex);
+
+      return retval;
+    }
+
+  if (gegl_rectangle_is_infinite_plane (&required) ||
+      required.width  > G_MAXINT / 4 ||
+      required.height > G_MAXINT / 4)
+    return required;
+
+  /* not a neighbourhood around the output, like for distortions */
+  if (!gegl_rectangle_contains (&required, input_region))
+    return *input_region;
+
+  left   = input_region->x - required.x;
+  top    = input_region->y - required.y;
+  right  = (required.x + required.width) -
+           (input_region->x + input_region->width);
+  bottom = (required.y + required.height) -
+           (input_region->y + input_region->height);
+
+  retval.x      = input_region->x - right;
+  retval.y      = input_region->y - bottom;
+  retval.width  = input_region->width  + left + right;
+  retval.height = input_region->height + top  + bottom;
+
+  return retval;
 }
 
 /* returns a freshly allocated list of the properties of the object, does not list
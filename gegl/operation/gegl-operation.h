@@ -98,7 +98,9 @@ struct _GeglOperationClass
 
   /* The output region that is made invalid by a change in the input_roi
    * rectangle of the buffer passed in on the pad input_pad. Defaults to
-   * returning the input_roi.
+   * the input_roi grown by the padding get_required_for_output adds, or
+   * the whole bounding box when the required region does not depend on
+   * the output region.
    */
   GeglRectangle (*get_invalidated_by_change) (GeglOperation       *operation,
                                               const gchar         *input_pad,
@@ -215,6 +217,16 @@ const gchar *   gegl_operation_get_name      (GeglOperation *operation);
 GeglNode      * gegl_operation_get_source_node (GeglOperation *operation,
                                                 const gchar   *pad_name);
 
+/* retrieves the format of the data provided to a named input pad, NULL if
+ * the pad is not connected or the source has not been prepared yet. Sources
+ * are prepared before the operations consuming their data. */
+const Babl    * gegl_operation_get_source_format (GeglOperation *operation,
+                                                  const gchar   *pad_name);
+
+/* whether the operation can process at the levels coarser than 1:1, with
+ * rectangles in the coordinates of the level */
+gboolean        gegl_operation_is_level_aware  (GeglOperation *operation);
+
 GParamSpec ** gegl_operation_list_properties   (const gchar *operation_type,
                                                 guint       *n_properties_p);
 
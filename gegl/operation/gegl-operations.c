@@ -24,6 +24,7 @@
 
 #include "gegl.h"
 #include "gegl-types-internal.h"
+#include "gegl-debug.h"
 #include "gegl-utils.h"
 #include "gegl-operation.h"
 #include "gegl-operations.h"
@@ -31,6 +32,7 @@
 #include "graph/gegl-pad.h"
 #include "gegl-operation-context.h"
 #include "buffer/gegl-region.h"
+#include "process/gegl-result-cache.h"
 
 
 static GHashTable *gtype_hash = NULL;
@@ -189,11 +191,14 @@ gegl_operation_set_need_rect (GeglOperation       *operation,
 
   {
     GeglOperationContext *child_context = gegl_node_get_context (child, context_id);
+    GeglRectangle         child_have;
+
+    gegl_rectangle_to_level (&child_have, &child->have_rect, child_context->level);
     gegl_rectangle_bounding_box (&child_need, &child_context->need_rect, region);
-    gegl_rectangle_intersect (&child_need, &child->have_rect, &child_need);
+    gegl_rectangle_intersect (&child_need, &child_have, &child_need);
 
-      /* If we're cached */
-      if (child->cache)
+      /* If we're cached, the cache only holds 1:1 data */
+      if (child->cache && child_context->level == 0)
         {
           GeglCache *cache = child->cache;
           GeglRectangle valid_box;
@@ -210,6 +215,46 @@ gegl_operation_set_need_rect (GeglOperation       *operation,
             }
         }
 
+      /* the same output might have been computed by a node of another
+       * graph, a rect found in the result cache for an earlier consumer
+       * is looked up again together with the rect of this one
+       */
+      if (!(child->cache && child_context->cached) &&
+          child_need.width > 0 && child_need.height > 0 &&
+          gegl_result_cache_enabled ())
+        {
+          gchar      *key    = gegl_node_get_result_key (child);
+          GeglBuffer *buffer = NULL;
+
+          if (child_context->cached)
+            gegl_rectangle_bounding_box (&child_need, &child_need,
+                                         &child_context->result_rect);
+
+          if (key)
+            buffer = gegl_result_cache_lookup (key, gegl_pad_get_name (output_pad),
+                                               gegl_pad_get_format (output_pad),
+                                               child_context->level, &child_need);
+          if (buffer)
+            {
+              GEGL_NOTE (GEGL_DEBUG_CACHE, "result cache hit for \"%s\"",
+                         gegl_node_get_debug_name (child));
+              gegl_operation_context_take_object (child_context,
+                                                  gegl_pad_get_name (output_pad),
+                                                  G_OBJECT (buffer));
+              child_context->result_rect = child_need;
+              child_context->cached = TRUE;
+              child_need.width = 0;
+              child_need.height = 0;
+            }
+          else if (child_context->cached)
+            {
+              child_context->cached = FALSE;
+              gegl_operation_context_remove_property (child_context,
+                                                      gegl_pad_get_name (output_pad));
+            }
+          g_free (key);
+        }
+
     gegl_node_set_need_rect (child, context_id, &child_need);
   }
 }
@@ -35,6 +35,8 @@
 #include "graph/gegl-pad.h"
 #include "graph/gegl-visitable.h"
 #include "operation/gegl-operation.h"
+#include "operation/gegl-operation-context.h"
+#include "gegl-config.h"
 #include <stdlib.h>
 
 
@@ -65,6 +67,9 @@ gegl_eval_manager_init (GeglEvalManager *self)
   self->need_visitor = g_object_new (GEGL_TYPE_NEED_VISITOR, "id", context_id, NULL);
   self->finish_visitor = g_object_new (GEGL_TYPE_FINISH_VISITOR, "id", context_id, NULL);
   self->state = UNINITIALIZED;
+  self->plan_nodes      = g_ptr_array_new ();
+  self->plan_need_nodes = g_ptr_array_new ();
+  self->plan_eval_pads  = g_ptr_array_new ();
 }
 
 static void
@@ -92,6 +97,11 @@ gegl_eval_manager_finalize (GObject *self_object)
   g_object_unref (self->eval_visitor);
   g_object_unref (self->need_visitor);
   g_object_unref (self->finish_visitor);
+  g_ptr_array_free (self->plan_nodes, TRUE);
+  g_ptr_array_free (self->plan_need_nodes, TRUE);
+  g_ptr_array_free (self->plan_eval_pads, TRUE);
+  if (self->plan_dependencies)
+    g_hash_table_destroy (self->plan_dependencies);
   g_free (self->pad_name);
 
   G_OBJECT_CLASS (gegl_eval_manager_parent_class)->finalize (self_object);
@@ -125,6 +135,39 @@ gegl_eval_manager_change_notification (GObject             *gobject,
 }
 
 
+/* records the visits of a traversal in the order they happened */
+static void
+gegl_eval_manager_record (GPtrArray   *plan,
+                          GeglVisitor *visitor)
+{
+  GSList *visits = gegl_visitor_get_visits_list (visitor);
+  GSList *iter;
+  guint   i;
+
+  /* the list has the last visit first */
+  g_ptr_array_set_size (plan, g_slist_length (visits));
+  for (iter = visits, i = plan->len; iter; iter = g_slist_next (iter))
+    g_ptr_array_index (plan, --i) = iter->data;
+}
+
+/* does what the prepare traversal does for every apply, the operations
+ * have already been prepared when the plan was recorded
+ */
+static void
+gegl_eval_manager_setup_contexts (GeglEvalManager *self)
+{
+  GeglRectangle empty = { 0, };
+  guint         i;
+
+  for (i = 0; i < self->plan_nodes->len; i++)
+    {
+      GeglNode *node = g_ptr_array_index (self->plan_nodes, i);
+
+      gegl_node_add_context (node, self);
+      gegl_node_set_need_rect (node, self, &empty);
+    }
+}
+
 GeglBuffer *
 gegl_eval_manager_apply (GeglEvalManager *self)
 {
@@ -133,6 +176,8 @@ gegl_eval_manager_apply (GeglEvalManager *self)
   GeglPad     *pad;
   glong        time       = gegl_ticks ();
   gpointer     context_id = self;
+  gboolean     planned    = FALSE;
+  guint        i;
 
   g_assert (GEGL_IS_EVAL_MANAGER (self));
 
@@ -168,14 +213,29 @@ gegl_eval_manager_apply (GeglEvalManager *self)
 
         gegl_visitor_reset (self->prepare_visitor);
         gegl_visitor_dfs_traverse (self->prepare_visitor, GEGL_VISITABLE (root));
-        self->state = NEED_CONTEXT_SETUP_TRAVERSAL;
+        gegl_eval_manager_record (self->plan_nodes, self->prepare_visitor);
+
+        /* a change notification arriving during this apply sets the state
+         * back, leaving the plan recorded here unused
+         */
+        self->state = PLANNED;
+        break;
+
+      case PLANNED:
+        gegl_eval_manager_setup_contexts (self);
+        planned = TRUE;
+        break;
      }
 
+  for (i = 0; i < self->plan_nodes->len; i++)
+    gegl_node_get_context (g_ptr_array_index (self->plan_nodes, i),
+                           context_id)->level = self->level;
+
   /* set up the root node */
   if (self->roi.width == -1 &&
       self->roi.height == -1)
     {
-      self->roi = root->have_rect;
+      gegl_rectangle_to_level (&self->roi, &root->have_rect, self->level);
     }
 
   gegl_node_set_need_rect (root, context_id, &self->roi);
@@ -183,12 +243,20 @@ gegl_eval_manager_apply (GeglEvalManager *self)
   /* set up the context's rectangle (breadth first traversal) */
   gegl_visitor_reset (self->need_visitor);
 
-  /* should the need rect be moved into the context, making this
-   * part of gegl re-entrable without locking?.. or does that
-   * hamper other useful API that depends on the need_rect to be
-   * in the nodes?
+  /* the need rects are kept in the contexts of this manager, other
+   * managers can evaluate the same graph for other regions meanwhile
    */
-  gegl_visitor_bfs_traverse (self->need_visitor, GEGL_VISITABLE (root));
+  if (planned)
+    {
+      for (i = 0; i < self->plan_need_nodes->len; i++)
+        gegl_visitor_visit_node (self->need_visitor,
+                                 g_ptr_array_index (self->plan_need_nodes, i));
+    }
+  else
+    {
+      gegl_visitor_bfs_traverse (self->need_visitor, GEGL_VISITABLE (root));
+      gegl_eval_manager_record (self->plan_need_nodes, self->need_visitor);
+    }
 
 #if 0
   if (g_getenv ("GEGL_DEBUG_RECTS") != NULL)
@@ -204,9 +272,21 @@ gegl_eval_manager_apply (GeglEvalManager *self)
 
   /* now let's do the real work */
   gegl_visitor_reset (self->eval_visitor);
-  if (pad)
+  if (planned && gegl_config ()->threads <= 1)
     {
-      gegl_visitor_dfs_traverse (self->eval_visitor, GEGL_VISITABLE (pad));
+      /* without threads to evaluate branches on the order never changes */
+      for (i = 0; i < self->plan_eval_pads->len; i++)
+        gegl_visitor_visit_pad (self->eval_visitor,
+                                g_ptr_array_index (self->plan_eval_pads, i));
+    }
+  else if (pad)
+    {
+      /* with threads the branches are picked for every apply, walking the
+       * dependencies recorded with the plan
+       */
+      gegl_eval_visitor_traverse_planned (GEGL_EVAL_VISITOR (self->eval_visitor),
+                                          pad,
+                                          planned ? self->plan_dependencies : NULL);
     }
   else
     { /* pull on the input of our sink if no pad of the given pad-name
@@ -216,7 +296,18 @@ gegl_eval_manager_apply (GeglEvalManager *self)
          in its processing.
        */
       GeglPad *pad = gegl_node_get_pad (root, "input");
-      gegl_visitor_dfs_traverse (self->eval_visitor, GEGL_VISITABLE (pad));
+      gegl_eval_visitor_traverse_planned (GEGL_EVAL_VISITOR (self->eval_visitor),
+                                          pad,
+                                          planned ? self->plan_dependencies : NULL);
+    }
+  if (!planned)
+    {
+      gegl_eval_manager_record (self->plan_eval_pads, self->eval_visitor);
+
+      if (self->plan_dependencies)
+        g_hash_table_destroy (self->plan_dependencies);
+      self->plan_dependencies =
+        gegl_eval_visitor_new_dependencies (self->plan_eval_pads);
     }
 
   if (pad)
@@ -233,7 +324,9 @@ gegl_eval_manager_apply (GeglEvalManager *self)
 
   /* do the clean up */
   gegl_visitor_reset (self->finish_visitor);
-  gegl_visitor_dfs_traverse (self->finish_visitor, GEGL_VISITABLE (root));
+  for (i = 0; i < self->plan_nodes->len; i++)
+    gegl_visitor_visit_node (self->finish_visitor,
+                             g_ptr_array_index (self->plan_nodes, i));
 
   g_object_unref (root);
   time = gegl_ticks () - time;
@@ -37,7 +37,12 @@ typedef enum
   /* means we need a prepare traversal to set up the contexts on the
    * nodes
    */
-  NEED_CONTEXT_SETUP_TRAVERSAL
+  NEED_CONTEXT_SETUP_TRAVERSAL,
+
+  /* means the graph has not changed since the plan was recorded, the
+   * contexts can be set up by walking the plan
+   */
+  PLANNED
 } GeglEvalManagerStates;
 
 
@@ -57,6 +62,8 @@ struct _GeglEvalManager
   GeglNode  *node;
   gchar     *pad_name;
   GeglRectangle roi;
+  gint       level;     /* the level to render at, roi is in the
+                           coordinates of the level */
 
   /* whether we can fire off rendering requests straight
    * away or we have to re-prepare etc of the graph
@@ -70,6 +77,14 @@ struct _GeglEvalManager
   GeglVisitor *have_visitor;
   GeglVisitor *finish_visitor;
 
+  /* the execution plan, the orders the traversals visited the graph in
+   * when it was last prepared
+   */
+  GPtrArray   *plan_nodes;      /* nodes, sources before sinks */
+  GPtrArray   *plan_need_nodes; /* nodes, sinks before sources */
+  GPtrArray   *plan_eval_pads;  /* pads, sources before sinks */
+  GHashTable  *plan_dependencies; /* what the pads depend on, for
+                                     evaluating branches concurrently */
 };
 
 struct _GeglEvalManagerClass
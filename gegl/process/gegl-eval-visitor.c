@@ -19,6 +19,7 @@
 #include "config.h"
 
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <string.h>
 
 #include "gegl.h"
@@ -33,8 +34,22 @@
 #include "gegl-instrument.h"
 #include "operation/gegl-operation-sink.h"
 #include "buffer/gegl-region.h"
+#include "buffer/gegl-buffer-private.h"
+#include "gegl-config.h"
+#include "gegl-scheduler.h"
+#include "gegl-result-cache.h"
+#include "graph/gegl-connection.h"
 
 
+gboolean gegl_operation_point_filter_can_fuse      (GeglOperation *producer,
+                                                    GeglOperation *consumer);
+gboolean gegl_operation_point_filter_process_chain (GeglOperation       **operations,
+                                                    gint                  n_operations,
+                                                    GeglOperationContext *first,
+                                                    GeglOperationContext *last,
+                                                    const GeglRectangle  *roi,
+                                                    gint                  level);
+
 static void gegl_eval_visitor_class_init (GeglEvalVisitorClass *klass);
 static void gegl_eval_visitor_visit_pad  (GeglVisitor *self,
                                           GeglPad     *pad);
@@ -43,6 +58,34 @@ static void gegl_eval_visitor_visit_pad  (GeglVisitor *self,
 G_DEFINE_TYPE (GeglEvalVisitor, gegl_eval_visitor, GEGL_TYPE_VISITOR)
 
 
+/* the list of visits kept by GeglVisitor is shared by the branches of a
+ * traversal that are evaluated concurrently
+ */
+static GStaticMutex visits_mutex = G_STATIC_MUTEX_INIT;
+
+/* the branches evaluated concurrently in all traversals, bounded by the
+ * number of threads and by the cache size
+ */
+static GStaticMutex branch_mutex   = G_STATIC_MUTEX_INIT;
+static gint         branch_helpers = 0;
+static guint64      branch_bytes   = 0;
+
+typedef struct
+{
+  GeglVisitor *visitor;
+  GHashTable  *visited;
+  GMutex      *mutex;
+  GHashTable  *dependencies; /* of a recorded plan, NULL when there is none */
+} EvalTraversal;
+
+typedef struct
+{
+  EvalTraversal *traversal;
+  GeglPad       *pad;       /* the source pad an input is connected to */
+  guint64        bytes;
+} EvalBranch;
+
+
 static void
 gegl_eval_visitor_class_init (GeglEvalVisitorClass *klass)
 {
@@ -57,6 +100,138 @@ gegl_eval_visitor_init (GeglEvalVisitor *self)
 }
 
 
+/* Whether the node can leave its processing to the single node consuming
+ * its output, to be done in the same pass over the pixels. Both have to be
+ * point filters with matching formats rendering the same rectangle.
+ */
+static gboolean
+gegl_eval_visitor_can_fuse (GeglVisitor          *self,
+                            GeglNode             *node,
+                            GeglPad              *pad,
+                            GeglOperationContext *context)
+{
+  GeglConnection       *connection;
+  GeglNode             *consumer;
+  GeglOperationContext *consumer_context;
+
+  if (gegl_pad_get_num_connections (pad) != 1 ||
+      strcmp (gegl_pad_get_name (pad), "output") ||
+      !gegl_node_get_producer (node, "input", NULL))
+    return FALSE;
+
+  connection = gegl_pad_get_connections (pad)->data;
+  consumer   = gegl_connection_get_sink_node (connection);
+  if (strcmp (gegl_pad_get_name (gegl_connection_get_sink_pad (connection)), "input"))
+    return FALSE;
+
+  /* consumers outside of this evaluation have no context for it */
+  consumer_context = gegl_node_get_context (consumer, self->context_id);
+  if (!consumer_context ||
+      consumer_context->cached ||
+      consumer_context->level != context->level ||
+      !gegl_rectangle_equal (&consumer_context->result_rect, &context->result_rect))
+    return FALSE;
+
+  return gegl_operation_point_filter_can_fuse (node->operation,
+                                               consumer->operation);
+}
+
+/* processes the node together with the chain of fused nodes before it */
+static void
+gegl_eval_visitor_process_chain (GeglVisitor          *self,
+                                 GeglNode             *node,
+                                 GeglOperationContext *context)
+{
+  GPtrArray            *chain = g_ptr_array_new ();
+  GeglOperationContext *first = context;
+  GeglOperation       **operations;
+  GeglNode             *member;
+  guint                 i;
+
+  g_ptr_array_add (chain, node->operation);
+  for (member = gegl_node_get_producer (node, "input", NULL);
+       member;
+       member = gegl_node_get_producer (member, "input", NULL))
+    {
+      GeglOperationContext *member_context;
+
+      member_context = gegl_node_get_context (member, self->context_id);
+      if (!member_context || !member_context->fused)
+        break;
+
+      g_ptr_array_add (chain, member->operation);
+      first = member_context;
+    }
+
+  operations = g_new (GeglOperation *, chain->len);
+  for (i = 0; i < chain->len; i++)
+    operations[i] = g_ptr_array_index (chain, chain->len - 1 - i);
+
+  gegl_operation_point_filter_process_chain (operations, chain->len,
+                                             first, context,
+                                             &context->result_rect,
+                                             context->level);
+
+  /* the input of the chain is not needed any longer */
+  gegl_operation_context_remove_property (first, "input");
+
+  g_free (operations);
+  g_ptr_array_free (chain, TRUE);
+}
+
+static gboolean
+gegl_eval_visitor_input_fused (GeglVisitor *self,
+                               GeglNode    *node)
+{
+  GeglNode             *producer = gegl_node_get_producer (node, "input", NULL);
+  GeglOperationContext *producer_context;
+
+  if (!producer)
+    return FALSE;
+
+  producer_context = gegl_node_get_context (producer, self->context_id);
+  return producer_context && producer_context->fused;
+}
+
+/* stores the output of the node in the result cache, for other graphs
+ * with the same nodes
+ */
+static void
+gegl_eval_visitor_store_result (GeglNode             *node,
+                                GeglPad              *pad,
+                                GeglOperationContext *context)
+{
+  GObject *output;
+  gchar   *key;
+
+  /* operations that are not worth caching for a node are not worth it
+   * here either
+   */
+  if (!gegl_result_cache_enabled () ||
+      GEGL_OPERATION_GET_CLASS (node->operation)->no_cache)
+    return;
+
+  /* the output of a cancelled render can be incomplete */
+  if (g_cancellable_is_cancelled (gegl_buffer_thread_get_cancellable ()))
+    return;
+
+  output = gegl_operation_context_get_object (context, gegl_pad_get_name (pad));
+  if (!GEGL_IS_BUFFER (output))
+    return;
+
+  /* passed through, it is stored for the node it comes from */
+  if (gegl_node_has_pad (node, "input") &&
+      output == gegl_operation_context_get_object (context, "input"))
+    return;
+
+  key = gegl_node_get_result_key (node);
+  if (key)
+    gegl_result_cache_insert (key, gegl_pad_get_name (pad),
+                              gegl_pad_get_format (pad), context->level,
+                              GEGL_BUFFER (output), &context->result_rect);
+  g_free (key);
+}
+
 /* this is the visitor that does the real computations for GEGL */
 static void
 gegl_eval_visitor_visit_pad (GeglVisitor *self,
@@ -67,7 +242,9 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
   GeglOperationContext *context    = gegl_node_get_context (node, context_id);
   GeglOperation   *operation  = node->operation;
 
+  g_static_mutex_lock (&visits_mutex);
   GEGL_VISITOR_CLASS (gegl_eval_visitor_parent_class)->visit_pad (self, pad);
+  g_static_mutex_unlock (&visits_mutex);
 
   if (gegl_pad_is_output (pad))
     {
@@ -75,9 +252,12 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
       if (context->cached)
         {
           GEGL_NOTE (GEGL_DEBUG_PROCESS, "Using cache for pad '%s' on \"%s\"", gegl_pad_get_name (pad), gegl_node_get_debug_name (node));
-          gegl_operation_context_set_object (context,
-                                             gegl_pad_get_name (pad),
-                                             G_OBJECT (node->cache));
+          /* a buffer from the result cache is already in place */
+          if (!gegl_operation_context_get_object (context,
+                                                  gegl_pad_get_name (pad)))
+            gegl_operation_context_set_object (context,
+                                               gegl_pad_get_name (pad),
+                                               G_OBJECT (node->cache));
         }
       else
         {
@@ -86,6 +266,22 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
               /* 0px processing, bail */
               gegl_operation_context_take_object (context, "output", G_OBJECT (gegl_buffer_new (NULL, NULL)));
             }
+          else if (gegl_eval_visitor_can_fuse (self, node, pad, context))
+            {
+              /* processed by the consumer along with its own processing */
+              GEGL_NOTE (GEGL_DEBUG_PROCESS, "Fusing \"%s\" with its consumer",
+                         gegl_node_get_debug_name (node));
+              context->fused = TRUE;
+            }
+          else if (gegl_eval_visitor_input_fused (self, node))
+            {
+              glong time = gegl_ticks ();
+
+              gegl_eval_visitor_process_chain (self, node, context);
+              time = gegl_ticks () - time;
+
+              gegl_instrument ("process", gegl_node_get_operation (node), time);
+            }
           else
             {
               /* Make the operation do it's actual processing */
@@ -101,6 +297,10 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
               gegl_instrument ("process", gegl_node_get_operation (node), time);
             }
 
+          if (!context->fused &&
+              context->result_rect.width > 0 && context->result_rect.height > 0)
+            gegl_eval_visitor_store_result (node, pad, context);
+
           if (gegl_pad_get_num_connections (pad) > 1)
             {
               /* Mark buffers that have been consumed by different parts of the
@@ -139,6 +339,7 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
                                           &value);
 
           if (!g_value_get_object (&value) &&
+              !source_context->fused &&
               !g_object_get_data (G_OBJECT (source_node), "graph"))
             g_warning ("eval-visitor encountered a NULL buffer passed from: %s.%s-[%p]",
                        gegl_node_get_debug_name (source_node),
@@ -148,6 +349,22 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
           gegl_operation_context_set_property (context,
                                           gegl_pad_get_name (pad),
                                           &value);
+
+          /* count the conversions needed where the formats of the nodes
+           * on both sides of a connection differ
+           */
+          if (GEGL_IS_BUFFER (g_value_get_object (&value)) && pad->format)
+            {
+              const Babl *format = gegl_buffer_get_format (g_value_get_object (&value));
+
+              if (format != pad->format)
+                gegl_instrument_conversion (babl_get_name (format),
+                                            babl_get_name (pad->format),
+                                            (glong) source_context->result_rect.width *
+                                            source_context->result_rect.height *
+                                            babl_format_get_bytes_per_pixel (pad->format));
+            }
+
           /* reference counting for this source dropped to zero, freeing up */
           if (-- gegl_node_get_context (
                      gegl_pad_get_node (source_pad), context_id)->refs == 0 &&
@@ -176,3 +393,335 @@ gegl_eval_visitor_visit_pad (GeglVisitor *self,
         }
     }
 }
+
+/* the pads pad depends on, taken from the plan when there is one, the
+ * list has to be freed when owned is set
+ */
+static GSList *
+eval_traversal_depends_on (EvalTraversal *traversal,
+                           GeglPad       *pad,
+                           gboolean      *owned)
+{
+  gpointer depends_on;
+
+  if (traversal->dependencies &&
+      g_hash_table_lookup_extended (traversal->dependencies, pad,
+                                    NULL, &depends_on))
+    {
+      *owned = FALSE;
+      return depends_on;
+    }
+
+  *owned = TRUE;
+  return gegl_visitable_depends_on (GEGL_VISITABLE (pad));
+}
+
+static gboolean
+eval_traversal_visited (EvalTraversal *traversal,
+                        GeglPad       *pad)
+{
+  gboolean visited;
+
+  g_mutex_lock (traversal->mutex);
+  visited = g_hash_table_lookup (traversal->visited, pad) != NULL;
+  g_mutex_unlock (traversal->mutex);
+
+  return visited;
+}
+
+/* collects the pads not yet visited that pad depends on, pad included */
+static void
+eval_traversal_collect (EvalTraversal *traversal,
+                        GeglPad       *pad,
+                        GHashTable    *pads)
+{
+  GSList   *depends_on;
+  GSList   *llink;
+  gboolean  owned;
+
+  if (g_hash_table_lookup (pads, pad) ||
+      eval_traversal_visited (traversal, pad))
+    return;
+
+  g_hash_table_insert (pads, pad, pad);
+
+  depends_on = eval_traversal_depends_on (traversal, pad, &owned);
+  for (llink = depends_on; llink; llink = g_slist_next (llink))
+    eval_traversal_collect (traversal, llink->data, pads);
+  if (owned)
+    g_slist_free (depends_on);
+}
+
+/* the memory the results of the output pads among pads take */
+static guint64
+eval_traversal_estimate (EvalTraversal *traversal,
+                         GHashTable    *pads)
+{
+  GHashTableIter iter;
+  gpointer       key;
+  guint64        bytes = 0;
+
+  g_hash_table_iter_init (&iter, pads);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      GeglPad              *pad = key;
+      GeglOperationContext *context;
+      const Babl           *format;
+
+      if (!gegl_pad_is_output (pad))
+        continue;
+
+      context = gegl_node_get_context (gegl_pad_get_node (pad),
+                                       traversal->visitor->context_id);
+      format  = gegl_pad_get_format (pad);
+      if (!context)
+        continue;
+
+      bytes += (guint64) context->result_rect.width *
+               context->result_rect.height *
+               (format ? babl_format_get_bytes_per_pixel (format) : 16);
+    }
+
+  return bytes;
+}
+
+static gboolean
+eval_branch_reserve (guint64 bytes)
+{
+  gboolean reserved = FALSE;
+
+  g_static_mutex_lock (&branch_mutex);
+  if (branch_helpers < gegl_config ()->threads - 1 &&
+      branch_bytes + bytes <= gegl_config ()->cache_size)
+    {
+      branch_helpers++;
+      branch_bytes += bytes;
+      reserved = TRUE;
+    }
+  g_static_mutex_unlock (&branch_mutex);
+
+  return reserved;
+}
+
+static void
+eval_branch_release (guint64 bytes)
+{
+  g_static_mutex_lock (&branch_mutex);
+  branch_helpers--;
+  branch_bytes -= bytes;
+  g_static_mutex_unlock (&branch_mutex);
+}
+
+static void eval_traversal_visit (EvalTraversal *traversal,
+                                  GeglPad       *pad);
+
+static void
+eval_branch_run (gpointer task,
+                 gpointer user_data)
+{
+  EvalBranch *branch = task;
+
+  eval_traversal_visit (branch->traversal, branch->pad);
+}
+
+/* Finds the inputs of the output pad that depend on disjoint parts of the
+ * graph that are not yet evaluated, and evaluates the source pads they are
+ * connected to concurrently when there are threads and memory to spare.
+ * The input pads themselves set properties on the context of the node the
+ * output pad belongs to, they are left to the depth first traversal along
+ * with the remaining inputs, once the branches are joined.
+ */
+static void
+eval_traversal_branch (EvalTraversal *traversal,
+                       GSList        *depends_on)
+{
+  EvalBranch  branches[GEGL_MAX_THREADS];
+  gpointer    tasks[GEGL_MAX_THREADS];
+  GHashTable *seen;
+  GSList     *llink;
+  gint        n_branches = 0;
+  gint        n_tasks;
+  gint        i;
+
+  if (gegl_config ()->threads <= 1 ||
+      g_slist_length (depends_on) < 2)
+    return;
+
+  seen = g_hash_table_new (NULL, NULL);
+
+  for (llink = depends_on; llink; llink = g_slist_next (llink))
+    {
+      GeglPad       *source_pad = gegl_pad_get_connected_to (llink->data);
+      GHashTable    *pads;
+      GHashTableIter iter;
+      gpointer       key;
+      gboolean       disjoint = TRUE;
+
+      /* unconnected inputs, such as a missing aux, have nothing to evaluate */
+      if (!source_pad)
+        continue;
+
+      pads = g_hash_table_new (NULL, NULL);
+      eval_traversal_collect (traversal, source_pad, pads);
+
+      g_hash_table_iter_init (&iter, pads);
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+          if (g_hash_table_lookup (seen, key))
+            disjoint = FALSE;
+          g_hash_table_insert (seen, key, key);
+        }
+
+      /* a pad with more than one connection is only evaluated once, the
+       * branches sharing it have to be evaluated one after the other
+       */
+      if (!disjoint)
+        {
+          g_hash_table_destroy (pads);
+          g_hash_table_destroy (seen);
+          return;
+        }
+
+      /* sources that are already evaluated are left out */
+      if (g_hash_table_size (pads) > 0 && n_branches < GEGL_MAX_THREADS)
+        {
+          branches[n_branches].traversal = traversal;
+          branches[n_branches].pad       = source_pad;
+          branches[n_branches].bytes     = eval_traversal_estimate (traversal, pads);
+          n_branches++;
+        }
+
+      g_hash_table_destroy (pads);
+    }
+
+  g_hash_table_destroy (seen);
+
+  if (n_branches < 2)
+    return;
+
+  /* the first branch is evaluated by this thread in any case */
+  tasks[0] = &branches[0];
+  n_tasks  = 1;
+
+  for (i = 1; i < n_branches; i++)
+    if (eval_branch_reserve (branches[i].bytes))
+      tasks[n_tasks++] = &branches[i];
+
+  if (n_tasks > 1)
+    {
+      gegl_scheduler_run_tasks (tasks, n_tasks, eval_branch_run, NULL);
+
+      for (i = 1; i < n_tasks; i++)
+        eval_branch_release (((EvalBranch *) tasks[i])->bytes);
+    }
+}
+
+static void
+eval_traversal_visit (EvalTraversal *traversal,
+                      GeglPad       *pad)
+{
+  GSList   *depends_on;
+  GSList   *llink;
+  gboolean  owned;
+
+  depends_on = eval_traversal_depends_on (traversal, pad, &owned);
+
+  if (gegl_pad_is_output (pad))
+    eval_traversal_branch (traversal, depends_on);
+
+  for (llink = depends_on; llink; llink = g_slist_next (llink))
+    {
+      if (!eval_traversal_visited (traversal, llink->data))
+        eval_traversal_visit (traversal, llink->data);
+    }
+
+  if (owned)
+    g_slist_free (depends_on);
+
+  gegl_visitable_accept (GEGL_VISITABLE (pad), traversal->visitor);
+
+  g_mutex_lock (traversal->mutex);
+  g_hash_table_insert (traversal->visited, pad, pad);
+  g_mutex_unlock (traversal->mutex);
+}
+
+/**
+ * gegl_eval_visitor_traverse:
+ * @self: a #GeglEvalVisitor
+ * @pad: the pad to evaluate
+ *
+ * Evaluates @pad and what it depends on, depth first like
+ * gegl_visitor_dfs_traverse(). Independent inputs of a node, such as the
+ * input and aux branches of a composer, are evaluated concurrently when
+ * there are spare threads and the cache size allows for the memory they
+ * need.
+ **/
+void
+gegl_eval_visitor_traverse (GeglEvalVisitor *self,
+                            GeglPad         *pad)
+{
+  gegl_eval_visitor_traverse_planned (self, pad, NULL);
+}
+
+/**
+ * gegl_eval_visitor_new_dependencies:
+ * @pads: the pads of a recorded evaluation
+ *
+ * Looks up what each of @pads depends on, for traversals of a graph that
+ * has not changed since @pads were recorded.
+ *
+ * Returns: a #GHashTable to pass to gegl_eval_visitor_traverse_planned(),
+ * free with g_hash_table_destroy().
+ **/
+GHashTable *
+gegl_eval_visitor_new_dependencies (GPtrArray *pads)
+{
+  GHashTable *dependencies;
+  guint       i;
+
+  dependencies = g_hash_table_new_full (NULL, NULL, NULL,
+                                        (GDestroyNotify) g_slist_free);
+
+  for (i = 0; i < pads->len; i++)
+    {
+      GeglPad *pad = g_ptr_array_index (pads, i);
+
+      if (!g_hash_table_lookup_extended (dependencies, pad, NULL, NULL))
+        g_hash_table_insert (dependencies, pad,
+                             gegl_visitable_depends_on (GEGL_VISITABLE (pad)));
+    }
+
+  return dependencies;
+}
+
+/**
+ * gegl_eval_visitor_traverse_planned:
+ * @self: a #GeglEvalVisitor
+ * @pad: the pad to evaluate
+ * @dependencies: the result of gegl_eval_visitor_new_dependencies(), or
+ * NULL
+ *
+ * Like gegl_eval_visitor_traverse(), taking what the pads depend on from
+ * @dependencies instead of asking the graph. The table is only read, the
+ * branches evaluated concurrently share it.
+ **/
+void
+gegl_eval_visitor_traverse_planned (GeglEvalVisitor *self,
+                                    GeglPad         *pad,
+                                    GHashTable      *dependencies)
+{
+  EvalTraversal traversal;
+
+  g_return_if_fail (GEGL_IS_EVAL_VISITOR (self));
+  g_return_if_fail (GEGL_IS_PAD (pad));
+
+  traversal.visitor      = GEGL_VISITOR (self);
+  traversal.visited      = g_hash_table_new (NULL, NULL);
+  traversal.mutex        = g_mutex_new ();
+  traversal.dependencies = dependencies;
+
+  eval_traversal_visit (&traversal, pad);
+
+  g_mutex_free (traversal.mutex);
+  g_hash_table_destroy (traversal.visited);
+}
@@ -47,6 +47,14 @@ struct _GeglEvalVisitorClass
 
 GType   gegl_eval_visitor_get_type (void) G_GNUC_CONST;
 
+void    gegl_eval_visitor_traverse (GeglEvalVisitor *self,
+                                    GeglPad         *pad);
+
+GHashTable * gegl_eval_visitor_new_dependencies (GPtrArray       *pads);
+void         gegl_eval_visitor_traverse_planned (GeglEvalVisitor *self,
+                                                 GeglPad         *pad,
+                                                 GHashTable      *dependencies);
+
 
 G_END_DECLS
 
@@ -66,7 +66,10 @@ gegl_need_visitor_visit_node (GeglVisitor *self,
   gegl_operation_calc_need_rects (node->operation, self->context_id);
   if (!context->cached)
     {
-      gegl_rectangle_intersect (&context->result_rect, &node->have_rect, &context->need_rect);
+      GeglRectangle have_rect;
+
+      gegl_rectangle_to_level (&have_rect, &node->have_rect, context->level);
+      gegl_rectangle_intersect (&context->result_rect, &have_rect, &context->need_rect);
       /* here we expand to the size requested by the operation to be cached */
       context->result_rect = gegl_operation_get_cached_region (node->operation, &context->result_rect);
     }
@@ -28,6 +28,7 @@
 #include "graph/gegl-visitable.h"
 #include "gegl-instrument.h"
 #include "operation/gegl-operation.h"
+#include "opencl/gegl-cl.h"
 
 
 static void gegl_prepare_visitor_class_init (GeglPrepareVisitorClass *klass);
@@ -51,6 +52,50 @@ gegl_prepare_visitor_init (GeglPrepareVisitor *self)
 {
 }
 
+/* Operations that process other formats than the ones they pick in
+ * prepare list them in their "input-formats" key, separated by '|'. When
+ * their input arrives in one of them, it is used for both their input and
+ * their output, sparing the conversions on both sides of the operation.
+ */
+static void
+gegl_prepare_visitor_negotiate (GeglOperation *operation)
+{
+  GeglOperationClass *klass   = GEGL_OPERATION_GET_CLASS (operation);
+  const gchar        *formats = gegl_operation_class_get_key (klass, "input-formats");
+  GeglPad            *input;
+  GeglPad            *output;
+  const Babl         *source_format;
+  gchar             **names;
+  gint                i;
+
+  if (!formats)
+    return;
+
+  /* the OpenCL kernels are written for the formats picked in prepare */
+  if (gegl_cl_is_accelerated () &&
+      gegl_operation_class_get_key (klass, "cl-source"))
+    return;
+
+  input  = gegl_node_get_pad (operation->node, "input");
+  output = gegl_node_get_pad (operation->node, "output");
+  source_format = gegl_operation_get_source_format (operation, "input");
+
+  if (!input || !output || !source_format || source_format == input->format)
+    return;
+
+  names = g_strsplit (formats, "|", 0);
+  for (i = 0; names[i]; i++)
+    {
+      if (babl_format (names[i]) == source_format)
+        {
+          gegl_operation_set_format (operation, "input", source_format);
+          gegl_operation_set_format (operation, "output", source_format);
+          break;
+        }
+    }
+  g_strfreev (names);
+}
+
 /* adds a context to the node, calls the operation's prepare method and
  * sets the node's "needed rectangle" to an empty one
  */
@@ -92,6 +137,7 @@ gegl_prepare_visitor_visit_node (GeglVisitor *self,
 
   g_mutex_lock (node->mutex);
   gegl_operation_prepare (operation);
+  gegl_prepare_visitor_negotiate (operation);
   g_mutex_unlock (node->mutex);
   {
     /* initialise the "needed rectangle" to an empty one */
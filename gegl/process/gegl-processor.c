@@ -19,15 +19,20 @@
 #include "config.h"
 
 #include <glib-object.h>
+#include <gio/gio.h>
+#include <string.h>
 
 #include "gegl.h"
 #include "gegl-debug.h"
 #include "buffer/gegl-region.h"
+#include "buffer/gegl-buffer-private.h"
 #include "graph/gegl-node.h"
 
+#include "operation/gegl-operation.h"
 #include "operation/gegl-operation-sink.h"
 
 #include "gegl-config.h"
+#include "gegl-instrument.h"
 #include "gegl-processor.h"
 #include "gegl-types-internal.h"
 #include "gegl-utils.h"
@@ -43,7 +48,9 @@ enum
   PROP_NODE,
   PROP_CHUNK_SIZE,
   PROP_PROGRESS,
-  PROP_RECTANGLE
+  PROP_RECTANGLE,
+  PROP_PROGRESSIVE,
+  PROP_CANCELLABLE
 };
 
 
@@ -64,7 +71,25 @@ static GObject * gegl_processor_constructor  (GType                  type,
                                               guint                  n_params,
                                               GObjectConstructParam *params);
 static gdouble   gegl_processor_progress     (GeglProcessor         *processor);
-static gint      gegl_processor_get_band_size(gint                   size) G_GNUC_CONST;
+static void      gegl_processor_restart_levels (GeglProcessor       *processor);
+static gint      gegl_processor_get_band_size(gint                   start,
+                                              gint                   size,
+                                              gint                   tile_size) G_GNUC_CONST;
+static void      gegl_processor_queue_chunk  (GeglProcessor         *processor,
+                                              const GeglRectangle   *rect);
+static gint      gegl_processor_queue_invalid (GeglProcessor       *processor,
+                                               const GeglRectangle *rect,
+                                               GeglRegion          *valid_region);
+
+
+/* a rectangle waiting to be rendered, the chunks with the lowest priority
+ * value are rendered first
+ */
+typedef struct
+{
+  GeglRectangle rect;
+  gdouble       priority;
+} GeglProcessorChunk;
 
 
 struct _GeglProcessor
@@ -77,9 +102,27 @@ struct _GeglProcessor
 
   GeglRegion      *valid_region;     /* used when doing unbuffered rendering */
   GeglRegion      *queued_region;
-  GSList          *dirty_rectangles;
+  GSequence       *chunks;           /* GeglProcessorChunks, sorted */
   gint             chunk_size;
 
+  gboolean         has_focus;        /* the center of the rectangle is
+                                        the focus otherwise */
+  gint             focus_x;
+  gint             focus_y;
+  GeglProcessorPriorityFunc priority_func;
+  gpointer         priority_data;
+  GDestroyNotify   priority_destroy;
+
+  gint             progressive;      /* levels to preview before 1:1 */
+  gint             level;            /* level being previewed, 0 when
+                                        rendering at 1:1 */
+  GeglRegion      *preview_region;   /* previewed at the current level */
+
+  GCancellable    *cancellable;
+  glong            deadline;         /* in gegl_ticks (), 0 for none */
+  gdouble          throughput;       /* pixels rendered per microsecond,
+                                        0.0 until measured */
+
   gdouble          progress;
 };
 
@@ -87,6 +130,13 @@ struct _GeglProcessor
 G_DEFINE_TYPE (GeglProcessor, gegl_processor, G_TYPE_OBJECT)
 
 
+static void
+gegl_processor_chunk_free (gpointer chunk)
+{
+  g_slice_free (GeglProcessorChunk, chunk);
+}
+
+
 static void
 gegl_processor_class_init (GeglProcessorClass *klass)
 {
@@ -125,6 +175,20 @@ gegl_processor_class_init (GeglProcessorClass *klass)
                                                      1, 1024 * 1024, gegl_config()->chunk_size,
                                                      G_PARAM_READWRITE |
                                                      G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (gobject_class, PROP_PROGRESSIVE,
+                                   g_param_spec_int ("progressive",
+                                                     "progressive",
+                                                     "Number of levels to render a preview at before rendering at 1:1, 3 starts at 1:8 and refines through 1:4 and 1:2. Only used when all the operations are level aware.",
+                                                     0, 8, 0,
+                                                     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_CANCELLABLE,
+                                   g_param_spec_object ("cancellable",
+                                                        "cancellable",
+                                                        "Stops the rendering when cancelled, from any thread. Chunks being rendered are abandoned and rendered again once the cancellable has been reset.",
+                                                        G_TYPE_CANCELLABLE,
+                                                        G_PARAM_READWRITE));
 }
 
 static void
@@ -134,8 +198,18 @@ gegl_processor_init (GeglProcessor *processor)
   processor->input            = NULL;
   processor->context          = NULL;
   processor->queued_region    = NULL;
-  processor->dirty_rectangles = NULL;
+  processor->chunks           = g_sequence_new (gegl_processor_chunk_free);
   processor->chunk_size       = 128 * 128;
+  processor->progressive      = 0;
+  processor->level            = 0;
+  processor->preview_region   = NULL;
+  processor->cancellable      = NULL;
+  processor->deadline         = 0;
+  processor->throughput       = 0.0;
+  processor->has_focus        = FALSE;
+  processor->priority_func    = NULL;
+  processor->priority_data    = NULL;
+  processor->priority_destroy = NULL;
 }
 
 /* Initialises the fields processor->input, processor->valid_region
@@ -188,6 +262,23 @@ gegl_processor_finalize (GObject *self_object)
       gegl_region_destroy (processor->valid_region);
     }
 
+  if (processor->preview_region)
+    {
+      gegl_region_destroy (processor->preview_region);
+    }
+
+  if (processor->cancellable)
+    {
+      g_object_unref (processor->cancellable);
+    }
+
+  if (processor->priority_destroy)
+    {
+      processor->priority_destroy (processor->priority_data);
+    }
+
+  g_sequence_free (processor->chunks);
+
   G_OBJECT_CLASS (gegl_processor_parent_class)->finalize (self_object);
 }
 
@@ -213,6 +304,17 @@ gegl_processor_set_property (GObject      *gobject,
         gegl_processor_set_rectangle (self, g_value_get_pointer (value));
         break;
 
+      case PROP_PROGRESSIVE:
+        self->progressive = g_value_get_int (value);
+        gegl_processor_restart_levels (self);
+        break;
+
+      case PROP_CANCELLABLE:
+        if (self->cancellable)
+          g_object_unref (self->cancellable);
+        self->cancellable = g_value_dup_object (value);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -244,6 +346,14 @@ gegl_processor_get_property (GObject    *gobject,
         g_value_set_double (value, gegl_processor_progress (self));
         break;
 
+      case PROP_PROGRESSIVE:
+        g_value_set_int (value, self->progressive);
+        break;
+
+      case PROP_CANCELLABLE:
+        g_value_set_object (value, self->cancellable);
+        break;
+
       default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (gobject, property_id, pspec);
         break;
@@ -304,15 +414,14 @@ gegl_processor_set_node (GeglProcessor *processor,
 
 
 /* Sets the processor->rectangle to the given rectangle (or the node
- * bounding box if rectangle is NULL) and removes any
- * dirty_rectangles, then updates node context_id with result rect and
- * need rect
+ * bounding box if rectangle is NULL) and queues the parts of it that are
+ * not yet valid in place of the chunks queued before, then updates node
+ * context_id with result rect and need rect
  */
 void
 gegl_processor_set_rectangle (GeglProcessor       *processor,
                               const GeglRectangle *rectangle)
 {
-  GSList        *iter;
   GeglRectangle  input_bounding_box;
 
   g_return_if_fail (processor->input != NULL);
@@ -328,7 +437,7 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
              rectangle->x, rectangle->y, rectangle->width, rectangle->height);
 
   /* if the processor's rectangle isn't already set to the node's bounding box,
-   * then set it and remove processor->dirty_rectangles (set to NULL)  */
+   * then set it */
   if (! gegl_rectangle_equal (&processor->rectangle, rectangle))
     {
 #if 0
@@ -342,16 +451,6 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       gegl_rectangle_intersect (&processor->rectangle, &processor->rectangle, &bounds);
 #endif
     }
-    {
-
-      /* remove already queued dirty rectangles */
-      for (iter = processor->dirty_rectangles; iter; iter = g_slist_next (iter))
-        {
-          g_slice_free (GeglRectangle, iter->data);
-        }
-      g_slist_free (processor->dirty_rectangles);
-      processor->dirty_rectangles = NULL;
-    }
 
   /* if the node's operation is a sink and it needs the full content then
    * a context will be set up together with a cache and
@@ -386,28 +485,106 @@ gegl_processor_set_rectangle (GeglProcessor       *processor,
       processor->valid_region = gegl_region_new ();
     }
 
+  /* the chunks queued for the previous rectangle are dropped, what is left
+   * of them in view is queued again along with the rest of the rectangle,
+   * ordered for the new rectangle */
+  g_sequence_remove_range (g_sequence_get_begin_iter (processor->chunks),
+                           g_sequence_get_end_iter (processor->chunks));
+  gegl_processor_queue_invalid (processor, &processor->rectangle,
+                                processor->valid_region ?
+                                processor->valid_region :
+                                gegl_node_get_cache (processor->input)->valid_region);
+
+  gegl_processor_restart_levels (processor);
+
   g_object_notify (G_OBJECT (processor), "rectangle");
 }
 
-/* Will generate band_sizes that are adapted to the size of the tiles */
+/* whether a preview of the output can be rendered at coarser levels, it
+ * is put in the cache of the input, and all the operations feeding it
+ * have to be level aware
+ */
+static gboolean
+gegl_processor_is_level_aware (GeglProcessor *processor)
+{
+  GeglVisitor *visitor;
+  GSList      *iter;
+  gboolean     level_aware = TRUE;
+
+  if (!processor->node || !processor->input ||
+      GEGL_IS_OPERATION_SINK (processor->node->operation))
+    return FALSE;
+
+  visitor = g_object_new (GEGL_TYPE_VISITOR, NULL);
+  gegl_visitor_reset (visitor);
+  gegl_visitor_dfs_traverse (visitor, GEGL_VISITABLE (processor->input));
+
+  for (iter = gegl_visitor_get_visits_list (visitor); iter; iter = iter->next)
+    {
+      GeglNode *node = iter->data;
+
+      if (node->operation && !gegl_operation_is_level_aware (node->operation))
+        {
+          GEGL_NOTE (GEGL_DEBUG_PROCESS, "no preview levels, \"%s\" is not level aware",
+                     gegl_node_get_debug_name (node));
+          level_aware = FALSE;
+          break;
+        }
+    }
+
+  g_object_unref (visitor);
+
+  return level_aware;
+}
+
+/* starts over from the coarsest preview level */
+static void
+gegl_processor_restart_levels (GeglProcessor *processor)
+{
+  if (processor->preview_region)
+    {
+      gegl_region_destroy (processor->preview_region);
+      processor->preview_region = NULL;
+    }
+
+  processor->level = 0;
+
+  if (processor->progressive > 0 && gegl_processor_is_level_aware (processor))
+    {
+      processor->level          = processor->progressive;
+      processor->preview_region = gegl_region_new ();
+    }
+}
+
+static gint
+floor_div (gint a,
+           gint b)
+{
+  return a >= 0 ? a / b : - ((b - 1 - a) / b);
+}
+
+/* Will generate band_sizes that cut a span starting at start close to its
+ * middle, on the tile grid when the span covers more than one tile, so
+ * that the chunks rendered match the tiles invalidated in the cache.
+ */
 static gint
-gegl_processor_get_band_size (gint size)
+gegl_processor_get_band_size (gint start,
+                              gint size,
+                              gint tile_size)
 {
   gint band_size;
+  gint cut;
 
   band_size = size / 2;
 
-  /* try to make the rects generated match better with potential 2^n sized
-   * tiles, XXX: should be improved to make the next slice fit as well. */
-  if (band_size <= 256)
+  if (tile_size > 0 && size > tile_size)
     {
-      band_size = MIN(band_size, 128); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
-    }
-  else if (band_size <= 512)
-    {
-      band_size = MIN(band_size, 256); /* prefer a band_size of 128,
-                                          hoping to hit tiles */
+      /* the tile boundary nearest to the middle, not at either end */
+      cut = floor_div (start + band_size + tile_size / 2, tile_size) * tile_size;
+      cut = CLAMP (cut - start, 1, size - 1);
+
+      if ((cut + start) % tile_size == 0)
+        band_size = cut;
     }
 
   if (band_size < 1)
@@ -416,6 +593,190 @@ gegl_processor_get_band_size (gint size)
   return band_size;
 }
 
+/* how soon a chunk is to be rendered, lower values first; by default the
+ * squared distance from the focus to the nearest pixel of the chunk
+ */
+static gdouble
+gegl_processor_get_priority (GeglProcessor       *processor,
+                             const GeglRectangle *rect)
+{
+  gint focus_x, focus_y;
+  gint dx = 0, dy = 0;
+
+  if (processor->priority_func)
+    return processor->priority_func (rect, processor->priority_data);
+
+  if (processor->has_focus)
+    {
+      focus_x = processor->focus_x;
+      focus_y = processor->focus_y;
+    }
+  else
+    {
+      focus_x = processor->rectangle.x + processor->rectangle.width / 2;
+      focus_y = processor->rectangle.y + processor->rectangle.height / 2;
+    }
+
+  if (focus_x < rect->x)
+    dx = rect->x - focus_x;
+  else if (focus_x >= rect->x + rect->width)
+    dx = focus_x - (rect->x + rect->width - 1);
+
+  if (focus_y < rect->y)
+    dy = rect->y - focus_y;
+  else if (focus_y >= rect->y + rect->height)
+    dy = focus_y - (rect->y + rect->height - 1);
+
+  return (gdouble) dx * dx + (gdouble) dy * dy;
+}
+
+static gint
+gegl_processor_chunk_compare (gconstpointer a,
+                              gconstpointer b,
+                              gpointer      unused)
+{
+  const GeglProcessorChunk *chunk_a = a;
+  const GeglProcessorChunk *chunk_b = b;
+
+  if (chunk_a->priority < chunk_b->priority)
+    return -1;
+  if (chunk_a->priority > chunk_b->priority)
+    return 1;
+  return 0;
+}
+
+static void
+gegl_processor_queue_chunk (GeglProcessor       *processor,
+                            const GeglRectangle *rect)
+{
+  GeglProcessorChunk *chunk = g_slice_new (GeglProcessorChunk);
+
+  chunk->rect     = *rect;
+  chunk->priority = gegl_processor_get_priority (processor, rect);
+
+  g_sequence_insert_sorted (processor->chunks, chunk,
+                            gegl_processor_chunk_compare, NULL);
+}
+
+/* queues the parts of rect not in valid_region, returns how many */
+static gint
+gegl_processor_queue_invalid (GeglProcessor       *processor,
+                              const GeglRectangle *rect,
+                              GeglRegion          *valid_region)
+{
+  GeglRegion    *region = gegl_region_rectangle (rect);
+  GeglRectangle *rectangles;
+  gint           n_rectangles;
+  gint           i;
+
+  gegl_region_subtract (region, valid_region);
+  gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+  gegl_region_destroy (region);
+
+  for (i = 0; i < n_rectangles; i++)
+    gegl_processor_queue_chunk (processor, &rectangles[i]);
+  g_free (rectangles);
+
+  return n_rectangles;
+}
+
+/* orders the queued chunks again, after the focus or the priority function
+ * changed
+ */
+static void
+gegl_processor_reprioritize (GeglProcessor *processor)
+{
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (processor->chunks);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
+    {
+      GeglProcessorChunk *chunk = g_sequence_get (iter);
+
+      chunk->priority = gegl_processor_get_priority (processor, &chunk->rect);
+    }
+
+  g_sequence_sort (processor->chunks, gegl_processor_chunk_compare, NULL);
+}
+
+void
+gegl_processor_set_focus (GeglProcessor *processor,
+                          gint           x,
+                          gint           y)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  processor->has_focus = TRUE;
+  processor->focus_x   = x;
+  processor->focus_y   = y;
+
+  gegl_processor_reprioritize (processor);
+}
+
+void
+gegl_processor_set_priority_func (GeglProcessor             *processor,
+                                  GeglProcessorPriorityFunc  func,
+                                  gpointer                   user_data,
+                                  GDestroyNotify             destroy)
+{
+  g_return_if_fail (GEGL_IS_PROCESSOR (processor));
+
+  if (processor->priority_destroy)
+    processor->priority_destroy (processor->priority_data);
+
+  processor->priority_func    = func;
+  processor->priority_data    = user_data;
+  processor->priority_destroy = destroy;
+
+  gegl_processor_reprioritize (processor);
+}
+
+/* the largest chunk to render in one step, when working towards a deadline
+ * no larger than what is expected to be done by then at the throughput
+ * measured so far, but at least a tile
+ */
+static gint
+gegl_processor_get_max_area (GeglProcessor *processor)
+{
+  gint max_area = processor->chunk_size;
+
+  /* every step is rendered by all the threads of the scheduler, give them
+   * a chunk each
+   */
+  if (gegl_config ()->threads > 1 &&
+      gegl_config ()->threads <= GEGL_MAX_THREADS)
+    max_area *= gegl_config ()->threads;
+
+  if (processor->deadline && processor->throughput > 0.0)
+    {
+      gdouble in_time  = processor->throughput *
+                         MAX (processor->deadline - gegl_ticks (), 0);
+      gint    min_area = gegl_config ()->tile_width * gegl_config ()->tile_height;
+
+      if (in_time < max_area)
+        max_area = MIN (max_area, MAX ((gint) in_time, min_area));
+    }
+
+  return max_area;
+}
+
+/* updates the throughput with the time it took to render a chunk, smoothed
+ * as the cost of the graph varies across the image
+ */
+static void
+gegl_processor_measure (GeglProcessor       *processor,
+                        const GeglRectangle *chunk,
+                        glong                usecs)
+{
+  gdouble rate = (gdouble) chunk->width * chunk->height / MAX (usecs, 1);
+
+  if (processor->throughput > 0.0)
+    processor->throughput = (processor->throughput + rate) / 2.0;
+  else
+    processor->throughput = rate;
+}
+
 /* If the processor's dirty rectangle is too big then it will be cut, added
  * to the processor's list of dirty rectangles and TRUE will be returned.
  * If the rectangle is small enough it will be processed, using a buffer or
@@ -423,10 +784,11 @@ gegl_processor_get_band_size (gint size)
 static gboolean
 render_rectangle (GeglProcessor *processor)
 {
-  gboolean   buffered;
-  const gint max_area = processor->chunk_size;
-  GeglCache *cache    = NULL;
-  gint       pxsize;
+  gboolean       buffered;
+  gint           max_area = gegl_processor_get_max_area (processor);
+  GeglCache     *cache    = NULL;
+  gint           pxsize;
+  GSequenceIter *first;
 
   /* Retreive the cache if the processor's node is not buffered if it's
    * operation is a sink and it doesn't use the full area  */
@@ -438,95 +800,252 @@ render_rectangle (GeglProcessor *processor)
       g_object_get (cache, "px-size", &pxsize, NULL);
     }
 
-  if (processor->dirty_rectangles)
+  first = g_sequence_get_begin_iter (processor->chunks);
+
+  if (!g_sequence_iter_is_end (first))
     {
-      GeglRectangle *dr = processor->dirty_rectangles->data;
+      GeglRectangle dr = ((GeglProcessorChunk *) g_sequence_get (first))->rect;
+
+      /* take the chunk that comes first out of the queue */
+      g_sequence_remove (first);
 
-      /* If a dirty rectangle is bigger than the max area, then cut it
-       * to smaller pieces */
-      if (dr->height * dr->width > max_area && 1)
+      /* If a chunk is partly valid in the cache, only the parts that are
+       * not are queued, these are whole tiles of the cache, as it
+       * invalidates tiles */
+      if (buffered &&
+          gegl_region_rect_in (cache->valid_region, &dr) == GEGL_OVERLAP_RECTANGLE_PART)
         {
-          gint band_size;
+          gegl_processor_queue_invalid (processor, &dr, cache->valid_region);
 
-          {
-            GeglRectangle *fragment;
+          return TRUE;
+        }
 
-            fragment = g_slice_dup (GeglRectangle, dr);
+      /* If a chunk is bigger than the max area, then cut it to smaller
+       * pieces, the piece closer to the focus is rendered first */
+      if (dr.height * dr.width > max_area)
+        {
+          GeglRectangle fragment = dr;
+          gint          band_size;
 
-            /* When splitting a rectangle, we'll do it on the biggest side */
-            if (dr->width > dr->height)
-              {
-                band_size = gegl_processor_get_band_size ( dr->width );
+          /* When splitting a rectangle, we'll do it on the biggest side */
+          if (dr.width > dr.height)
+            {
+              band_size = gegl_processor_get_band_size (dr.x, dr.width,
+                                                        gegl_config ()->tile_width);
 
-                fragment->width = band_size;
-                dr->width      -= band_size;
-                dr->x          += band_size;
-              }
-            else
-              {
-                band_size = gegl_processor_get_band_size (dr->height);
+              fragment.width = band_size;
+              dr.width      -= band_size;
+              dr.x          += band_size;
+            }
+          else
+            {
+              band_size = gegl_processor_get_band_size (dr.y, dr.height,
+                                                        gegl_config ()->tile_height);
 
-                fragment->height = band_size;
-                dr->height      -= band_size;
-                dr->y           += band_size;
-              }
-            processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles, fragment);
-          }
-          return TRUE;
-        }
-      /* remove the rectangle that will be processed from the list of dirty ones */
-      processor->dirty_rectangles = g_slist_remove (processor->dirty_rectangles, dr);
+              fragment.height = band_size;
+              dr.height      -= band_size;
+              dr.y           += band_size;
+            }
 
-      if (!dr->width || !dr->height)
-        {
-          g_slice_free (GeglRectangle, dr);
+          gegl_processor_queue_chunk (processor, &fragment);
+          gegl_processor_queue_chunk (processor, &dr);
 
           return TRUE;
         }
 
+      if (!dr.width || !dr.height)
+        return TRUE;
+
       if (buffered)
         {
           /* only do work if the rectangle is not completely inside the valid
            * region of the cache */
-          if (gegl_region_rect_in (cache->valid_region, dr) !=
+          if (gegl_region_rect_in (cache->valid_region, &dr) !=
               GEGL_OVERLAP_RECTANGLE_IN)
             {
               /* create a buffer and initialise it */
-              guchar *buf;
+              GeglRegion *newly_valid;
+              guchar     *buf;
+              glong       ticks;
+
+              /* the part of dr this chunk makes valid */
+              newly_valid = gegl_region_rectangle (&dr);
+              gegl_region_subtract (newly_valid, cache->valid_region);
 
-              gegl_region_union_with_rect (cache->valid_region, dr);
-              buf = g_malloc (dr->width * dr->height * pxsize);
+              gegl_region_union_with_rect (cache->valid_region, &dr);
+              buf = g_malloc (dr.width * dr.height * pxsize);
               g_assert (buf);
 
               /* do the image calculations using the buffer */
-              gegl_node_blit (cache->node, 1.0, dr, cache->format, buf,
+              ticks = gegl_ticks ();
+              gegl_node_blit (cache->node, 1.0, &dr, cache->format, buf,
                               GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
 
+              /* a cancelled chunk is incomplete, it is queued again to be
+               * rendered when the cancellable is reset */
+              if (g_cancellable_is_cancelled (processor->cancellable))
+                {
+                  /* what was valid before the chunk stays valid */
+                  gegl_region_subtract (cache->valid_region, newly_valid);
+                  gegl_region_destroy (newly_valid);
+                  g_free (buf);
+
+                  gegl_processor_queue_chunk (processor, &dr);
+                  return TRUE;
+                }
+              gegl_region_destroy (newly_valid);
+
+              gegl_processor_measure (processor, &dr, gegl_ticks () - ticks);
+
 
               /* copy the buffer data into the cache */
-              gegl_buffer_set (GEGL_BUFFER (cache), dr, 0, cache->format, buf,
+              gegl_buffer_set (GEGL_BUFFER (cache), &dr, 0, cache->format, buf,
                                GEGL_AUTO_ROWSTRIDE); /* XXX: deal with the level */
 
               /* tells the cache that the rectangle (dr) has been computed */
-              gegl_cache_computed (cache, dr);
+              gegl_cache_computed (cache, &dr);
 
               /* release the buffer */
               g_free (buf);
             }
-          g_slice_free (GeglRectangle, dr);
         }
       else
         {
-           gegl_node_blit (processor->node, 1.0, dr, NULL, NULL,
+           glong ticks = gegl_ticks ();
+
+           gegl_node_blit (processor->node, 1.0, &dr, NULL, NULL,
                            GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
-           gegl_region_union_with_rect (processor->valid_region, dr);
-           g_slice_free (GeglRectangle, dr);
+
+           if (g_cancellable_is_cancelled (processor->cancellable))
+             {
+               gegl_processor_queue_chunk (processor, &dr);
+               return TRUE;
+             }
+
+           gegl_processor_measure (processor, &dr, gegl_ticks () - ticks);
+           gegl_region_union_with_rect (processor->valid_region, &dr);
         }
     }
 
-  return processor->dirty_rectangles != NULL;
+  return g_sequence_get_length (processor->chunks) > 0;
 }
 
+/* Renders a chunk of the preview at the current level, scaled up into the
+ * cache of the input without marking it as computed, so that rendering at
+ * 1:1 replaces it later. Moves on to the next level when the level has
+ * been previewed, returns FALSE when done with the levels.
+ */
+static gboolean
+render_level (GeglProcessor *processor)
+{
+  GeglCache *cache    = gegl_node_get_cache (processor->input);
+  gint       max_area = gegl_processor_get_max_area (processor);
+
+  while (processor->level > 0)
+    {
+      GeglRegion    *region;
+      GeglRectangle *rectangles;
+      gint           n_rectangles;
+      gint           level  = processor->level;
+      gint           factor = 1 << level;
+      gint           pxsize = babl_format_get_bytes_per_pixel (cache->format);
+
+      region = gegl_region_rectangle (&processor->rectangle);
+      gegl_region_subtract (region, cache->valid_region);
+      gegl_region_subtract (region, processor->preview_region);
+      gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+      gegl_region_destroy (region);
+
+      if (n_rectangles > 0)
+        {
+          GeglRectangle  dr;
+          GeglRectangle  lr;
+          GeglBuffer    *buffer;
+          gint64         max_pixels;
+          gint           best = 0;
+          gint           i;
+
+          /* the part closest to the focus is previewed first */
+          for (i = 1; i < n_rectangles; i++)
+            if (gegl_processor_get_priority (processor, &rectangles[i]) <
+                gegl_processor_get_priority (processor, &rectangles[best]))
+              best = i;
+          dr = rectangles[best];
+
+          /* the chunk has as many pixels at its level as at 1:1, which
+           * at the coarsest levels overflows a gint
+           */
+          max_pixels = (gint64) max_area * factor * factor;
+          if (dr.width > max_pixels)
+            dr.width = max_pixels;
+          if ((gint64) dr.width * dr.height > max_pixels)
+            dr.height = MAX (max_pixels / dr.width, 1);
+
+          g_free (rectangles);
+
+          gegl_rectangle_to_level (&lr, &dr, level);
+          buffer = gegl_node_render_level (processor->input, &lr, level);
+
+          /* the chunk is previewed again when the cancellable is reset */
+          if (g_cancellable_is_cancelled (processor->cancellable))
+            {
+              if (buffer)
+                g_object_unref (buffer);
+              return TRUE;
+            }
+
+          if (buffer)
+            {
+              guchar *src = g_malloc ((gsize) lr.width * lr.height * pxsize);
+              guchar *dst = g_malloc ((gsize) dr.width * dr.height * pxsize);
+              gint    x, y;
+
+              gegl_buffer_get (buffer, &lr, 1.0, cache->format, src,
+                               GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+              for (y = 0; y < dr.height; y++)
+                {
+                  guchar *row = src + (floor_div (dr.y + y, factor) - lr.y) *
+                                      lr.width * pxsize;
+
+                  for (x = 0; x < dr.width; x++)
+                    memcpy (dst + (y * dr.width + x) * pxsize,
+                            row + (floor_div (dr.x + x, factor) - lr.x) * pxsize,
+                            pxsize);
+                }
+
+              gegl_buffer_set (GEGL_BUFFER (cache), &dr, 0, cache->format, dst,
+                               GEGL_AUTO_ROWSTRIDE);
+
+              g_free (src);
+              g_free (dst);
+              g_object_unref (buffer);
+            }
+
+          gegl_region_union_with_rect (processor->preview_region, &dr);
+
+          /* let views show the preview, the cache stays invalid there */
+          g_signal_emit_by_name (cache, "computed", &dr, NULL);
+
+          return TRUE;
+        }
+
+      g_free (rectangles);
+
+      /* on to the next finer level */
+      gegl_region_destroy (processor->preview_region);
+      processor->preview_region = gegl_region_new ();
+      processor->level--;
+    }
+
+  if (processor->preview_region)
+    {
+      gegl_region_destroy (processor->preview_region);
+      processor->preview_region = NULL;
+    }
+
+  return FALSE;
+}
 
 static gint
 rect_area (GeglRectangle *rectangle)
@@ -574,7 +1093,7 @@ static gboolean
 gegl_processor_is_rendered (GeglProcessor *processor)
 {
   if (gegl_region_empty (processor->queued_region) &&
-      processor->dirty_rectangles == NULL)
+      g_sequence_get_length (processor->chunks) == 0)
     return TRUE;
   return FALSE;
 }
@@ -674,27 +1193,16 @@ gegl_processor_render (GeglProcessor *processor,
   if (rectangle)
     { /* we're asked to work on a specific rectangle thus we only focus
          on it */
-      GeglRegion    *region = gegl_region_rectangle (rectangle);
-      GeglRectangle *rectangles;
-      gint           n_rectangles;
-      gint           i;
+      GeglRegion *region = gegl_region_rectangle (rectangle);
+      gint        n_rectangles;
 
       gegl_region_subtract (region, valid_region);
-      gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+      gegl_region_subtract (processor->queued_region, region);
       gegl_region_destroy (region);
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
-        {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
-          gegl_region_subtract (processor->queued_region, tr);
-          gegl_region_destroy (tr);
-
-          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
-                                                         g_slice_dup (GeglRectangle, &roi));
-        }
-
-      g_free (rectangles);
+      /* all that is left is queued, to be rendered in order of priority */
+      n_rectangles = gegl_processor_queue_invalid (processor, rectangle,
+                                                   valid_region);
 
       if (n_rectangles != 0)
         {
@@ -707,7 +1215,7 @@ gegl_processor_render (GeglProcessor *processor,
       return FALSE;
     }
   else if (!gegl_region_empty (processor->queued_region) &&
-           !processor->dirty_rectangles)
+           g_sequence_get_length (processor->chunks) == 0)
     { /* XXX: this branch of the else can probably be removed if gegl-processors
          should only work with rectangular queued regions
        */
@@ -718,18 +1226,13 @@ gegl_processor_render (GeglProcessor *processor,
       gegl_region_get_rectangles (processor->queued_region, &rectangles,
                                   &n_rectangles);
 
-      for (i = 0; i < n_rectangles && i < 1; i++)
-        {
-          GeglRectangle  roi = rectangles[i];
-          GeglRegion    *tr = gegl_region_rectangle (&roi);
-          gegl_region_subtract (processor->queued_region, tr);
-          gegl_region_destroy (tr);
-
-          processor->dirty_rectangles = g_slist_prepend (processor->dirty_rectangles,
-                                                         g_slice_dup (GeglRectangle, &roi));
-        }
+      for (i = 0; i < n_rectangles; i++)
+        gegl_processor_queue_chunk (processor, &rectangles[i]);
 
       g_free (rectangles);
+
+      gegl_region_destroy (processor->queued_region);
+      processor->queued_region = gegl_region_new ();
     }
 
   if (progress)
@@ -742,9 +1245,9 @@ gegl_processor_render (GeglProcessor *processor,
 
 /* Will call gegl_processor_render and when there is no more work to be done,
  * it will write the result to the destination */
-gboolean
-gegl_processor_work (GeglProcessor *processor,
-                     gdouble       *progress)
+static gboolean
+gegl_processor_work_step (GeglProcessor *processor,
+                          gdouble       *progress)
 {
   gboolean   more_work = FALSE;
   GeglCache *cache     = gegl_node_get_cache (processor->input);
@@ -779,6 +1282,14 @@ gegl_processor_work (GeglProcessor *processor,
         }
     }
 
+  /* a coarse preview first, refined level by level */
+  if (processor->level > 0 && render_level (processor))
+    {
+      if (progress)
+        *progress = gegl_processor_progress (processor);
+      return TRUE;
+    }
+
   more_work = gegl_processor_render (processor, &processor->rectangle, progress);
   if (more_work)
     {
@@ -806,6 +1317,58 @@ gegl_processor_work (GeglProcessor *processor,
   return FALSE;
 }
 
+/* Does a step of work with the cancellable current for the thread, so that
+ * the scheduler, the iterators and the operations rendering it see it */
+gboolean
+gegl_processor_work (GeglProcessor *processor,
+                     gdouble       *progress)
+{
+  gboolean more_work = FALSE;
+
+  g_return_val_if_fail (GEGL_IS_PROCESSOR (processor), FALSE);
+
+  if (!g_cancellable_is_cancelled (processor->cancellable))
+    {
+      GCancellable *previous;
+
+      previous  = gegl_buffer_thread_set_cancellable (processor->cancellable);
+      more_work = gegl_processor_work_step (processor, progress);
+      gegl_buffer_thread_set_cancellable (previous);
+    }
+
+  if (g_cancellable_is_cancelled (processor->cancellable))
+    {
+      if (progress)
+        *progress = gegl_processor_progress (processor);
+      return FALSE;
+    }
+
+  return more_work;
+}
+
+gboolean
+gegl_processor_work_for (GeglProcessor *processor,
+                         gint           msecs,
+                         gdouble       *progress)
+{
+  gboolean more_work;
+
+  g_return_val_if_fail (GEGL_IS_PROCESSOR (processor), FALSE);
+
+  /* the chunks are sized to fit in what is left of the time, the first one
+   * of a new processor can take longer as its throughput is not yet known
+   */
+  processor->deadline = gegl_ticks () + (glong) MAX (msecs, 0) * 1000;
+
+  do
+    more_work = gegl_processor_work (processor, progress);
+  while (more_work && gegl_ticks () < processor->deadline);
+
+  processor->deadline = 0;
+
+  return more_work;
+}
+
 GeglProcessor *
 gegl_node_new_processor (GeglNode            *node,
                          const GeglRectangle *rectangle)
@@ -45,6 +45,17 @@ void           gegl_processor_set_rectangle (GeglProcessor       *processor,
                                              const GeglRectangle *rectangle);
 gboolean       gegl_processor_work          (GeglProcessor       *processor,
                                              gdouble             *progress);
+gboolean       gegl_processor_work_for      (GeglProcessor       *processor,
+                                             gint                 msecs,
+                                             gdouble             *progress);
+void           gegl_processor_set_focus     (GeglProcessor       *processor,
+                                             gint                 x,
+                                             gint                 y);
+void           gegl_processor_set_priority_func
+                                            (GeglProcessor             *processor,
+                                             GeglProcessorPriorityFunc  func,
+                                             gpointer                   user_data,
+                                             GDestroyNotify             destroy);
 G_END_DECLS
 
 #endif /* __GEGL_PROCESSOR_H__ */
@@ -0,0 +1,259 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-debug.h"
+#include "buffer/gegl-region.h"
+#include "graph/gegl-node.h"
+#include "gegl-result-cache.h"
+
+typedef struct
+{
+  gchar      *key;
+  GeglBuffer *buffer;
+  GeglRegion *valid;
+  guint64     bytes;
+  GList      *link;   /* in result_cache_lru */
+} GeglResultCacheEntry;
+
+static GHashTable   *result_cache       = NULL;
+static GQueue        result_cache_lru   = G_QUEUE_INIT; /* most recent first */
+static guint64       result_cache_bytes = 0;
+static GStaticMutex  result_cache_mutex = G_STATIC_MUTEX_INIT;
+
+static void
+result_cache_entry_free (GeglResultCacheEntry *entry)
+{
+  g_object_unref (entry->buffer);
+  gegl_region_destroy (entry->valid);
+  g_free (entry->key);
+  g_slice_free (GeglResultCacheEntry, entry);
+}
+
+static gchar *
+result_cache_key (const gchar *node_key,
+                  const gchar *pad_name,
+                  const Babl  *format,
+                  gint         level)
+{
+  return g_strdup_printf ("%s:%s:%s:%i", node_key, pad_name,
+                          format ? babl_get_name (format) : "", level);
+}
+
+/* the number of pixels in region */
+static guint64
+result_cache_region_area (GeglRegion *region)
+{
+  GeglRectangle *rectangles;
+  gint           n_rectangles;
+  gint           i;
+  guint64        area = 0;
+
+  gegl_region_get_rectangles (region, &rectangles, &n_rectangles);
+  for (i = 0; i < n_rectangles; i++)
+    area += (guint64) rectangles[i].width * rectangles[i].height;
+  g_free (rectangles);
+
+  return area;
+}
+
+/* drops the least recently used entries until the cache fits its budget,
+ * called with the mutex held
+ */
+static void
+result_cache_trim (guint64 budget)
+{
+  while (result_cache_bytes > budget && result_cache_lru.tail)
+    {
+      GeglResultCacheEntry *entry = result_cache_lru.tail->data;
+
+      GEGL_NOTE (GEGL_DEBUG_CACHE, "result cache dropping %s", entry->key);
+
+      g_queue_delete_link (&result_cache_lru, entry->link);
+      g_hash_table_remove (result_cache, entry->key);
+      result_cache_bytes -= entry->bytes;
+      result_cache_entry_free (entry);
+    }
+}
+
+gboolean
+gegl_result_cache_enabled (void)
+{
+  return gegl_config ()->result_cache_size > 0;
+}
+
+GeglBuffer *
+gegl_result_cache_lookup (const gchar         *node_key,
+                          const gchar         *pad_name,
+                          const Babl          *format,
+                          gint                 level,
+                          const GeglRectangle *rect)
+{
+  GeglResultCacheEntry *entry;
+  GeglBuffer           *buffer = NULL;
+  gchar                *key;
+
+  g_return_val_if_fail (node_key != NULL, NULL);
+  g_return_val_if_fail (rect != NULL, NULL);
+
+  key = result_cache_key (node_key, pad_name, format, level);
+
+  g_static_mutex_lock (&result_cache_mutex);
+  if (result_cache &&
+      (entry = g_hash_table_lookup (result_cache, key)) &&
+      gegl_region_rect_in (entry->valid, rect) == GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      g_queue_unlink (&result_cache_lru, entry->link);
+      g_queue_push_head_link (&result_cache_lru, entry->link);
+      buffer = g_object_ref (entry->buffer);
+    }
+  g_static_mutex_unlock (&result_cache_mutex);
+
+  g_free (key);
+  return buffer;
+}
+
+void
+gegl_result_cache_insert (const gchar         *node_key,
+                          const gchar         *pad_name,
+                          const Babl          *format,
+                          gint                 level,
+                          GeglBuffer          *buffer,
+                          const GeglRectangle *rect)
+{
+  GeglResultCacheEntry *entry;
+  GeglBuffer           *target;
+  guint64               budget = gegl_config ()->result_cache_size;
+  guint64               bytes;
+  gint                  bpp;
+  gchar                *key;
+
+  g_return_if_fail (node_key != NULL);
+  g_return_if_fail (GEGL_IS_BUFFER (buffer));
+  g_return_if_fail (rect != NULL);
+
+  if (budget == 0 || rect->width <= 0 || rect->height <= 0)
+    return;
+
+  if (!format)
+    format = gegl_buffer_get_format (buffer);
+
+  bpp   = babl_format_get_bytes_per_pixel (format);
+  bytes = (guint64) rect->width * rect->height * bpp;
+
+  /* a result that alone does not fit would evict everything else */
+  if (bytes > budget)
+    return;
+
+  key = result_cache_key (node_key, pad_name, format, level);
+
+  g_static_mutex_lock (&result_cache_mutex);
+  if (!result_cache)
+    result_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  entry = g_hash_table_lookup (result_cache, key);
+  if (entry && gegl_region_rect_in (entry->valid, rect) ==
+               GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      g_static_mutex_unlock (&result_cache_mutex);
+      g_free (key);
+      return;
+    }
+
+  if (!entry)
+    {
+      entry = g_slice_new0 (GeglResultCacheEntry);
+      entry->key    = g_strdup (key);
+      entry->buffer = gegl_buffer_new (rect, format);
+      entry->valid  = gegl_region_new ();
+      entry->link   = g_list_alloc ();
+      entry->link->data = entry;
+
+      /* consumers must not process in place on the shared buffer */
+      gegl_object_set_has_forked (entry->buffer);
+
+      g_hash_table_insert (result_cache, entry->key, entry);
+      g_queue_push_head_link (&result_cache_lru, entry->link);
+    }
+  else if (!gegl_rectangle_contains (gegl_buffer_get_extent (entry->buffer),
+                                     rect))
+    {
+      GeglBuffer    *grown;
+      GeglRectangle  extent;
+
+      /* consumers of earlier lookups may still be reading the buffer, it
+       * is replaced by a larger one instead of being resized. The copy
+       * shares the tiles of the old buffer.
+       */
+      gegl_rectangle_bounding_box (&extent,
+                                   gegl_buffer_get_extent (entry->buffer),
+                                   rect);
+      grown = gegl_buffer_new (&extent, format);
+      gegl_object_set_has_forked (grown);
+      gegl_buffer_copy (entry->buffer, NULL, grown, NULL);
+
+      g_object_unref (entry->buffer);
+      entry->buffer = grown;
+    }
+  target = g_object_ref (entry->buffer);
+  g_static_mutex_unlock (&result_cache_mutex);
+
+  /* the copy is done without holding the lock, the entry can be dropped
+   * meanwhile, in which case the copy is wasted but harmless
+   */
+  gegl_buffer_copy (buffer, rect, target, rect);
+
+  g_static_mutex_lock (&result_cache_mutex);
+  entry = g_hash_table_lookup (result_cache, key);
+  if (entry && entry->buffer == target &&
+      gegl_region_rect_in (entry->valid, rect) != GEGL_OVERLAP_RECTANGLE_IN)
+    {
+      GeglRegion *added = gegl_region_rectangle (rect);
+
+      /* only the part of rect that was not valid yet takes more memory */
+      gegl_region_subtract (added, entry->valid);
+      bytes = result_cache_region_area (added) * bpp;
+      gegl_region_destroy (added);
+
+      gegl_region_union_with_rect (entry->valid, rect);
+      entry->bytes       += bytes;
+      result_cache_bytes += bytes;
+      result_cache_trim (budget);
+    }
+  g_static_mutex_unlock (&result_cache_mutex);
+
+  g_object_unref (target);
+  g_free (key);
+}
+
+void
+gegl_result_cache_cleanup (void)
+{
+  g_static_mutex_lock (&result_cache_mutex);
+  if (result_cache)
+    {
+      result_cache_trim (0);
+      g_hash_table_destroy (result_cache);
+      result_cache = NULL;
+    }
+  g_static_mutex_unlock (&result_cache_mutex);
+}
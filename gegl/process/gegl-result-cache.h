@@ -0,0 +1,56 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_RESULT_CACHE_H__
+#define __GEGL_RESULT_CACHE_H__
+
+#include "gegl-types-internal.h"
+
+G_BEGIN_DECLS
+
+/* The result cache keeps rendered output of nodes for all the graphs in
+ * the process, keyed by what the output is computed from (see
+ * gegl_node_get_result_key()) rather than by node, so that identical
+ * subgraphs of graphs built independently share their results. It is
+ * bounded by the result-cache-size of GeglConfig, and disabled when that
+ * is 0.
+ */
+
+gboolean     gegl_result_cache_enabled (void);
+
+/* Returns a new reference to a buffer holding the output for rect, or NULL
+ * when not all of rect has been stored.
+ */
+GeglBuffer * gegl_result_cache_lookup  (const gchar         *node_key,
+                                        const gchar         *pad_name,
+                                        const Babl          *format,
+                                        gint                 level,
+                                        const GeglRectangle *rect);
+
+/* Stores the rect of buffer as the output of the pad. */
+void         gegl_result_cache_insert  (const gchar         *node_key,
+                                        const gchar         *pad_name,
+                                        const Babl          *format,
+                                        gint                 level,
+                                        GeglBuffer          *buffer,
+                                        const GeglRectangle *rect);
+
+/* Drops all the stored results. */
+void         gegl_result_cache_cleanup (void);
+
+G_END_DECLS
+
+#endif /* __GEGL_RESULT_CACHE_H__ */
@@ -0,0 +1,449 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib-object.h>
+#include <gio/gio.h>
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "gegl-config.h"
+#include "gegl-utils.h"
+#include "graph/gegl-node.h"
+#include "buffer/gegl-buffer-private.h"
+#include "gegl-scheduler.h"
+
+/* the units are grown until there are no more than this many of them for
+ * every worker, more units balance uneven work better, fewer units spend
+ * less time setting up the evaluation of every unit
+ */
+#define UNITS_PER_WORKER 8
+
+/* the units of a worker that are still to be done, the worker takes them
+ * from the front, thieves from the back
+ */
+typedef struct
+{
+  GMutex *mutex;
+  gint    head;
+  gint    tail;
+} GeglSchedulerQueue;
+
+typedef struct
+{
+  GFunc              help;
+
+  GeglSchedulerFunc  func;
+  gpointer           user_data;
+  GCancellable      *cancellable;
+
+  GeglRectangle     *units;
+  gint               n_units;
+  GeglSchedulerQueue queues[GEGL_MAX_THREADS];
+  gint               n_workers;
+  volatile gint      next_worker;
+
+  GMutex            *mutex;
+  GCond             *cond;
+  gint               done_units;
+  volatile gint      ref_count;
+} GeglSchedulerJob;
+
+typedef struct
+{
+  GFunc                  help;
+
+  GeglSchedulerTaskFunc  func;
+  gpointer               user_data;
+  GCancellable          *cancellable;
+
+  gpointer              *tasks;
+  gint                   n_tasks;
+  volatile gint          next_task;
+  gint                   worker;
+
+  GMutex                *mutex;
+  GCond                 *cond;
+  gint                   done_tasks;
+  volatile gint          ref_count;
+} GeglSchedulerTasks;
+
+static GThreadPool  *scheduler_pool       = NULL;
+static GStaticMutex  scheduler_pool_mutex = G_STATIC_MUTEX_INIT;
+
+/* one more than the index of the worker the current thread is, 0 outside
+ * of work units
+ */
+static GStaticPrivate current_worker = G_STATIC_PRIVATE_INIT;
+
+static void
+scheduler_job_unref (GeglSchedulerJob *job)
+{
+  gint i;
+
+  if (!g_atomic_int_dec_and_test (&job->ref_count))
+    return;
+
+  for (i = 0; i < job->n_workers; i++)
+    g_mutex_free (job->queues[i].mutex);
+  g_mutex_free (job->mutex);
+  g_cond_free (job->cond);
+  g_free (job->units);
+  if (job->cancellable)
+    g_object_unref (job->cancellable);
+  g_slice_free (GeglSchedulerJob, job);
+}
+
+static gboolean
+scheduler_job_take (GeglSchedulerJob *job,
+                    gint              worker,
+                    GeglRectangle    *unit)
+{
+  gint i;
+
+  for (i = 0; i < job->n_workers; i++)
+    {
+      GeglSchedulerQueue *queue = &job->queues[(worker + i) % job->n_workers];
+      gboolean            taken = FALSE;
+
+      g_mutex_lock (queue->mutex);
+      if (queue->head < queue->tail)
+        {
+          if (i == 0)
+            *unit = job->units[queue->head++];
+          else
+            *unit = job->units[--queue->tail];
+          taken = TRUE;
+        }
+      g_mutex_unlock (queue->mutex);
+
+      if (taken)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+scheduler_job_work (GeglSchedulerJob *job,
+                    gint              worker)
+{
+  GeglRectangle unit;
+  gboolean      was_worker;
+
+  g_static_private_set (&current_worker, GINT_TO_POINTER (worker + 1), NULL);
+  was_worker = gegl_buffer_thread_set_worker (TRUE);
+
+  while (scheduler_job_take (job, worker, &unit))
+    {
+      /* once cancelled the units left are only counted as done */
+      if (!g_cancellable_is_cancelled (job->cancellable))
+        job->func (&unit, worker, job->user_data);
+
+      g_mutex_lock (job->mutex);
+      job->done_units++;
+      if (job->done_units == job->n_units)
+        g_cond_signal (job->cond);
+      g_mutex_unlock (job->mutex);
+    }
+
+  gegl_buffer_thread_set_worker (was_worker);
+  g_static_private_set (&current_worker, NULL, NULL);
+}
+
+static void
+scheduler_job_help (gpointer data,
+                    gpointer unused)
+{
+  GeglSchedulerJob *job = data;
+  GCancellable     *previous;
+
+  /* the units check the cancellable of the thread that started the job */
+  previous = gegl_buffer_thread_set_cancellable (job->cancellable);
+
+  /* workers that start after all units have been taken find nothing to
+   * do, which is why the job is reference counted
+   */
+  scheduler_job_work (job, g_atomic_int_exchange_and_add (&job->next_worker, 1));
+
+  gegl_buffer_thread_set_cancellable (previous);
+
+  scheduler_job_unref (job);
+}
+
+static void
+scheduler_tasks_unref (GeglSchedulerTasks *tasks)
+{
+  if (!g_atomic_int_dec_and_test (&tasks->ref_count))
+    return;
+
+  g_mutex_free (tasks->mutex);
+  g_cond_free (tasks->cond);
+  if (tasks->cancellable)
+    g_object_unref (tasks->cancellable);
+  g_slice_free (GeglSchedulerTasks, tasks);
+}
+
+static void
+scheduler_tasks_work (GeglSchedulerTasks *tasks)
+{
+  gint task;
+
+  while ((task = g_atomic_int_exchange_and_add (&tasks->next_task, 1)) <
+         tasks->n_tasks)
+    {
+      if (!g_cancellable_is_cancelled (tasks->cancellable))
+        tasks->func (tasks->tasks[task], tasks->user_data);
+
+      g_mutex_lock (tasks->mutex);
+      tasks->done_tasks++;
+      if (tasks->done_tasks == tasks->n_tasks)
+        g_cond_signal (tasks->cond);
+      g_mutex_unlock (tasks->mutex);
+    }
+}
+
+static void
+scheduler_tasks_help (gpointer data,
+                      gpointer unused)
+{
+  GeglSchedulerTasks *tasks = data;
+  GCancellable       *previous;
+  gboolean            was_worker;
+
+  /* helpers act as the worker that started the tasks, the tasks do not
+   * share per thread state with each other
+   */
+  g_static_private_set (&current_worker,
+                        GINT_TO_POINTER (tasks->worker + 1), NULL);
+  was_worker = gegl_buffer_thread_set_worker (TRUE);
+  previous   = gegl_buffer_thread_set_cancellable (tasks->cancellable);
+  scheduler_tasks_work (tasks);
+  gegl_buffer_thread_set_cancellable (previous);
+  gegl_buffer_thread_set_worker (was_worker);
+  g_static_private_set (&current_worker, NULL, NULL);
+
+  scheduler_tasks_unref (tasks);
+}
+
+static void
+scheduler_pool_func (gpointer data,
+                     gpointer unused)
+{
+  GFunc help = *(GFunc *) data;
+
+  help (data, unused);
+}
+
+static void
+scheduler_pool_push (gpointer data,
+                     gint     n_helpers)
+{
+  gint i;
+
+  g_static_mutex_lock (&scheduler_pool_mutex);
+  if (!scheduler_pool)
+    scheduler_pool = g_thread_pool_new (scheduler_pool_func, NULL,
+                                        GEGL_MAX_THREADS - 1, FALSE, NULL);
+  for (i = 0; i < n_helpers; i++)
+    g_thread_pool_push (scheduler_pool, data, NULL);
+  g_static_mutex_unlock (&scheduler_pool_mutex);
+}
+
+static gint
+floor_div (gint a,
+           gint b)
+{
+  return a >= 0 ? a / b : - ((b - 1 - a) / b);
+}
+
+/* splits rect into units aligned to a grid of multiples of the tile size */
+static GeglRectangle *
+scheduler_split (const GeglRectangle *rect,
+                 gint                 n_workers,
+                 gint                *n_units)
+{
+  GeglRectangle *units;
+  gint           unit_width  = MAX (gegl_config ()->tile_width, 1);
+  gint           unit_height = MAX (gegl_config ()->tile_height, 1);
+  gint           col0, row0, cols, rows;
+  gint           col, row;
+  gint           n = 0;
+
+  while (TRUE)
+    {
+      col0 = floor_div (rect->x, unit_width);
+      row0 = floor_div (rect->y, unit_height);
+      cols = floor_div (rect->x + rect->width - 1, unit_width) - col0 + 1;
+      rows = floor_div (rect->y + rect->height - 1, unit_height) - row0 + 1;
+
+      if (cols * rows <= n_workers * UNITS_PER_WORKER)
+        break;
+
+      if (unit_width <= unit_height)
+        unit_width *= 2;
+      else
+        unit_height *= 2;
+    }
+
+  units = g_new (GeglRectangle, cols * rows);
+
+  for (row = 0; row < rows; row++)
+    for (col = 0; col < cols; col++)
+      {
+        GeglRectangle cell = { (col0 + col) * unit_width,
+                               (row0 + row) * unit_height,
+                               unit_width, unit_height };
+
+        gegl_rectangle_intersect (&units[n++], &cell, rect);
+      }
+
+  *n_units = n;
+  return units;
+}
+
+void
+gegl_scheduler_run (const GeglRectangle *rect,
+                    gint                 n_workers,
+                    GeglSchedulerFunc    func,
+                    gpointer             user_data)
+{
+  GeglSchedulerJob *job;
+  gint              worker;
+  gint              n_helpers;
+  gint              i;
+
+  g_return_if_fail (rect != NULL);
+  g_return_if_fail (func != NULL);
+
+  if (rect->width <= 0 || rect->height <= 0)
+    return;
+
+  if (g_cancellable_is_cancelled (gegl_buffer_thread_get_cancellable ()))
+    return;
+
+  n_workers = CLAMP (n_workers, 1, GEGL_MAX_THREADS);
+
+  /* nested in a work unit, the worker keeps its index as its per thread
+   * state is in use by the units it is already working on
+   */
+  worker = GPOINTER_TO_INT (g_static_private_get (&current_worker));
+  if (worker > 0 || n_workers == 1)
+    {
+      func (rect, MAX (worker - 1, 0), user_data);
+      return;
+    }
+
+  job = g_slice_new0 (GeglSchedulerJob);
+  job->help      = scheduler_job_help;
+  job->func      = func;
+  job->user_data = user_data;
+  job->units     = scheduler_split (rect, n_workers, &job->n_units);
+  job->n_workers = MIN (n_workers, job->n_units);
+
+  if (job->n_workers == 1)
+    {
+      g_free (job->units);
+      g_slice_free (GeglSchedulerJob, job);
+      func (rect, 0, user_data);
+      return;
+    }
+
+  /* every worker starts with a band of neighbouring units */
+  for (i = 0; i < job->n_workers; i++)
+    {
+      job->queues[i].mutex = g_mutex_new ();
+      job->queues[i].head  = job->n_units * i / job->n_workers;
+      job->queues[i].tail  = job->n_units * (i + 1) / job->n_workers;
+    }
+
+  job->mutex       = g_mutex_new ();
+  job->cond        = g_cond_new ();
+  job->next_worker = 1;
+
+  job->cancellable = gegl_buffer_thread_get_cancellable ();
+  if (job->cancellable)
+    g_object_ref (job->cancellable);
+
+  n_helpers      = job->n_workers - 1;
+  job->ref_count = n_helpers + 1;
+
+  scheduler_pool_push (job, n_helpers);
+
+  scheduler_job_work (job, 0);
+
+  g_mutex_lock (job->mutex);
+  while (job->done_units < job->n_units)
+    g_cond_wait (job->cond, job->mutex);
+  g_mutex_unlock (job->mutex);
+
+  scheduler_job_unref (job);
+}
+
+void
+gegl_scheduler_run_tasks (gpointer              *tasks,
+                          gint                   n_tasks,
+                          GeglSchedulerTaskFunc  func,
+                          gpointer               user_data)
+{
+  GeglSchedulerTasks *job;
+  gint                n_helpers;
+  gint                i;
+
+  g_return_if_fail (func != NULL);
+
+  if (n_tasks <= 1)
+    {
+      for (i = 0; i < n_tasks; i++)
+        func (tasks[i], user_data);
+      return;
+    }
+
+  job = g_slice_new0 (GeglSchedulerTasks);
+  job->help      = scheduler_tasks_help;
+  job->func      = func;
+  job->user_data = user_data;
+  job->tasks     = tasks;
+  job->n_tasks   = n_tasks;
+  job->worker    = MAX (GPOINTER_TO_INT (g_static_private_get (&current_worker)) - 1, 0);
+  job->mutex     = g_mutex_new ();
+  job->cond      = g_cond_new ();
+
+  /* the helpers and the caller take tasks until there are none left, so
+   * only the number of threads is limited
+   */
+  n_helpers      = MIN (n_tasks, GEGL_MAX_THREADS) - 1;
+  job->ref_count = n_helpers + 1;
+
+  job->cancellable = gegl_buffer_thread_get_cancellable ();
+  if (job->cancellable)
+    g_object_ref (job->cancellable);
+
+  scheduler_pool_push (job, n_helpers);
+
+  /* the caller takes tasks as well, tasks no helper got around to yet do
+   * not hold it up
+   */
+  scheduler_tasks_work (job);
+
+  g_mutex_lock (job->mutex);
+  while (job->done_tasks < job->n_tasks)
+    g_cond_wait (job->cond, job->mutex);
+  g_mutex_unlock (job->mutex);
+
+  scheduler_tasks_unref (job);
+}
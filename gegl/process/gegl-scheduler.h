@@ -0,0 +1,69 @@
+/* This file is part of GEGL
+ *
+ * GEGL is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * GEGL is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GEGL; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GEGL_SCHEDULER_H__
+#define __GEGL_SCHEDULER_H__
+
+#include <gio/gio.h>
+
+#include "gegl-types-internal.h"
+
+G_BEGIN_DECLS
+
+/* Renders one work unit of a request. worker is the index of the thread
+ * doing the work, from 0 to n_workers - 1, per thread state such as
+ * scratch buffers can be kept in arrays indexed by it.
+ */
+typedef void (*GeglSchedulerFunc) (const GeglRectangle *unit,
+                                   gint                 worker,
+                                   gpointer             user_data);
+
+/* Splits rect into tile aligned work units and calls func for all of them
+ * on n_workers threads, the calling thread being worker 0. Every worker
+ * starts on its own band of units, workers that run out of units steal
+ * them from the others. Returns when all the units are done.
+ *
+ * Called from within a work unit, the units are done by the calling
+ * thread alone.
+ *
+ * When the calling thread renders for a processor with a cancellable, see
+ * gegl_buffer_thread_get_cancellable(), it is current for the units on all
+ * the workers as well, and the units not yet started when it gets
+ * cancelled are skipped.
+ */
+void gegl_scheduler_run (const GeglRectangle *rect,
+                         gint                 n_workers,
+                         GeglSchedulerFunc    func,
+                         gpointer             user_data);
+
+/* Runs one task, as handed to gegl_scheduler_run_tasks(). */
+typedef void (*GeglSchedulerTaskFunc) (gpointer task,
+                                       gpointer user_data);
+
+/* Calls func for each of the n_tasks tasks, concurrently on up to
+ * GEGL_MAX_THREADS - 1 threads of the scheduler and the calling thread.
+ * Returns when all the tasks are done. The tasks run as the worker that
+ * calls this, so they must not use the same per worker state. The current
+ * cancellable is handed on as by gegl_scheduler_run().
+ */
+void gegl_scheduler_run_tasks (gpointer              *tasks,
+                               gint                   n_tasks,
+                               GeglSchedulerTaskFunc  func,
+                               gpointer               user_data);
+
+G_END_DECLS
+
+#endif /* __GEGL_SCHEDULER_H__ */
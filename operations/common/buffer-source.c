@@ -116,7 +116,24 @@ process (GeglOperation        *operation,
 {
   GeglChantO *o = GEGL_CHANT_PROPERTIES (operation);
 
-  if (o->buffer)
+  if (o->buffer && level > 0)
+    {
+      /* the buffer scaled down to the level, in its coordinates */
+      const Babl *format = gegl_buffer_get_format (o->buffer);
+      GeglBuffer *output = gegl_buffer_new (result, format);
+      guchar     *buf;
+
+      buf = g_malloc ((gsize) result->width * result->height *
+                      babl_format_get_bytes_per_pixel (format));
+      gegl_buffer_get (o->buffer, result, 1.0 / (1 << level), format, buf,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+      gegl_buffer_set (output, result, 0, format, buf, GEGL_AUTO_ROWSTRIDE);
+      g_free (buf);
+
+      gegl_operation_context_take_object (context, "output",
+                                          G_OBJECT (output));
+    }
+  else if (o->buffer)
     {
       g_object_ref (o->buffer); /* Add an extra reference, since
 				     * gegl_operation_set_data is
@@ -175,6 +192,7 @@ gegl_chant_class_init (GeglChantClass *klass)
       "name",       "gegl:buffer-source",
       "categories", "programming:input",
       "description", _("A source that uses an in-memory GeglBuffer, for use internally by GEGL."),
+      "level-aware", "true",
       NULL);
 
   operation_class->no_cache = TRUE;
@@ -126,17 +126,73 @@ process (GeglOperation       *operation,
   return  TRUE;
 }
 
+static gint
+floor_div (gint a,
+           gint b)
+{
+  return a >= 0 ? a / b : - ((b - 1 - a) / b);
+}
+
+/* cells of at least a tile are filled a cell at a time, the tiles they
+ * cover completely share the data of a single uniform tile, smaller cells
+ * are rendered pixel by pixel
+ */
+static gboolean
+fill (GeglOperation       *operation,
+      GeglBuffer          *output,
+      const GeglRectangle *result,
+      gint                 level)
+{
+  GeglChantO *o = GEGL_CHANT_PROPERTIES (operation);
+  gint        tile_width, tile_height;
+  gint        col0, row0, col1, row1;
+  gint        col, row;
+
+  g_object_get (output,
+                "tile-width",  &tile_width,
+                "tile-height", &tile_height,
+                NULL);
+
+  if (o->x < tile_width || o->y < tile_height)
+    return GEGL_OPERATION_SOURCE_CLASS (gegl_chant_parent_class)->process (operation,
+                                                                          output,
+                                                                          result,
+                                                                          level);
+
+  col0 = floor_div (result->x - o->x_offset, o->x);
+  row0 = floor_div (result->y - o->y_offset, o->y);
+  col1 = floor_div (result->x + result->width - 1 - o->x_offset, o->x);
+  row1 = floor_div (result->y + result->height - 1 - o->y_offset, o->y);
+
+  for (row = row0; row <= row1; row++)
+    for (col = col0; col <= col1; col++)
+      {
+        GeglRectangle cell = { o->x_offset + col * o->x,
+                               o->y_offset + row * o->y,
+                               o->x, o->y };
+
+        gegl_rectangle_intersect (&cell, &cell, result);
+        gegl_buffer_set_color (output, &cell,
+                               (col + row) % 2 == 0 ? o->color1 : o->color2);
+      }
+
+  return TRUE;
+}
+
 
 static void
 gegl_chant_class_init (GeglChantClass *klass)
 {
   GeglOperationClass            *operation_class;
+  GeglOperationSourceClass      *source_class;
   GeglOperationPointRenderClass *point_render_class;
 
   operation_class = GEGL_OPERATION_CLASS (klass);
+  source_class = GEGL_OPERATION_SOURCE_CLASS (klass);
   point_render_class = GEGL_OPERATION_POINT_RENDER_CLASS (klass);
 
   point_render_class->process = process;
+  source_class->process = fill;
   operation_class->get_bounding_box = get_bounding_box;
   operation_class->prepare = prepare;
 
@@ -67,17 +67,36 @@ gegl_color_op_process (GeglOperation       *operation,
   return  TRUE;
 }
 
+/* fills the whole result at once, tiles it covers completely share the
+ * data of a single uniform tile
+ */
+static gboolean
+gegl_color_op_fill (GeglOperation       *operation,
+                    GeglBuffer          *output,
+                    const GeglRectangle *result,
+                    gint                 level)
+{
+  GeglChantO *o = GEGL_CHANT_PROPERTIES (operation);
+
+  gegl_buffer_set_color (output, result, o->value);
+
+  return TRUE;
+}
+
 
 static void
 gegl_chant_class_init (GeglChantClass *klass)
 {
   GeglOperationClass            *operation_class;
+  GeglOperationSourceClass      *source_class;
   GeglOperationPointRenderClass *point_render_class;
 
   operation_class    = GEGL_OPERATION_CLASS (klass);
+  source_class       = GEGL_OPERATION_SOURCE_CLASS (klass);
   point_render_class = GEGL_OPERATION_POINT_RENDER_CLASS (klass);
 
   point_render_class->process       = gegl_color_op_process;
+  source_class->process             = gegl_color_op_fill;
   operation_class->get_bounding_box = gegl_color_op_get_bounding_box;
   operation_class->prepare          = gegl_color_op_prepare;
 
@@ -51,6 +51,7 @@ gegl_chant_double (noise, _("Noise"),
 
 #include "gegl-chant.h"
 #include "gegl-debug.h"
+#include "gegl-buffer-private.h"
 #include <stdlib.h>
 
 static const gchar *OUTPUT_FORMAT   = "RGB float";
@@ -637,6 +638,10 @@ linbcg (guint   rows,
 
   while (*iter <= itmax)
     {
+      /* the result is of no use once the render has been cancelled */
+      if (g_cancellable_is_cancelled (gegl_buffer_thread_get_cancellable ()))
+        break;
+
       ++(*iter);
 
       zm1nrm = znrm;
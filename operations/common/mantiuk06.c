@@ -45,6 +45,7 @@ gegl_chant_double (detail, _("Detail"),
 #define GEGL_CHANT_C_FILE       "mantiuk06.c"
 
 #include "gegl-chant.h"
+#include "gegl-buffer-private.h"
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -1574,6 +1575,16 @@ mantiuk06_get_cached_region (GeglOperation        *operation,
 }
 
 
+/* stops the solver when the render it is part of has been cancelled */
+static int
+mantiuk06_progress (int progress)
+{
+  if (g_cancellable_is_cancelled (gegl_buffer_thread_get_cancellable ()))
+    return PFSTMO_CB_ABORT;
+
+  return PFSTMO_CB_CONTINUE;
+}
+
 static gboolean
 mantiuk06_process (GeglOperation       *operation,
                    GeglBuffer          *input,
@@ -1603,7 +1614,8 @@ mantiuk06_process (GeglOperation       *operation,
                    pix, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
 
   mantiuk06_contmap (result->width, result->height, pix, lum,
-                     o->contrast, o->saturation, FALSE, 200, 1e-3, NULL);
+                     o->contrast, o->saturation, FALSE, 200, 1e-3,
+                     mantiuk06_progress);
 
   /* Cleanup and set the output */
   gegl_buffer_set (output, result, 0, babl_format (OUTPUT_FORMAT), pix,
@@ -31,6 +31,9 @@ gegl_chant_enum (sampler_type, _("Sampler"), GeglSamplerType, gegl_sampler_type,
 #include <glib/gi18n-lib.h>
 #include "gegl-chant.h"
 
+/* number of consecutive sampled pixels handed to the sampler at once */
+#define MAX_RUN 64
+
 
 static void
 prepare (GeglOperation *operation)
@@ -88,12 +91,22 @@ process (GeglOperation       *operation,
           gfloat     *in = it->data[index_in];
           gfloat     *out = it->data[index_out];
           gfloat     *coords = it->data[index_coords];
+          gdouble     run_coords[MAX_RUN * 2];
+          gfloat     *run_out = out;
+          gint        run_length = 0;
 
           for (i=0; i<n_pixels; i++)
             {
               /* if the coordinate asked is an exact pixel, we fetch it directly, to avoid the blur of sampling */
               if (coords[0] == x && coords[1] == y)
                 {
+                  if (run_length)
+                    {
+                      gegl_sampler_get_points (sampler, run_coords, NULL,
+                                               run_length, run_out);
+                      run_length = 0;
+                    }
+
                   out[0] = in[0];
                   out[1] = in[1];
                   out[2] = in[2];
@@ -101,7 +114,18 @@ process (GeglOperation       *operation,
                 }
               else
                 {
-                  gegl_sampler_get (sampler, coords[0], coords[1], NULL, out);
+                  if (run_length == 0)
+                    run_out = out;
+
+                  run_coords[run_length * 2]     = coords[0];
+                  run_coords[run_length * 2 + 1] = coords[1];
+
+                  if (++run_length == MAX_RUN)
+                    {
+                      gegl_sampler_get_points (sampler, run_coords, NULL,
+                                               run_length, run_out);
+                      run_length = 0;
+                    }
                 }
 
               coords += 2;
@@ -117,6 +141,10 @@ process (GeglOperation       *operation,
                 }
 
             }
+
+          if (run_length)
+            gegl_sampler_get_points (sampler, run_coords, NULL,
+                                     run_length, run_out);
         }
     }
   else
@@ -35,6 +35,9 @@ gegl_chant_enum (sampler_type, _("Sampler"), GeglSamplerType, gegl_sampler_type,
 #include <glib/gi18n-lib.h>
 #include "gegl-chant.h"
 
+/* number of consecutive sampled pixels handed to the sampler at once */
+#define MAX_RUN 64
+
 
 static void
 prepare (GeglOperation *operation)
@@ -93,6 +96,9 @@ process (GeglOperation       *operation,
           gfloat     *in = it->data[index_in];
           gfloat     *out = it->data[index_out];
           gfloat     *coords = it->data[index_coords];
+          gdouble     run_coords[MAX_RUN * 2];
+          gfloat     *run_out = out;
+          gint        run_length = 0;
 
           for (i=0; i<n_pixels; i++)
             {
@@ -100,6 +106,13 @@ process (GeglOperation       *operation,
                * directly, to avoid the blur of sampling */
               if (coords[0] == 0 && coords[1] == 0)
                 {
+                  if (run_length)
+                    {
+                      gegl_sampler_get_points (sampler, run_coords, NULL,
+                                               run_length, run_out);
+                      run_length = 0;
+                    }
+
                   out[0] = in[0];
                   out[1] = in[1];
                   out[2] = in[2];
@@ -107,9 +120,18 @@ process (GeglOperation       *operation,
                 }
               else
                 {
-                  gegl_sampler_get (sampler, x+coords[0] * scaling,
-                                             y+coords[1] * scaling,
-                                             NULL, out);
+                  if (run_length == 0)
+                    run_out = out;
+
+                  run_coords[run_length * 2]     = x + coords[0] * scaling;
+                  run_coords[run_length * 2 + 1] = y + coords[1] * scaling;
+
+                  if (++run_length == MAX_RUN)
+                    {
+                      gegl_sampler_get_points (sampler, run_coords, NULL,
+                                               run_length, run_out);
+                      run_length = 0;
+                    }
                 }
 
               coords += 2;
@@ -125,6 +147,10 @@ process (GeglOperation       *operation,
                 }
 
             }
+
+          if (run_length)
+            gegl_sampler_get_points (sampler, run_coords, NULL,
+                                     run_length, run_out);
         }
     }
   else
@@ -53,7 +53,20 @@ process (GeglOperation       *op,
   gfloat *aux = aux_buf;
   gfloat value = GEGL_CHANT_PROPERTIES (op)->value;
 
-  if (aux == NULL)
+  if (gegl_operation_get_format (op, "input") == babl_format ("RGBA float"))
+    {
+      /* negotiated to non premultiplied data, only alpha changes */
+      while (samples--)
+        {
+          out[0] = in[0];
+          out[1] = in[1];
+          out[2] = in[2];
+          out[3] = in[3] * value * (aux ? *aux++ : 1.0f);
+          in  += 4;
+          out += 4;
+        }
+    }
+  else if (aux == NULL)
     {
       g_assert (value != 1.0); /* buffer should have been passed through */
       while (samples--)
@@ -153,6 +166,7 @@ gegl_chant_class_init (GeglChantClass *klass)
           _("Weights the opacity of the input both the value of the aux"
             " input and the global value property."),
     "cl-source"  , kernel_source,
+    "input-formats", "RGBA float",
     NULL);
 }
 
@@ -97,6 +97,7 @@ process (GeglOperation       *operation,
                                                   o->sampler_type);
 
   gint n_pixels = result->width * result->height;
+  gdouble *row_coords = g_new (gdouble, result->width * 2);
 
   while (n_pixels--)
     {
@@ -125,18 +126,17 @@ process (GeglOperation       *operation,
       coordsx = x + shift * sin (angle_rad);
       coordsy = y + shift * cos (angle_rad);
 
-      gegl_sampler_get (sampler,
-                        coordsx,
-                        coordsy,
-                        NULL,
-                        out_pixel);
-
-      out_pixel += 4;
+      row_coords[(x - result->x) * 2]     = coordsx;
+      row_coords[(x - result->x) * 2 + 1] = coordsy;
 
       /* update x and y coordinates */
       x++;
       if (x>=result->x + result->width)
         {
+          gegl_sampler_get_points (sampler, row_coords, NULL, result->width,
+                                   out_pixel);
+          out_pixel += result->width * 4;
+
           x=result->x;
           y++;
         }
@@ -145,6 +145,7 @@ process (GeglOperation       *operation,
   gegl_buffer_set (output, result, 0, babl_format ("RGBA float"), dst_buf, GEGL_AUTO_ROWSTRIDE);
   g_slice_free1 (result->width * result->height * 4 * sizeof(gfloat), dst_buf);
 
+  g_free (row_coords);
   g_object_unref (sampler);
 
   return  TRUE;
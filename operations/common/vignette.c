@@ -383,6 +383,7 @@ gegl_chant_class_init (GeglChantClass *klass)
   gegl_operation_class_set_keys (operation_class,
   "name"       , "gegl:vignette",
   "categories" , "render",
+  "position-dependent", "true",
   "description", _("A vignetting op, applies a vignette to an image. Simulates the luminance fall off at edge of exposed film, and some other fuzzier border effects that can naturally occur with analoge photograpy."),
   NULL);
 }
@@ -111,6 +111,7 @@ gegl_chant_class_init (GeglChantClass *klass)
        "name",          "gegl:clone",
        "description",   _("Clone a buffer"),
        "categories",    "core",
+       "level-aware",   "true",
        NULL);
 }
 
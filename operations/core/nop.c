@@ -70,6 +70,7 @@ gegl_chant_class_init (GeglChantClass *klass)
               "name",        "gegl:nop",
               "categories",  "core",
               "description", _("No operation (can be used as a routing point)"),
+              "level-aware", "true",
               NULL);
 }
 
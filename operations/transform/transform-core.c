@@ -89,6 +89,11 @@ static gboolean      gegl_matrix3_is_affine                        (GeglMatrix3
 static gboolean      gegl_affine_matrix3_allow_fast_translate      (GeglMatrix3 *matrix);
 static gboolean      gegl_affine_matrix3_allow_fast_reflect_x      (GeglMatrix3 *matrix);
 static gboolean      gegl_affine_matrix3_allow_fast_reflect_y      (GeglMatrix3 *matrix);
+static gint          gegl_affine_matrix3_get_quarter_turns         (GeglMatrix3 *matrix);
+static gint          gegl_affine_shift                             (gdouble      translation);
+static void          gegl_affine_fast_transform_rect               (GeglMatrix3         *matrix,
+                                                                    const GeglRectangle *rect,
+                                                                    GeglRectangle       *output);
 
 static void          gegl_affine_fast_reflect_x            (GeglBuffer           *dest,
                                                             GeglBuffer           *src,
@@ -100,6 +105,11 @@ static void          gegl_affine_fast_reflect_y            (GeglBuffer
                                                             const GeglRectangle  *dest_rect,
                                                             const GeglRectangle  *src_rect,
                                                             gint                  level);
+static void          gegl_affine_fast_rotate               (GeglBuffer           *dest,
+                                                            GeglBuffer           *src,
+                                                            const GeglRectangle  *dest_rect,
+                                                            GeglMatrix3          *matrix,
+                                                            gint                  level);
 
 
 /* ************************* */
@@ -403,6 +413,13 @@ gegl_affine_is_intermediate_node (OpTransform *affine)
   return TRUE;
 }
 
+/*
+ * A transform is composite when its source is a transform that passes its
+ * input straight through, the matrices of such chains of transforms are
+ * multiplied together and the image is resampled only once, by the last
+ * transform of the chain. A source that also feeds other operations has
+ * to resample by itself, and the chain stops there.
+ */
 static gboolean
 gegl_affine_is_composite_node (OpTransform *affine)
 {
@@ -418,7 +435,8 @@ gegl_affine_is_composite_node (OpTransform *affine)
   source = gegl_connection_get_source_node (connections->data)->operation;
 
   return (IS_OP_AFFINE (source) &&
-          ! strcmp (affine->filter, OP_AFFINE (source)->filter));
+          ! strcmp (affine->filter, OP_AFFINE (source)->filter) &&
+          gegl_affine_is_intermediate_node (OP_AFFINE (source)));
 }
 
 static void
@@ -469,14 +487,18 @@ gegl_affine_get_bounding_box (GeglOperation *op)
       return in_rect;
     }
 
-  if (!gegl_affine_matrix3_allow_fast_translate (&matrix))
+  if (gegl_affine_matrix3_allow_fast_translate (&matrix) ||
+      gegl_affine_matrix3_get_quarter_turns (&matrix))
     {
-      in_rect.x      += context_rect.x;
-      in_rect.y      += context_rect.y;
-      in_rect.width  += context_rect.width;
-      in_rect.height += context_rect.height;
+      gegl_affine_fast_transform_rect (&matrix, &in_rect, &have_rect);
+      return have_rect;
     }
 
+  in_rect.x      += context_rect.x;
+  in_rect.y      += context_rect.y;
+  in_rect.width  += context_rect.width;
+  in_rect.height += context_rect.height;
+
   have_points [0] = in_rect.x;
   have_points [1] = in_rect.y;
 
@@ -508,6 +530,8 @@ gegl_affine_detect (GeglOperation *operation,
   gdouble      need_points [2];
   gint         i;
 
+  gegl_affine_create_composite_matrix (affine, &inverse);
+
   if (gegl_affine_is_intermediate_node (affine) ||
       gegl_matrix3_is_identity (&inverse))
     {
@@ -517,7 +541,6 @@ gegl_affine_detect (GeglOperation *operation,
   need_points [0] = x;
   need_points [1] = y;
 
-  gegl_affine_create_matrix (affine, &inverse);
   gegl_matrix3_invert (&inverse);
 
   for (i = 0; i < 2; i += 2)
@@ -557,6 +580,13 @@ gegl_affine_get_required_for_output (GeglOperation       *op,
       return requested_rect;
     }
 
+  if (gegl_affine_matrix3_allow_fast_translate (&inverse) ||
+      gegl_affine_matrix3_get_quarter_turns (&inverse))
+    {
+      gegl_affine_fast_transform_rect (&inverse, &requested_rect, &need_rect);
+      return need_rect;
+    }
+
   need_points [0] = requested_rect.x;
   need_points [1] = requested_rect.y;
 
@@ -600,18 +630,7 @@ gegl_affine_get_invalidated_by_change (GeglOperation       *op,
   context_rect = *gegl_sampler_get_context_rect (sampler);
   g_object_unref (sampler);
 
-  gegl_affine_create_matrix (affine, &matrix);
-
-  if (affine->origin_x || affine->origin_y)
-    gegl_matrix3_originate (&matrix, affine->origin_x, affine->origin_y);
-
-  if (gegl_affine_is_composite_node (affine))
-    {
-      GeglMatrix3 source;
-
-      gegl_affine_get_source_matrix (affine, &source);
-      gegl_matrix3_multiply (&matrix, &source, &matrix);
-    }
+  gegl_affine_create_composite_matrix (affine, &matrix);
 
   if (gegl_affine_is_intermediate_node (affine) ||
       gegl_matrix3_is_identity (&matrix))
@@ -619,6 +638,13 @@ gegl_affine_get_invalidated_by_change (GeglOperation       *op,
       return region;
     }
 
+  if (gegl_affine_matrix3_allow_fast_translate (&matrix) ||
+      gegl_affine_matrix3_get_quarter_turns (&matrix))
+    {
+      gegl_affine_fast_transform_rect (&matrix, &region, &affected_rect);
+      return affected_rect;
+    }
+
   region.x      += context_rect.x;
   region.y      += context_rect.y;
   region.width  += context_rect.width;
@@ -653,17 +679,14 @@ affine_affine (GeglBuffer  *dest,
 {
   GeglBufferIterator *i;
   const GeglRectangle *dest_extent;
-  gint                  x, y;
+  gint                  y;
   gfloat * restrict     dest_buf,
                        *dest_ptr;
   GeglMatrix3           inverse;
   GeglMatrix2           inverse_jacobian;
   gdouble               u_start,
                         v_start,
-                        w_start,
-                        u_float,
-                        v_float,
-                        w_float;
+                        w_start;
 
   const Babl           *format;
 
@@ -704,18 +727,13 @@ affine_affine (GeglBuffer  *dest,
 
       for (dest_ptr = dest_buf, y = roi->height; y--;)
         {
-          u_float = u_start;
-          v_float = v_start;
-          w_float = w_start;
-
-          for (x = roi->width; x--;)
-            {
-              gegl_sampler_get (sampler, u_float/w_float, v_float/w_float, &inverse_jacobian, dest_ptr);
-              dest_ptr+=4;
-              u_float += inverse.coeff [0][0];
-              v_float += inverse.coeff [1][0];
-              w_float += inverse.coeff [2][0];
-            }
+          gegl_sampler_get_span (sampler,
+                                 u_start, v_start, w_start,
+                                 inverse.coeff [0][0],
+                                 inverse.coeff [1][0],
+                                 inverse.coeff [2][0],
+                                 roi->width, &inverse_jacobian, dest_ptr);
+          dest_ptr += roi->width * 4;
 
           u_start += inverse.coeff [0][1];
           v_start += inverse.coeff [1][1];
@@ -737,6 +755,8 @@ affine_generic (GeglBuffer  *dest,
   gfloat * restrict     dest_buf,
                        *dest_ptr;
   GeglMatrix3           inverse;
+  gdouble              *coords;
+  GeglMatrix2          *inverse_jacobians;
   gdouble               u_start,
                         v_start,
                         w_start,
@@ -757,6 +777,9 @@ affine_generic (GeglBuffer  *dest,
   g_object_get (dest, "pixels", &dest_pixels, NULL);
   dest_extent = gegl_buffer_get_extent (dest);
 
+  /* the coordinates and scales of one row, sampled in one go */
+  coords            = g_new (gdouble, dest_extent->width * 2);
+  inverse_jacobians = g_new (GeglMatrix2, dest_extent->width);
 
   i = gegl_buffer_iterator_new (dest, dest_extent, level, format, GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
   while (gegl_buffer_iterator_next (i))
@@ -782,31 +805,38 @@ affine_generic (GeglBuffer  *dest,
           v_float = v_start;
           w_float = w_start;
 
-          for (x = roi->width; x--;)
+          for (x = 0; x < roi->width; x++)
             {
-              GeglMatrix2 inverse_jacobian;
+              GeglMatrix2 *inverse_jacobian = &inverse_jacobians[x];
               gdouble w_recip = 1.0 / w_float;
               gdouble u = u_float * w_recip;
               gdouble v = v_float * w_recip;
 
-              inverse_jacobian.coeff[0][0] = (inverse.coeff[0][0] - inverse.coeff[2][0] * u) * w_recip;
-              inverse_jacobian.coeff[0][1] = (inverse.coeff[0][1] - inverse.coeff[2][1] * u) * w_recip;
-              inverse_jacobian.coeff[1][0] = (inverse.coeff[1][0] - inverse.coeff[2][0] * v) * w_recip;
-              inverse_jacobian.coeff[1][1] = (inverse.coeff[1][1] - inverse.coeff[2][1] * v) * w_recip;
+              inverse_jacobian->coeff[0][0] = (inverse.coeff[0][0] - inverse.coeff[2][0] * u) * w_recip;
+              inverse_jacobian->coeff[0][1] = (inverse.coeff[0][1] - inverse.coeff[2][1] * u) * w_recip;
+              inverse_jacobian->coeff[1][0] = (inverse.coeff[1][0] - inverse.coeff[2][0] * v) * w_recip;
+              inverse_jacobian->coeff[1][1] = (inverse.coeff[1][1] - inverse.coeff[2][1] * v) * w_recip;
 
-              gegl_sampler_get (sampler, u, v, &inverse_jacobian, dest_ptr);
-              dest_ptr+=4;
+              coords[x * 2]     = u;
+              coords[x * 2 + 1] = v;
 
               u_float += inverse.coeff [0][0];
               v_float += inverse.coeff [1][0];
               w_float += inverse.coeff [2][0];
             }
 
+          gegl_sampler_get_points (sampler, coords, inverse_jacobians,
+                                   roi->width, dest_ptr);
+          dest_ptr += roi->width * 4;
+
           u_start += inverse.coeff [0][1];
           v_start += inverse.coeff [1][1];
           w_start += inverse.coeff [2][1];
         }
     }
+
+  g_free (coords);
+  g_free (inverse_jacobians);
 }
 
 static inline gboolean is_zero (float f)
@@ -828,12 +858,105 @@ static gboolean gegl_matrix3_is_affine (GeglMatrix3 *matrix)
 static gboolean
 gegl_affine_matrix3_allow_fast_translate (GeglMatrix3 *matrix)
 {
-  if (! GEGL_FLOAT_EQUAL (matrix->coeff[0][2], (gint) matrix->coeff[0][2]) ||
-      ! GEGL_FLOAT_EQUAL (matrix->coeff[1][2], (gint) matrix->coeff[1][2]))
+  if (! GEGL_FLOAT_EQUAL (matrix->coeff[0][2], floor (matrix->coeff[0][2] + 0.5)) ||
+      ! GEGL_FLOAT_EQUAL (matrix->coeff[1][2], floor (matrix->coeff[1][2] + 0.5)))
     return FALSE;
   return gegl_matrix3_is_translate (matrix);
 }
 
+/*
+ * Returns the number of quarter turns, 1 to 3, of a rotation by a multiple
+ * of 90 degrees followed by an integer translation, such a matrix maps
+ * pixels onto pixels. Returns 0 for all other matrices.
+ */
+static gint
+gegl_affine_matrix3_get_quarter_turns (GeglMatrix3 *matrix)
+{
+  static const gdouble rotations[4][2][2] = {{{ 1,  0}, { 0,  1}},
+                                             {{ 0,  1}, {-1,  0}},
+                                             {{-1,  0}, { 0, -1}},
+                                             {{ 0, -1}, { 1,  0}}};
+  gint turns;
+
+  if (! gegl_matrix3_is_affine (matrix) ||
+      ! GEGL_FLOAT_EQUAL (matrix->coeff[0][2], floor (matrix->coeff[0][2] + 0.5)) ||
+      ! GEGL_FLOAT_EQUAL (matrix->coeff[1][2], floor (matrix->coeff[1][2] + 0.5)))
+    return 0;
+
+  for (turns = 1; turns < 4; turns++)
+    if (GEGL_FLOAT_EQUAL (matrix->coeff[0][0], rotations[turns][0][0]) &&
+        GEGL_FLOAT_EQUAL (matrix->coeff[0][1], rotations[turns][0][1]) &&
+        GEGL_FLOAT_EQUAL (matrix->coeff[1][0], rotations[turns][1][0]) &&
+        GEGL_FLOAT_EQUAL (matrix->coeff[1][1], rotations[turns][1][1]))
+      return turns;
+
+  return 0;
+}
+
+/*
+ * The buffer shift equivalent to a translation, exact for integer
+ * translations and the choice of the nearest sampler for others.
+ */
+static gint
+gegl_affine_shift (gdouble translation)
+{
+  return (gint) floor (-translation + GEGL_FLOAT_EPSILON);
+}
+
+/*
+ * Maps the pixels of rect through a matrix that maps pixels onto pixels,
+ * without the context needed by resampling. Pixel centres are mapped, the
+ * pixel a centre lands in is the mapped pixel, mapping the pixel indices
+ * themselves is off by one along mirrored axes.
+ */
+static void
+gegl_affine_fast_transform_rect (GeglMatrix3         *matrix,
+                                 const GeglRectangle *rect,
+                                 GeglRectangle       *output)
+{
+  gdouble points [8];
+  gint    min_x, min_y;
+  gint    max_x, max_y;
+  gint    i;
+
+  if (rect->width <= 0 || rect->height <= 0)
+    {
+      output->x = output->y = output->width = output->height = 0;
+      return;
+    }
+
+  points [0] = rect->x + 0.5;
+  points [1] = rect->y + 0.5;
+  points [2] = rect->x + rect->width - 0.5;
+  points [3] = rect->y + 0.5;
+  points [4] = rect->x + rect->width - 0.5;
+  points [5] = rect->y + rect->height - 0.5;
+  points [6] = rect->x + 0.5;
+  points [7] = rect->y + rect->height - 0.5;
+
+  min_x = min_y = G_MAXINT;
+  max_x = max_y = G_MININT;
+
+  for (i = 0; i < 8; i += 2)
+    {
+      gint x, y;
+
+      gegl_matrix3_transform_point (matrix, points + i, points + i + 1);
+      x = floor (points [i]);
+      y = floor (points [i + 1]);
+
+      min_x = MIN (min_x, x);
+      min_y = MIN (min_y, y);
+      max_x = MAX (max_x, x);
+      max_y = MAX (max_y, y);
+    }
+
+  output->x      = min_x;
+  output->y      = min_y;
+  output->width  = max_x - min_x + 1;
+  output->height = max_y - min_y + 1;
+}
+
 static gboolean
 gegl_affine_matrix3_allow_fast_reflect_x (GeglMatrix3 *matrix)
 {
@@ -941,6 +1064,104 @@ gegl_affine_fast_reflect_y (GeglBuffer              *dest,
   g_free (buf);
 }
 
+/* one pixel of the RaGaBaA float format the transforms work in, copied
+ * as a whole
+ */
+typedef struct
+{
+  gfloat channels[4];
+} OpTransformPixel;
+
+/* side of the square blocks the pixels are moved in, to keep both the
+ * source rows and columns being read in cache
+ */
+#define FAST_ROTATE_BLOCK 16
+
+static void
+gegl_affine_fast_rotate (GeglBuffer          *dest,
+                         GeglBuffer          *src,
+                         const GeglRectangle *dest_rect,
+                         GeglMatrix3         *matrix,
+                         gint                 level)
+{
+  const Babl         *format = babl_format ("RaGaBaA float");
+  GeglBufferIterator *i;
+  GeglMatrix3         inverse;
+  OpTransformPixel   *src_buf = NULL;
+  gint                src_buf_size = 0;
+  gint                du_dx, du_dy, dv_dx, dv_dy;
+  gint                u_0, v_0;
+  gdouble             u_centre = 0.5,
+                      v_centre = 0.5;
+
+  gegl_matrix3_copy_into (&inverse, matrix);
+  gegl_matrix3_invert (&inverse);
+
+  /* the inverse of a quarter turn has an integer linear part */
+  du_dx = floor (inverse.coeff[0][0] + 0.5);
+  du_dy = floor (inverse.coeff[0][1] + 0.5);
+  dv_dx = floor (inverse.coeff[1][0] + 0.5);
+  dv_dy = floor (inverse.coeff[1][1] + 0.5);
+
+  /* the source pixel of destination pixel (x, y) is the one the centre
+   * (x + 0.5, y + 0.5) maps into, (u_0, v_0) is the one of pixel (0, 0)
+   */
+  gegl_matrix3_transform_point (&inverse, &u_centre, &v_centre);
+  u_0 = floor (u_centre);
+  v_0 = floor (v_centre);
+
+  i = gegl_buffer_iterator_new (dest, dest_rect, level, format, GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (i))
+    {
+      GeglRectangle    *roi      = &i->roi[0];
+      OpTransformPixel *dest_buf = i->data[0];
+      GeglRectangle     src_rect;
+      gint              step;
+      gint              bx, by;
+
+      gegl_affine_fast_transform_rect (&inverse, roi, &src_rect);
+
+      if (src_rect.width * src_rect.height > src_buf_size)
+        {
+          src_buf_size = src_rect.width * src_rect.height;
+          g_free (src_buf);
+          src_buf = g_new (OpTransformPixel, src_buf_size);
+        }
+
+      gegl_buffer_get (src, &src_rect, 1.0, format, src_buf,
+                       GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+      /* distance in the source of two horizontally adjacent destination
+       * pixels
+       */
+      step = du_dx + dv_dx * src_rect.width;
+
+      for (by = 0; by < roi->height; by += FAST_ROTATE_BLOCK)
+        for (bx = 0; bx < roi->width; bx += FAST_ROTATE_BLOCK)
+          {
+            const gint bw = MIN (FAST_ROTATE_BLOCK, roi->width  - bx);
+            const gint bh = MIN (FAST_ROTATE_BLOCK, roi->height - by);
+            gint       y;
+
+            for (y = by; y < by + bh; y++)
+              {
+                const gint x = roi->x + bx;
+                const gint u = du_dx * x + du_dy * (roi->y + y) + u_0;
+                const gint v = dv_dx * x + dv_dy * (roi->y + y) + v_0;
+                const OpTransformPixel *s =
+                  src_buf + (u - src_rect.x) + (v - src_rect.y) * src_rect.width;
+                OpTransformPixel       *d = dest_buf + y * roi->width + bx;
+                gint                    n;
+
+                for (n = bw; n--; s += step)
+                  *d++ = *s;
+              }
+          }
+    }
+
+  g_free (src_buf);
+}
+
 static gboolean
 gegl_affine_process (GeglOperation        *operation,
                      GeglOperationContext *context,
@@ -977,8 +1198,8 @@ gegl_affine_process (GeglOperation        *operation,
 
       output = g_object_new (GEGL_TYPE_BUFFER,
                              "source",    input,
-                             "shift-x",   (int)-matrix.coeff[0][2],
-                             "shift-y",   (int)-matrix.coeff[1][2],
+                             "shift-x",   gegl_affine_shift (matrix.coeff[0][2]),
+                             "shift-y",   gegl_affine_shift (matrix.coeff[1][2]),
                              "abyss-width", -1,  /* turn of abyss
                                                     (relying on abyss
                                                     of source) */
@@ -992,6 +1213,22 @@ gegl_affine_process (GeglOperation        *operation,
       if (input != NULL)
         g_object_unref (input);
     }
+  else if (gegl_affine_matrix3_get_quarter_turns (&matrix))
+    {
+      /* moving whole pixels around, without resampling */
+      input  = gegl_operation_context_get_source (context, "input");
+      if (!input)
+        {
+          g_warning ("transform received NULL input");
+          return FALSE;
+        }
+
+      output = gegl_operation_context_get_target (context, "output");
+
+      gegl_affine_fast_rotate (output, input, result, &matrix, context->level);
+
+      g_object_unref (input);
+    }
   else if (gegl_affine_matrix3_allow_fast_reflect_x (&matrix))
     {
       GeglRectangle      src_rect;
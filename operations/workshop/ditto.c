@@ -64,21 +64,21 @@ process (GeglOperation       *operation,
                                                   o->sampler_type);
 
   gint n_pixels = result->width * result->height;
+  gdouble *row_coords = g_new (gdouble, result->width * 2);
 
   while (n_pixels--)
     {
-      gegl_sampler_get (sampler,
-                        x,
-                        y,
-                        NULL,
-                        out_pixel);
-
-      out_pixel += 4;
+      row_coords[(x - result->x) * 2]     = x;
+      row_coords[(x - result->x) * 2 + 1] = y;
 
       /* update x and y coordinates */
       x++;
       if (x>=result->x + result->width)
         {
+          gegl_sampler_get_points (sampler, row_coords, NULL, result->width,
+                                   out_pixel);
+          out_pixel += result->width * 4;
+
           x=result->x;
           y++;
         }
@@ -87,6 +87,7 @@ process (GeglOperation       *operation,
   gegl_buffer_set (output, result, 0, babl_format ("RGBA float"), dst_buf, GEGL_AUTO_ROWSTRIDE);
   g_slice_free1 (result->width * result->height * 4 * sizeof(gfloat), dst_buf);
 
+  g_free (row_coords);
   g_object_unref (sampler);
 
   return  TRUE;
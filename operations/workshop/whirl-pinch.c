@@ -131,11 +131,17 @@ apply_whirl_pinch (gdouble whirl, gdouble pinch, gdouble radius,
   gint row, col;
   gdouble scale_x, scale_y;
   gdouble cx, cy;
+  gdouble *row_coords;
+  GeglMatrix2 *row_scales;
   GeglSampler *sampler;
 
   /* Get buffer in which to place dst pixels. */
   dst_buf = g_new0 (gfloat, roi->width * roi->height * 4);
 
+  /* Coordinates and scales of the row being sampled. */
+  row_coords = g_new (gdouble, roi->width * 2);
+  row_scales = g_new (GeglMatrix2, roi->width);
+
   whirl = whirl * G_PI / 180;
 
   scale_x = 1.0;
@@ -145,7 +151,6 @@ apply_whirl_pinch (gdouble whirl, gdouble pinch, gdouble radius,
 
   for (row = 0; row < roi->height; row++) {
     for (col = 0; col < roi->width; col++) {
-        GeglMatrix2 scale;
 #define gegl_unmap(u,v,du,dv) \
         { \
           calc_undistorted_coords (u, v,\
@@ -155,11 +160,15 @@ apply_whirl_pinch (gdouble whirl, gdouble pinch, gdouble radius,
                                    &cx, &cy);\
           du=cx;dv=cy;\
         }
-        gegl_sampler_compute_scale (scale, roi->x + col, roi->y + row);
+        gegl_sampler_compute_scale (row_scales[col], roi->x + col, roi->y + row);
         gegl_unmap (roi->x + col, roi->y + row, cx, cy);
 
-        gegl_sampler_get (sampler, cx, cy, &scale, &dst_buf[(row * roi->width + col) * 4]);
+        row_coords[col * 2]     = cx;
+        row_coords[col * 2 + 1] = cy;
     } /* for */
+
+    gegl_sampler_get_points (sampler, row_coords, row_scales, roi->width,
+                             &dst_buf[row * roi->width * 4]);
   } /* for */
 
   /* Store dst pixels. */
@@ -168,6 +177,8 @@ apply_whirl_pinch (gdouble whirl, gdouble pinch, gdouble radius,
   gegl_buffer_flush(dst);
 
   g_free (dst_buf);
+  g_free (row_coords);
+  g_free (row_scales);
   g_object_unref (sampler);
 }
 
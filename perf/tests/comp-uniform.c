@@ -0,0 +1,48 @@
+#include "test-common.h"
+
+/* Composites over buffers filled with gegl_buffer_set_color, whose tiles
+ * are uniform and can be processed as a single pixel.
+ */
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer, *buffer2;
+  GeglBuffer *bufferB;
+  GeglNode   *gegl, *sink;
+  GeglColor  *color;
+  gint i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  bufferB = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 1024, 1024),
+                             babl_format ("RGBA float"));
+  buffer  = gegl_buffer_new (GEGL_RECTANGLE (0, 0, 1024, 1024),
+                             babl_format ("RGBA float"));
+
+#define ITERATIONS 8
+  test_start ();
+  for (i=0;i< ITERATIONS;i++)
+    {
+      color = gegl_color_new ("rgba(0.2,0.4,0.6,0.5)");
+      gegl_buffer_set_color (bufferB, NULL, color);
+      g_object_unref (color);
+
+      color = gegl_color_new ("rgba(0.9,0.8,0.1,0.5)");
+      gegl_buffer_set_color (buffer, NULL, color);
+      g_object_unref (color);
+
+      gegl = gegl_graph (sink = gegl_node ("gegl:buffer-sink", "buffer", &buffer2, NULL,
+                                gegl_node ("gegl:over", NULL,
+                                gegl_node ("gegl:buffer-source", "buffer", buffer, NULL),
+                                gegl_node ("gegl:buffer-source", "buffer", bufferB, NULL))));
+
+      gegl_node_process (sink);
+      g_object_unref (gegl);
+      g_object_unref (buffer2);
+    }
+  test_end ("over-uniform", gegl_buffer_get_pixel_count (bufferB) * ITERATIONS * 16);
+  return 0;
+}
@@ -0,0 +1,32 @@
+#include "test-common.h"
+
+/* A chain of point filters, which is processed in a single pass over the
+ * pixels without buffers in between.
+ */
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer, *buffer2;
+  GeglNode   *gegl, *sink;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (1024, 1024, babl_format ("RGBA float"));
+
+  gegl = gegl_graph (sink = gegl_node ("gegl:buffer-sink", "buffer", &buffer2, NULL,
+                            gegl_node ("gegl:invert", NULL,
+                            gegl_node ("gegl:levels", "out-low", 0.1, NULL,
+                            gegl_node ("gegl:brightness-contrast", "contrast", 1.2, NULL,
+                            gegl_node ("gegl:buffer-source", "buffer", buffer, NULL))))));
+
+  test_start ();
+  gegl_node_process (sink);
+  test_end ("point-chain",  gegl_buffer_get_pixel_count (buffer) * 16);
+
+  g_object_unref (gegl);
+
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include <math.h>
+#include "test-common.h"
+
+/* Samples a slightly rotated grid with every sampler, once point by point
+ * with gegl_sampler_get and once a scanline at a time with
+ * gegl_sampler_get_span.
+ */
+
+#define SIZE 1024
+
+static const gchar *samplers[] = { "nearest", "linear", "cubic", "lohalo" };
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer  *buffer;
+  gfloat      *row;
+  const gdouble c = cos (0.07);
+  const gdouble s = sin (0.07);
+  gint         i, x, y;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+  row    = g_new (gfloat, SIZE * 4);
+
+  for (i = 0; i < G_N_ELEMENTS (samplers); i++)
+    {
+      GeglSampler *sampler;
+      gchar       *id;
+
+      sampler = gegl_buffer_sampler_new (buffer, babl_format ("RaGaBaA float"),
+                                         gegl_sampler_type_from_string (samplers[i]));
+
+      id = g_strdup_printf ("sampler-%s-get", samplers[i]);
+      test_start ();
+      for (y = 0; y < SIZE; y++)
+        for (x = 0; x < SIZE; x++)
+          gegl_sampler_get (sampler, x * c - y * s + 40.0, x * s + y * c,
+                            NULL, row + x * 4, GEGL_ABYSS_NONE);
+      test_end (id, SIZE * SIZE * 16);
+      g_free (id);
+
+      id = g_strdup_printf ("sampler-%s-span", samplers[i]);
+      test_start ();
+      for (y = 0; y < SIZE; y++)
+        gegl_sampler_get_span (sampler, - y * s + 40.0, y * c, 1.0, c, s, 0.0,
+                               SIZE, NULL, row);
+      test_end (id, SIZE * SIZE * 16);
+      g_free (id);
+
+      g_object_unref (sampler);
+    }
+
+  g_free (row);
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return 0;
+}
@@ -33,7 +33,8 @@ GeglBuffer *test_buffer (gint width,
   buffer = gegl_buffer_new (&bound, format);
   for (i=0; i < width * height * 4; i++)
     buf[i] = g_random_double_range (-0.5, 2.0);
-  gegl_buffer_set (buffer, NULL, babl_format ("RGBA float"), buf, 0);
+  gegl_buffer_set (buffer, NULL, 0, babl_format ("RGBA float"), buf,
+                   GEGL_AUTO_ROWSTRIDE);
   g_free (buf);
   return buffer;
 }
@@ -0,0 +1,63 @@
+#include "test-common.h"
+
+/* Measures how tile cache lookups scale with the number of threads, every
+ * thread reads single pixels from every tile of its own buffer, all buffers
+ * share the global tile cache.
+ */
+
+#define SIZE        1024
+#define ITERATIONS  64
+#define MAX_THREADS 8
+
+static gpointer
+read_tiles (gpointer data)
+{
+  GeglBuffer *buffer = data;
+  gfloat      pixel[4];
+  gint        i, x, y;
+
+  for (i = 0; i < ITERATIONS; i++)
+    for (y = 0; y < SIZE; y += 64)
+      for (x = 0; x < SIZE; x += 64)
+        gegl_buffer_get (buffer, GEGL_RECTANGLE (x, y, 1, 1), 1.0,
+                         babl_format ("RGBA float"), pixel,
+                         GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  return NULL;
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffers[MAX_THREADS];
+  GThread    *threads[MAX_THREADS];
+  gint        n_threads;
+  gint        i;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  for (i = 0; i < MAX_THREADS; i++)
+    buffers[i] = test_buffer (SIZE, SIZE, babl_format ("RGBA float"));
+
+  for (n_threads = 1; n_threads <= MAX_THREADS; n_threads *= 2)
+    {
+      gchar *id = g_strdup_printf ("tile-cache-contention-%i", n_threads);
+
+      test_start ();
+      for (i = 0; i < n_threads; i++)
+        threads[i] = g_thread_create (read_tiles, buffers[i], TRUE, NULL);
+      for (i = 0; i < n_threads; i++)
+        g_thread_join (threads[i]);
+      test_end (id, (glong) n_threads * ITERATIONS *
+                    (SIZE / 64) * (SIZE / 64) * 16);
+      g_free (id);
+    }
+
+  for (i = 0; i < MAX_THREADS; i++)
+    g_object_unref (buffers[i]);
+
+  gegl_exit ();
+
+  return 0;
+}
@@ -0,0 +1,32 @@
+#include "test-common.h"
+
+/* A chain of transforms, which is folded into a single resampling pass by
+ * the last transform of the chain.
+ */
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+  GeglBuffer *buffer, *buffer2;
+  GeglNode   *gegl, *sink;
+
+  g_thread_init (NULL);
+  gegl_init (&argc, &argv);
+
+  buffer = test_buffer (1024, 1024, babl_format ("RGBA float"));
+
+  gegl = gegl_graph (sink = gegl_node ("gegl:buffer-sink", "buffer", &buffer2, NULL,
+                            gegl_node ("gegl:scale", "x", 0.9, "y", 0.9, NULL,
+                            gegl_node ("gegl:rotate", "degrees", 4.0, NULL,
+                            gegl_node ("gegl:translate", "x", 10.5, "y", 3.25, NULL,
+                            gegl_node ("gegl:buffer-source", "buffer", buffer, NULL))))));
+
+  test_start ();
+  gegl_node_process (sink);
+  test_end ("transform-chain",  gegl_buffer_get_pixel_count (buffer) * 16);
+
+  g_object_unref (gegl);
+
+  return 0;
+}
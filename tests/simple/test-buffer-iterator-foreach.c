@@ -0,0 +1,157 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs the same per pixel function over a buffer with a serial
+ * gegl_buffer_iterator_next() loop and with gegl_buffer_iterator_foreach()
+ * on several threads, and checks that both give the same pixels and that
+ * every pixel is processed once.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define THREADS 4
+
+/* not aligned to the tiles, so the edge chunks are partial */
+static const GeglRectangle extent = { -13, 7, 601, 419 };
+
+static gint processed = 0;
+
+static void
+process_chunk (GeglBufferIterator *iter,
+               gpointer            user_data)
+{
+  const gfloat *in  = iter->data[1];
+  gfloat       *out = iter->data[0];
+  gint          x, y;
+
+  for (y = iter->roi[0].y; y < iter->roi[0].y + iter->roi[0].height; y++)
+    for (x = iter->roi[0].x; x < iter->roi[0].x + iter->roi[0].width; x++)
+      {
+        out[0] = in[0] * 0.5f + x;
+        out[1] = in[1] * 0.25f + y;
+        out[2] = in[0] * in[1];
+        out[3] = 1.0f;
+        in  += 4;
+        out += 4;
+      }
+
+  g_atomic_int_add (&processed, iter->length);
+}
+
+static GeglBuffer *
+create_source (void)
+{
+  GeglBuffer *buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+  gfloat     *pixels = g_new (gfloat, extent.width * extent.height * 4);
+  gint        i;
+
+  for (i = 0; i < extent.width * extent.height; i++)
+    {
+      pixels[i * 4 + 0] = (i * 7) % 31;
+      pixels[i * 4 + 1] = (i * 13) % 17;
+      pixels[i * 4 + 2] = 0.0;
+      pixels[i * 4 + 3] = 1.0;
+    }
+
+  gegl_buffer_set (buffer, &extent, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  return buffer;
+}
+
+static GeglBufferIterator *
+create_iterator (GeglBuffer *source,
+                 GeglBuffer *dest)
+{
+  GeglBufferIterator *iter;
+
+  iter = gegl_buffer_iterator_new (dest, &extent, 0, babl_format ("RGBA float"),
+                                   GEGL_BUFFER_WRITE, GEGL_ABYSS_NONE);
+  gegl_buffer_iterator_add (iter, source, &extent, 0, babl_format ("RGBA float"),
+                            GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+
+  return iter;
+}
+
+int main(int argc, char *argv[])
+{
+  gint                result = SUCCESS;
+  GeglBuffer         *source, *serial, *threaded;
+  GeglBufferIterator *iter;
+  gfloat             *serial_pixels, *threaded_pixels;
+  gint                n_pixels = extent.width * extent.height;
+
+  gegl_init (&argc, &argv);
+
+  source   = create_source ();
+  serial   = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+  threaded = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+
+  iter = create_iterator (source, serial);
+  while (gegl_buffer_iterator_next (iter))
+    process_chunk (iter, NULL);
+
+  if (processed != n_pixels)
+    {
+      g_printerr ("serial loop processed %d of %d pixels\n",
+                  processed, n_pixels);
+      result = FAILURE;
+    }
+
+  g_object_set (gegl_config (), "threads", THREADS, NULL);
+  processed = 0;
+
+  iter = create_iterator (source, threaded);
+  gegl_buffer_iterator_foreach (iter, process_chunk, NULL);
+
+  if (processed != n_pixels)
+    {
+      g_printerr ("foreach processed %d of %d pixels\n",
+                  processed, n_pixels);
+      result = FAILURE;
+    }
+
+  serial_pixels   = g_new (gfloat, n_pixels * 4);
+  threaded_pixels = g_new (gfloat, n_pixels * 4);
+  gegl_buffer_get (serial, &extent, 1.0, babl_format ("RGBA float"),
+                   serial_pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+  gegl_buffer_get (threaded, &extent, 1.0, babl_format ("RGBA float"),
+                   threaded_pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  if (memcmp (serial_pixels, threaded_pixels, n_pixels * 4 * sizeof (gfloat)))
+    {
+      g_printerr ("foreach on %d threads differs from the serial loop\n",
+                  THREADS);
+      result = FAILURE;
+    }
+
+  g_free (serial_pixels);
+  g_free (threaded_pixels);
+  g_object_unref (source);
+  g_object_unref (serial);
+  g_object_unref (threaded);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,193 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Iterates a region that is not aligned to the tiles with and without
+ * GEGL_BUFFER_STRIDED. Strided chunks have the rowstride of the tile they
+ * point into, packed chunks have rows of roi.width pixels, and walking
+ * either with its rowstride has to give the pixels of the buffer. Writes
+ * through strided chunks may only touch the region.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define BPP (4 * sizeof (gfloat))
+
+static const GeglRectangle extent = { 0, 0, 400, 300 };
+static const GeglRectangle region = { 37, 21, 250, 150 };
+
+static GeglBuffer *
+create_buffer (void)
+{
+  GeglBuffer *buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+  gfloat     *pixels = g_new (gfloat, extent.width * extent.height * 4);
+  gint        x, y;
+
+  /* every pixel holds its own coordinates */
+  for (y = 0; y < extent.height; y++)
+    for (x = 0; x < extent.width; x++)
+      {
+        gfloat *pixel = pixels + (y * extent.width + x) * 4;
+
+        pixel[0] = x;
+        pixel[1] = y;
+        pixel[2] = 0.0;
+        pixel[3] = 1.0;
+      }
+
+  gegl_buffer_set (buffer, &extent, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  return buffer;
+}
+
+static int
+test_read (GeglBuffer *buffer,
+           gboolean    strided)
+{
+  GeglBufferIterator *iter;
+  gint                tile_width;
+  gint                n_pixels = 0;
+  gint                result   = SUCCESS;
+
+  g_object_get (buffer, "tile-width", &tile_width, NULL);
+
+  iter = gegl_buffer_iterator_new (buffer, &region, 0,
+                                   babl_format ("RGBA float"),
+                                   GEGL_BUFFER_READ |
+                                   (strided ? GEGL_BUFFER_STRIDED : 0),
+                                   GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    {
+      GeglRectangle *roi = &iter->roi[0];
+      gint           expected_rowstride;
+      gint           x, y;
+
+      expected_rowstride = (strided ? tile_width : roi->width) * BPP;
+
+      if (iter->rowstride[0] != expected_rowstride)
+        {
+          g_printerr ("%s chunk at %d,%d %dx%d has rowstride %d, "
+                      "expected %d\n", strided ? "strided" : "packed",
+                      roi->x, roi->y, roi->width, roi->height,
+                      iter->rowstride[0], expected_rowstride);
+          result = FAILURE;
+        }
+
+      for (y = 0; y < roi->height && result == SUCCESS; y++)
+        {
+          gfloat *row = (gfloat *) ((guchar *) iter->data[0] +
+                                    y * iter->rowstride[0]);
+
+          for (x = 0; x < roi->width && result == SUCCESS; x++)
+            if (row[x * 4 + 0] != roi->x + x || row[x * 4 + 1] != roi->y + y)
+              {
+                g_printerr ("%s chunk: pixel %d,%d holds %g,%g\n",
+                            strided ? "strided" : "packed",
+                            roi->x + x, roi->y + y,
+                            row[x * 4 + 0], row[x * 4 + 1]);
+                result = FAILURE;
+              }
+        }
+
+      n_pixels += roi->width * roi->height;
+    }
+
+  if (result == SUCCESS && n_pixels != region.width * region.height)
+    {
+      g_printerr ("%s iteration covered %d of %d pixels\n",
+                  strided ? "strided" : "packed",
+                  n_pixels, region.width * region.height);
+      result = FAILURE;
+    }
+
+  return result;
+}
+
+static int
+test_write (GeglBuffer *buffer)
+{
+  GeglBufferIterator *iter;
+  gfloat             *pixels;
+  gint                result = SUCCESS;
+  gint                x, y;
+
+  iter = gegl_buffer_iterator_new (buffer, &region, 0,
+                                   babl_format ("RGBA float"),
+                                   GEGL_BUFFER_WRITE | GEGL_BUFFER_STRIDED,
+                                   GEGL_ABYSS_NONE);
+
+  while (gegl_buffer_iterator_next (iter))
+    for (y = 0; y < iter->roi[0].height; y++)
+      {
+        gfloat *row = (gfloat *) ((guchar *) iter->data[0] +
+                                  y * iter->rowstride[0]);
+
+        for (x = 0; x < iter->roi[0].width; x++)
+          row[x * 4 + 2] = 1.0;
+      }
+
+  pixels = g_new (gfloat, extent.width * extent.height * 4);
+  gegl_buffer_get (buffer, &extent, 1.0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < extent.height && result == SUCCESS; y++)
+    for (x = 0; x < extent.width && result == SUCCESS; x++)
+      {
+        GeglRectangle  pixel  = { x, y, 1, 1 };
+        gfloat        *p      = pixels + (y * extent.width + x) * 4;
+        gfloat         inside = gegl_rectangle_contains (&region, &pixel);
+
+        if (p[0] != x || p[1] != y || p[2] != inside)
+          {
+            g_printerr ("after a strided write pixel %d,%d is %g,%g,%g\n",
+                        x, y, p[0], p[1], p[2]);
+            result = FAILURE;
+          }
+      }
+
+  g_free (pixels);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  gint        result = SUCCESS;
+  GeglBuffer *buffer;
+
+  gegl_init (&argc, &argv);
+
+  buffer = create_buffer ();
+
+  if (result == SUCCESS)
+    result = test_read (buffer, FALSE);
+  if (result == SUCCESS)
+    result = test_read (buffer, TRUE);
+  if (result == SUCCESS)
+    result = test_write (buffer);
+
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,109 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* gegl_buffer_set_color() shares the data of one uniform tile among all
+ * the tiles it covers. Writing into one of them has to leave the others,
+ * and the rest of the written tile, filled with the color.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+static const guchar fill[4]  = { 255, 128, 0, 255 };
+static const guchar paint[4] = { 10, 20, 30, 40 };
+
+int main(int argc, char *argv[])
+{
+  gint                result = SUCCESS;
+  GeglRectangle       extent = { 0, 0, 512, 256 };
+  GeglRectangle       dot    = { 140, 70, 3, 2 };
+  GeglBuffer         *buffer;
+  GeglColor          *color;
+  GeglBufferIterator *iter;
+  guchar             *pixels;
+  guchar             *dot_pixels;
+  gint                x, y, i;
+
+  gegl_init (&argc, &argv);
+
+  buffer = gegl_buffer_new (&extent, babl_format ("R'G'B'A u8"));
+
+  color = gegl_color_new (NULL);
+  gegl_color_set_pixel (color, babl_format ("R'G'B'A u8"), fill);
+  gegl_buffer_set_color (buffer, &extent, color);
+  g_object_unref (color);
+
+  /* the tiles of the fill are read as uniform ... */
+  iter = gegl_buffer_iterator_new (buffer, &dot, 0, babl_format ("R'G'B'A u8"),
+                                   GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (iter))
+    if (!gegl_buffer_iterator_is_uniform (iter, 0))
+      {
+        g_printerr ("filled tile is not uniform\n");
+        result = FAILURE;
+      }
+
+  /* ... until one of them is written to */
+  dot_pixels = g_new (guchar, dot.width * dot.height * 4);
+  for (i = 0; i < dot.width * dot.height; i++)
+    memcpy (dot_pixels + i * 4, paint, 4);
+  gegl_buffer_set (buffer, &dot, 0, babl_format ("R'G'B'A u8"),
+                   dot_pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (dot_pixels);
+
+  iter = gegl_buffer_iterator_new (buffer, &dot, 0, babl_format ("R'G'B'A u8"),
+                                   GEGL_BUFFER_READ, GEGL_ABYSS_NONE);
+  while (gegl_buffer_iterator_next (iter))
+    if (gegl_buffer_iterator_is_uniform (iter, 0))
+      {
+        g_printerr ("written tile is still uniform\n");
+        result = FAILURE;
+      }
+
+  pixels = g_new (guchar, extent.width * extent.height * 4);
+  gegl_buffer_get (buffer, &extent, 1.0, babl_format ("R'G'B'A u8"),
+                   pixels, GEGL_AUTO_ROWSTRIDE, GEGL_ABYSS_NONE);
+
+  for (y = 0; y < extent.height && result == SUCCESS; y++)
+    for (x = 0; x < extent.width && result == SUCCESS; x++)
+      {
+        GeglRectangle  pixel    = { x, y, 1, 1 };
+        const guchar  *expected = gegl_rectangle_contains (&dot, &pixel) ?
+                                  paint : fill;
+
+        if (memcmp (pixels + (y * extent.width + x) * 4, expected, 4))
+          {
+            guchar *p = pixels + (y * extent.width + x) * 4;
+
+            g_printerr ("pixel %d,%d is %d,%d,%d,%d, expected %d,%d,%d,%d\n",
+                        x, y, p[0], p[1], p[2], p[3],
+                        expected[0], expected[1], expected[2], expected[3]);
+            result = FAILURE;
+          }
+      }
+
+  g_free (pixels);
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
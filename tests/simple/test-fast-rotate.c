@@ -0,0 +1,162 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that quarter turns, which move whole pixels without a sampler,
+ * give the pixels the nearest sampler finds at the inverse mapped pixel
+ * centres.
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define ORIGIN_X 3.0
+#define ORIGIN_Y 2.0
+
+static const GeglRectangle src_extent = { 10, 20, 7, 5 };
+
+static GeglBuffer *
+create_source (void)
+{
+  GeglBuffer *buffer = gegl_buffer_new (&src_extent,
+                                        babl_format ("RaGaBaA float"));
+  gfloat     *pixels = g_new (gfloat, src_extent.width * src_extent.height * 4);
+  gint        x, y;
+
+  /* every pixel holds its own coordinates */
+  for (y = 0; y < src_extent.height; y++)
+    for (x = 0; x < src_extent.width; x++)
+      {
+        gfloat *pixel = pixels + (y * src_extent.width + x) * 4;
+
+        pixel[0] = src_extent.x + x;
+        pixel[1] = src_extent.y + y;
+        pixel[2] = 0.0;
+        pixel[3] = 1.0;
+      }
+
+  gegl_buffer_set (buffer, &src_extent, 0, babl_format ("RaGaBaA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+  g_free (pixels);
+
+  return buffer;
+}
+
+static int
+test_quarter_turn (GeglBuffer *source,
+                   gint        degrees)
+{
+  gint           result = SUCCESS;
+  GeglNode      *graph, *buffer_source, *rotate;
+  GeglSampler   *sampler;
+  GeglMatrix3    inverse;
+  GeglRectangle  bbox;
+  gdouble        radians = degrees * G_PI / 180.0;
+  gfloat        *fast;
+  gint           x, y;
+
+  graph = gegl_node_new ();
+  buffer_source = gegl_node_new_child (graph,
+                                       "operation", "gegl:buffer-source",
+                                       "buffer",    source,
+                                       NULL);
+  rotate = gegl_node_new_child (graph,
+                                "operation", "gegl:rotate",
+                                "degrees",   (gdouble) degrees,
+                                "origin-x",  ORIGIN_X,
+                                "origin-y",  ORIGIN_Y,
+                                NULL);
+  gegl_node_link (buffer_source, rotate);
+
+  bbox = gegl_node_get_bounding_box (rotate);
+  if (bbox.width  != (degrees == 180 ? src_extent.width  : src_extent.height) ||
+      bbox.height != (degrees == 180 ? src_extent.height : src_extent.width))
+    {
+      g_printerr ("%d degrees: bounding box is %dx%d\n",
+                  degrees, bbox.width, bbox.height);
+      g_object_unref (graph);
+      return FAILURE;
+    }
+
+  fast = g_new0 (gfloat, bbox.width * bbox.height * 4);
+  gegl_node_blit (rotate, 1.0, &bbox, babl_format ("RaGaBaA float"),
+                  fast, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  /* the matrix gegl:rotate composes around its origin */
+  gegl_matrix3_identity (&inverse);
+  inverse.coeff [0][0] = inverse.coeff [1][1] = floor (cos (radians) + 0.5);
+  inverse.coeff [0][1] = floor (sin (radians) + 0.5);
+  inverse.coeff [1][0] = - inverse.coeff [0][1];
+  gegl_matrix3_originate (&inverse, ORIGIN_X, ORIGIN_Y);
+  gegl_matrix3_invert (&inverse);
+
+  sampler = gegl_buffer_sampler_new (source, babl_format ("RaGaBaA float"),
+                                     GEGL_SAMPLER_NEAREST);
+
+  for (y = 0; y < bbox.height && result == SUCCESS; y++)
+    for (x = 0; x < bbox.width && result == SUCCESS; x++)
+      {
+        gfloat  *pixel = fast + (y * bbox.width + x) * 4;
+        gfloat   expected[4];
+        gdouble  u = bbox.x + x + 0.5;
+        gdouble  v = bbox.y + y + 0.5;
+
+        gegl_matrix3_transform_point (&inverse, &u, &v);
+        gegl_sampler_get (sampler, u, v, NULL, expected, GEGL_ABYSS_NONE);
+
+        if (pixel[0] != expected[0] || pixel[1] != expected[1] ||
+            pixel[3] != 1.0)
+          {
+            g_printerr ("%d degrees: pixel %d,%d is %g,%g, expected %g,%g\n",
+                        degrees, bbox.x + x, bbox.y + y,
+                        pixel[0], pixel[1], expected[0], expected[1]);
+            result = FAILURE;
+          }
+      }
+
+  g_object_unref (sampler);
+  g_free (fast);
+  g_object_unref (graph);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  gint        result = SUCCESS;
+  GeglBuffer *source;
+
+  gegl_init (&argc, &argv);
+
+  source = create_source ();
+
+  if (result == SUCCESS)
+    result = test_quarter_turn (source, 90);
+  if (result == SUCCESS)
+    result = test_quarter_turn (source, 180);
+  if (result == SUCCESS)
+    result = test_quarter_turn (source, 270);
+
+  g_object_unref (source);
+
+  gegl_exit ();
+
+  return result;
+}
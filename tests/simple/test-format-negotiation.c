@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* gegl:opacity lists "RGBA float" in its "input-formats" key. Fed by an
+ * operation producing "RGBA float", it has to keep processing straight
+ * alpha, which keeps the color of fully transparent pixels; a round trip
+ * through "RaGaBaA float" would turn them black.
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_PIXELS 2
+
+int main(int argc, char *argv[])
+{
+  gint          result = SUCCESS;
+  GeglRectangle extent = { 0, 0, N_PIXELS, 1 };
+  gfloat        source_pixels[N_PIXELS * 4] = { 0.8, 0.6, 0.4, 0.0,
+                                                0.8, 0.6, 0.4, 0.5 };
+  gfloat        expected[N_PIXELS * 4]      = { 0.2, 0.4, 0.6, 0.0,
+                                                0.2, 0.4, 0.6, 0.25 };
+  gfloat        pixels[N_PIXELS * 4];
+  GeglBuffer   *buffer;
+  GeglNode     *graph, *source, *invert, *opacity;
+  gint          i;
+
+  gegl_init (&argc, &argv);
+
+  /* the OpenCL kernels are not negotiated */
+  g_object_set (gegl_config (), "use-opencl", FALSE, NULL);
+
+  buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, &extent, 0, babl_format ("RGBA float"),
+                   source_pixels, GEGL_AUTO_ROWSTRIDE);
+
+  graph   = gegl_node_new ();
+  source  = gegl_node_new_child (graph,
+                                 "operation", "gegl:buffer-source",
+                                 "buffer",    buffer,
+                                 NULL);
+  invert  = gegl_node_new_child (graph,
+                                 "operation", "gegl:invert",
+                                 NULL);
+  opacity = gegl_node_new_child (graph,
+                                 "operation", "gegl:opacity",
+                                 "value",     0.5,
+                                 NULL);
+  gegl_node_link_many (source, invert, opacity, NULL);
+
+  gegl_node_blit (opacity, 1.0, &extent, babl_format ("RGBA float"),
+                  pixels, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_DEFAULT);
+
+  for (i = 0; i < N_PIXELS * 4; i++)
+    if (fabs (pixels[i] - expected[i]) > 0.0001)
+      {
+        g_printerr ("component %d of pixel %d is %f, expected %f\n",
+                    i % 4, i / 4, pixels[i], expected[i]);
+        result = FAILURE;
+        break;
+      }
+
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,93 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks the output region the default get_invalidated_by_change dirties
+ * for a small change of the input: the changed region itself for a point
+ * operation, and the whole bounding box for gegl:stretch-contrast, which
+ * reads all of its input for every output pixel.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "graph/gegl-node.h"
+#include "operation/gegl-operation.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+static const GeglRectangle extent = { 0, 0, 300, 200 };
+static const GeglRectangle change = { 120, 80, 4, 3 };
+
+static int
+test_operation (GeglBuffer          *buffer,
+                const gchar         *operation,
+                const GeglRectangle *expected)
+{
+  GeglNode      *graph, *source, *node;
+  GeglRectangle  invalidated;
+  gint           result = SUCCESS;
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  node   = gegl_node_new_child (graph, "operation", operation, NULL);
+  gegl_node_link (source, node);
+
+  /* sets up the bounding boxes */
+  gegl_node_get_bounding_box (node);
+
+  invalidated = gegl_operation_get_invalidated_by_change (node->operation,
+                                                          "input", &change);
+
+  if (!gegl_rectangle_equal (&invalidated, expected))
+    {
+      g_printerr ("%s: a change of %d,%d %dx%d invalidates %d,%d %dx%d, "
+                  "expected %d,%d %dx%d\n", operation,
+                  change.x, change.y, change.width, change.height,
+                  invalidated.x, invalidated.y,
+                  invalidated.width, invalidated.height,
+                  expected->x, expected->y, expected->width, expected->height);
+      result = FAILURE;
+    }
+
+  g_object_unref (graph);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  gint        result = SUCCESS;
+  GeglBuffer *buffer;
+
+  gegl_init (&argc, &argv);
+
+  buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+
+  if (result == SUCCESS)
+    result = test_operation (buffer, "gegl:invert", &change);
+  if (result == SUCCESS)
+    result = test_operation (buffer, "gegl:stretch-contrast", &extent);
+
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
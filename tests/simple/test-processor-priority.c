@@ -0,0 +1,198 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Records the chunks a processor computes, in small chunks, and checks
+ * that they come in order of priority: getting further from the focus
+ * point, or in the order of a priority function when one is set. Every
+ * pixel of the rectangle has to be computed once.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define CHUNK_SIZE (64 * 64)
+#define MAX_STEPS  10000
+
+static const GeglRectangle extent = { 0, 0, 512, 384 };
+
+/* off center, so the order differs from the default one */
+#define FOCUS_X 400
+#define FOCUS_Y 60
+
+static void
+computed_cb (GeglNode      *node,
+             GeglRectangle *rect,
+             GArray        *chunks)
+{
+  g_array_append_val (chunks, *rect);
+}
+
+/* the squared distance from the focus to the closest pixel of rect */
+static gdouble
+focus_distance (const GeglRectangle *rect,
+                gpointer             user_data)
+{
+  gint dx = 0, dy = 0;
+
+  if (FOCUS_X < rect->x)
+    dx = rect->x - FOCUS_X;
+  else if (FOCUS_X >= rect->x + rect->width)
+    dx = FOCUS_X - (rect->x + rect->width - 1);
+
+  if (FOCUS_Y < rect->y)
+    dy = rect->y - FOCUS_Y;
+  else if (FOCUS_Y >= rect->y + rect->height)
+    dy = FOCUS_Y - (rect->y + rect->height - 1);
+
+  return (gdouble) dx * dx + (gdouble) dy * dy;
+}
+
+/* bottom rows first, the parts of a chunk never come before the chunk */
+static gdouble
+bottom_first (const GeglRectangle *rect,
+              gpointer             user_data)
+{
+  return -(rect->y + rect->height);
+}
+
+static int
+test_order (const gchar               *name,
+            GeglProcessorPriorityFunc  func,
+            GeglProcessorPriorityFunc  expected)
+{
+  GeglBuffer    *buffer;
+  GeglNode      *graph, *source, *invert;
+  GeglProcessor *processor;
+  GArray        *chunks;
+  gint          *hits;
+  gint           result = SUCCESS;
+  gint           steps  = 0;
+  guint          i;
+  gint           x, y;
+
+  buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert",
+                                NULL);
+  gegl_node_link (source, invert);
+
+  chunks = g_array_new (FALSE, FALSE, sizeof (GeglRectangle));
+  g_signal_connect (invert, "computed", G_CALLBACK (computed_cb), chunks);
+
+  processor = gegl_node_new_processor (invert, &extent);
+  g_object_set (processor, "chunksize", CHUNK_SIZE, NULL);
+
+  if (func)
+    gegl_processor_set_priority_func (processor, func, NULL, NULL);
+  else
+    gegl_processor_set_focus (processor, FOCUS_X, FOCUS_Y);
+
+  while (gegl_processor_work (processor, NULL))
+    if (++steps > MAX_STEPS)
+      {
+        g_printerr ("%s: the processor did not finish in %d steps\n",
+                    name, MAX_STEPS);
+        result = FAILURE;
+        break;
+      }
+
+  g_object_unref (processor);
+
+  if (result == SUCCESS && chunks->len < 2)
+    {
+      g_printerr ("%s: %d chunks computed, too few to have an order\n",
+                  name, chunks->len);
+      result = FAILURE;
+    }
+
+  for (i = 1; i < chunks->len && result == SUCCESS; i++)
+    {
+      GeglRectangle *prev  = &g_array_index (chunks, GeglRectangle, i - 1);
+      GeglRectangle *chunk = &g_array_index (chunks, GeglRectangle, i);
+
+      if (expected (chunk, NULL) < expected (prev, NULL))
+        {
+          g_printerr ("%s: chunk %d at %d,%d %dx%d was computed after "
+                      "%d,%d %dx%d, which comes later\n", name, i,
+                      chunk->x, chunk->y, chunk->width, chunk->height,
+                      prev->x, prev->y, prev->width, prev->height);
+          result = FAILURE;
+        }
+    }
+
+  hits = g_new0 (gint, extent.width * extent.height);
+
+  for (i = 0; i < chunks->len && result == SUCCESS; i++)
+    {
+      GeglRectangle *chunk = &g_array_index (chunks, GeglRectangle, i);
+
+      if (!gegl_rectangle_contains (&extent, chunk))
+        {
+          g_printerr ("%s: chunk %d,%d %dx%d is outside of the rectangle\n",
+                      name, chunk->x, chunk->y, chunk->width, chunk->height);
+          result = FAILURE;
+          break;
+        }
+
+      for (y = chunk->y; y < chunk->y + chunk->height; y++)
+        for (x = chunk->x; x < chunk->x + chunk->width; x++)
+          hits[(y - extent.y) * extent.width + (x - extent.x)]++;
+    }
+
+  for (i = 0; i < extent.width * extent.height && result == SUCCESS; i++)
+    if (hits[i] != 1)
+      {
+        g_printerr ("%s: pixel %d,%d was computed %d times\n", name,
+                    extent.x + i % extent.width,
+                    extent.y + i / extent.width, hits[i]);
+        result = FAILURE;
+      }
+
+  g_free (hits);
+  g_array_free (chunks, TRUE);
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  /* the chunks are computed one at a time, in the order they are taken */
+  g_object_set (gegl_config (), "threads", 1, NULL);
+
+  if (result == SUCCESS)
+    result = test_order ("focus", NULL, focus_distance);
+  if (result == SUCCESS)
+    result = test_order ("priority function", bottom_first, bottom_first);
+
+  gegl_exit ();
+
+  return result;
+}
@@ -0,0 +1,117 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs a processor through all of its preview levels on several threads,
+ * where the 1:1 size of the coarsest preview chunks does not fit in a
+ * gint, and checks that it finishes with the 1:1 result.
+ */
+
+#include "config.h"
+
+#include <math.h>
+
+#include "gegl.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define THREADS   4
+#define MAX_STEPS 10000
+
+static const GeglRectangle extent = { 0, 0, 300, 200 };
+
+int main(int argc, char *argv[])
+{
+  gint           result = SUCCESS;
+  GeglBuffer    *buffer;
+  GeglNode      *graph, *source, *invert;
+  GeglProcessor *processor;
+  GParamSpec    *pspec;
+  gfloat        *pixels;
+  gint           steps = 0;
+  gint           i;
+
+  gegl_init (&argc, &argv);
+
+  g_object_set (gegl_config (), "threads", THREADS, NULL);
+
+  pixels = g_new (gfloat, extent.width * extent.height * 4);
+  for (i = 0; i < extent.width * extent.height * 4; i++)
+    pixels[i] = (i % 97) / 96.0;
+
+  buffer = gegl_buffer_new (&extent, babl_format ("RGBA float"));
+  gegl_buffer_set (buffer, &extent, 0, babl_format ("RGBA float"),
+                   pixels, GEGL_AUTO_ROWSTRIDE);
+
+  graph  = gegl_node_new ();
+  source = gegl_node_new_child (graph,
+                                "operation", "gegl:buffer-source",
+                                "buffer",    buffer,
+                                NULL);
+  invert = gegl_node_new_child (graph,
+                                "operation", "gegl:invert",
+                                NULL);
+  gegl_node_link (source, invert);
+
+  processor = gegl_node_new_processor (invert, &extent);
+
+  /* the coarsest level there is */
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (processor),
+                                        "progressive");
+  g_object_set (processor,
+                "progressive", G_PARAM_SPEC_INT (pspec)->maximum,
+                NULL);
+
+  while (gegl_processor_work (processor, NULL))
+    if (++steps > MAX_STEPS)
+      {
+        g_printerr ("the processor did not finish in %d steps\n", MAX_STEPS);
+        result = FAILURE;
+        break;
+      }
+
+  g_object_unref (processor);
+
+  if (result == SUCCESS)
+    {
+      gfloat *rendered = g_new (gfloat, extent.width * extent.height * 4);
+
+      gegl_node_blit (invert, 1.0, &extent, babl_format ("RGBA float"),
+                      rendered, GEGL_AUTO_ROWSTRIDE, GEGL_BLIT_CACHE);
+
+      for (i = 0; i < extent.width * extent.height * 4; i++)
+        {
+          gfloat expected = i % 4 == 3 ? pixels[i] : 1.0 - pixels[i];
+
+          if (fabs (rendered[i] - expected) > 0.0001)
+            {
+              g_printerr ("component %d of pixel %d is %f, expected %f\n",
+                          i % 4, i / 4, rendered[i], expected);
+              result = FAILURE;
+              break;
+            }
+        }
+
+      g_free (rendered);
+    }
+
+  g_free (pixels);
+  g_object_unref (graph);
+  g_object_unref (buffer);
+
+  gegl_exit ();
+
+  return result;
+}
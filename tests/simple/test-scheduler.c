@@ -0,0 +1,158 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that gegl_scheduler_run() covers every pixel of a request exactly
+ * once, also when the units of a slow worker are stolen by the others, and
+ * that gegl_scheduler_run_tasks() runs every task exactly once, also when
+ * there are more tasks than threads.
+ */
+
+#include "config.h"
+
+#include "gegl.h"
+#include "gegl-types-internal.h"
+#include "graph/gegl-node.h"
+#include "process/gegl-scheduler.h"
+
+#define SUCCESS  0
+#define FAILURE -1
+
+#define N_WORKERS 4
+#define N_TASKS   (GEGL_MAX_THREADS * 3 + 1)
+
+/* not aligned to the tiles */
+static const GeglRectangle request = { -70, 33, 1000, 700 };
+
+typedef struct
+{
+  volatile gint *hits;          /* per pixel of the request */
+  volatile gint  n_units;
+  volatile gint  worker_units[N_WORKERS];
+  volatile gint  bad_worker;
+} RunData;
+
+static void
+run_unit (const GeglRectangle *unit,
+          gint                 worker,
+          gpointer             user_data)
+{
+  RunData *data = user_data;
+  gint     x, y;
+
+  if (worker < 0 || worker >= N_WORKERS)
+    {
+      g_atomic_int_inc (&data->bad_worker);
+      return;
+    }
+
+  /* the first worker is slow, the others have to steal its units */
+  if (worker == 0)
+    g_usleep (50000);
+
+  for (y = unit->y; y < unit->y + unit->height; y++)
+    for (x = unit->x; x < unit->x + unit->width; x++)
+      g_atomic_int_inc (&data->hits[(y - request.y) * request.width +
+                                    (x - request.x)]);
+
+  g_atomic_int_inc (&data->n_units);
+  g_atomic_int_inc (&data->worker_units[worker]);
+}
+
+static int
+test_run (void)
+{
+  RunData data = { 0, };
+  gint    result = SUCCESS;
+  gint    i;
+
+  data.hits = g_new0 (gint, request.width * request.height);
+
+  gegl_scheduler_run (&request, N_WORKERS, run_unit, &data);
+
+  if (data.bad_worker)
+    {
+      g_printerr ("units were run with a worker index out of range\n");
+      result = FAILURE;
+    }
+
+  for (i = 0; i < request.width * request.height && result == SUCCESS; i++)
+    if (data.hits[i] != 1)
+      {
+        g_printerr ("pixel %d,%d was rendered %d times\n",
+                    request.x + i % request.width,
+                    request.y + i / request.width, data.hits[i]);
+        result = FAILURE;
+      }
+
+  /* every worker starts with an equal share of the units */
+  if (result == SUCCESS &&
+      data.worker_units[0] * N_WORKERS >= data.n_units)
+    {
+      g_printerr ("the slow worker did %d of %d units, none were stolen\n",
+                  data.worker_units[0], data.n_units);
+      result = FAILURE;
+    }
+
+  g_free ((gpointer) data.hits);
+
+  return result;
+}
+
+static void
+run_task (gpointer task,
+          gpointer user_data)
+{
+  g_atomic_int_inc ((volatile gint *) task);
+}
+
+static int
+test_run_tasks (void)
+{
+  gint     counts[N_TASKS] = { 0, };
+  gpointer tasks[N_TASKS];
+  gint     result = SUCCESS;
+  gint     i;
+
+  for (i = 0; i < N_TASKS; i++)
+    tasks[i] = &counts[i];
+
+  gegl_scheduler_run_tasks (tasks, N_TASKS, run_task, NULL);
+
+  for (i = 0; i < N_TASKS && result == SUCCESS; i++)
+    if (counts[i] != 1)
+      {
+        g_printerr ("task %d of %d was run %d times\n",
+                    i, N_TASKS, counts[i]);
+        result = FAILURE;
+      }
+
+  return result;
+}
+
+int main(int argc, char *argv[])
+{
+  gint result = SUCCESS;
+
+  gegl_init (&argc, &argv);
+
+  if (result == SUCCESS)
+    result = test_run ();
+  if (result == SUCCESS)
+    result = test_run_tasks ();
+
+  gegl_exit ();
+
+  return result;
+}